@@ -1,13 +1,39 @@
 #include "SpoutVk.h"
+#include "SpoutVKshaders.h"
+
+// Senders of this process by name for the same process fast path
+static std::recursive_mutex localMutex;
+static std::unordered_map<std::string, spoutVK*> localSenders;
+
+// Sender textures imported by receivers of this process
+struct ImportedImage {
+	VkDevice device;
+	HANDLE shareHandle;
+	uint32_t width;
+	uint32_t height;
+	DWORD dwFormat;
+	VkImage image;
+	VkDeviceMemory memory;
+	uint32_t refs;
+};
+static std::mutex importMutex;
+static std::vector<ImportedImage> importedImages;
 
 spoutVK::spoutVK() {
 	m_pSharedTexture = nullptr;
 	m_dxShareHandle = nullptr;
+	m_ReceiverId = NewReceiverId();
 	OpenDirectX11(); // Initialize D3D11
 }
 
 spoutVK::~spoutVK()
 {
+	UnregisterLocalSender();
+	UnregisterReceiver();
+	CancelResize(nullptr);
+	ReleaseRetired(nullptr, true);
+	ReleaseLinkedPool(nullptr);
+	ReleaseMipImage(nullptr);
 	ReleaseSharedDX11texture();
 	CloseDirectX11();
 }
@@ -83,8 +109,78 @@ bool spoutVK::LinkVulkanImage(VkPhysicalDevice physicaldevice,
 	// For this example, a sender is always default
 	//   DXGI_FORMAT_B8G8R8A8_UNORM
 	//
+	// Pooled images belong to the previous device
+	if (logicaldevice != m_vkDevice) {
+		ReleaseLinkedPool(m_vkDevice);
+		ReleaseLinkedImage(m_vkDevice);
+		ReleaseRetired(m_vkDevice, true);
+	}
+
+	// Retain any previous linked image for a change back, or retire it until
+	// the frames that used it have completed. A sender has already released
+	// the texture of the previous image, so the new texture stays with the sender.
+	if (m_vkLinkedImage) {
+		ID3D11Texture2D* pTexture = m_pSharedTexture;
+		HANDLE shareHandle = m_dxShareHandle;
+		m_pSharedTexture = nullptr;
+		if (!PoolLinkedImage(logicaldevice))
+			RetireLinkedImage();
+		m_pSharedTexture = pTexture;
+		m_dxShareHandle = shareHandle;
+	}
+
+	// Retain the devices for resources created for the linked image
+	if (physicaldevice != m_vkPhysicalDevice)
+		m_FormatFeatures.clear();
+	m_vkPhysicalDevice = physicaldevice;
+	m_vkDevice = logicaldevice;
+
+	// An image already linked with this texture
+	if (AcquirePooledImage(dxShareHandle, width, height, D3D11format)) {
+		m_bInitialized = true;
+		return true;
+	}
+
+	// A receiver shares an image already imported by another receiver.
+	// A sender imports the texture that it has created.
+	if (!m_pSharedTexture) {
+		if (!AcquireImportedImage(physicaldevice, logicaldevice, dxShareHandle,
+			width, height, D3D11format))
+			return false;
+	}
+	// Import the D3D11 texture memory to a new Vulkan image
+	else {
+		if (!ImportD3D11Texture(physicaldevice, logicaldevice, dxShareHandle,
+			width, height, D3D11format, m_vkLinkedImage, m_vkImageMemory))
+			return false;
+		// The imported memory keeps the content written by DirectX.
+		// The first transition is from GENERAL so that it is preserved.
+		ResetLinkedState();
+	}
+	m_LinkedHandle = dxShareHandle;
+	m_LinkedWidth = width;
+	m_LinkedHeight = height;
+	m_LinkedFormat = D3D11format;
+	m_LinkedGeneration++;
+
+	m_bInitialized = true;
+	return true;
+
+}
+
+//
+// Create a Vulkan image and import the memory of a D3D11 texture
+// using its share handle. Used by LinkVulkanImage and spoutVKSenderPool.
+// The number of mip levels must be the same as the texture.
+//
+bool spoutVK::ImportD3D11Texture(VkPhysicalDevice physicaldevice,
+	VkDevice logicaldevice, HANDLE dxShareHandle,
+	uint32_t width, uint32_t height, DWORD D3D11format,
+	VkImage& image, VkDeviceMemory& memory, uint32_t mipLevels)
+{
 	VkFormat vulkanformat = GetVulkanFormat((DXGI_FORMAT)D3D11format);
-	ReleaseVulkanImage(logicaldevice); // Clean up any previous resources
+	image = nullptr;
+	memory = nullptr;
 
 	//
 	// Query the Vulkan driver for Direct3D image support.
@@ -110,7 +206,8 @@ bool spoutVK::LinkVulkanImage(VkPhysicalDevice physicaldevice,
 	formatInfo.format = vulkanformat;
 	formatInfo.type = VK_IMAGE_TYPE_2D;
 	formatInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-	formatInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	formatInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+		| VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 
 	VkPhysicalDeviceExternalImageFormatInfo externalFormatInfo = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_IMAGE_FORMAT_INFO };
 	externalFormatInfo.handleType = (VkExternalMemoryHandleTypeFlagBits)handleType;
@@ -124,7 +221,7 @@ bool spoutVK::LinkVulkanImage(VkPhysicalDevice physicaldevice,
 		&formatInfo,
 		&imageFormatProps2);
 	if (result != VK_SUCCESS) {
-		SpoutLogWarning("spoutVK::LinkVulkanImage - KMT handle not supported");
+		SpoutLogWarning("spoutVK::ImportD3D11Texture - KMT handle not supported");
 		return false;
 	}
 
@@ -138,7 +235,12 @@ bool spoutVK::LinkVulkanImage(VkPhysicalDevice physicaldevice,
 		externalImageFormatProps.externalMemoryProperties.externalMemoryFeatures;
 
 	if ((externalMemoryFeatures & VK_EXTERNAL_MEMORY_FEATURE_IMPORTABLE_BIT) != VK_EXTERNAL_MEMORY_FEATURE_IMPORTABLE_BIT) {
-		SpoutLogWarning("spoutVK::LinkVulkanImage - cannot import memory with this handle type");
+		SpoutLogWarning("spoutVK::ImportD3D11Texture - cannot import memory with this handle type");
+		return false;
+	}
+
+	if (mipLevels > imageFormatProps2.imageFormatProperties.maxMipLevels) {
+		SpoutLogWarning("spoutVK::ImportD3D11Texture - %u mip levels not supported", mipLevels);
 		return false;
 	}
 
@@ -164,18 +266,19 @@ bool spoutVK::LinkVulkanImage(VkPhysicalDevice physicaldevice,
 		.imageType = VK_IMAGE_TYPE_2D,
 		.format = vulkanformat,
 		.extent = { width, height, 1 },
-		.mipLevels = 1,
+		.mipLevels = mipLevels,
 		.arrayLayers = 1,
 		.samples = VK_SAMPLE_COUNT_1_BIT,
 		.tiling = VK_IMAGE_TILING_OPTIMAL,
-		.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		.usage = formatInfo.usage, // Copies, blits and the compute copy
 		.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
 		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
 	};
 
-	result = vkCreateImage(logicaldevice, &imageCreateInfo, nullptr, &m_vkLinkedImage);
+	result = vkCreateImage(logicaldevice, &imageCreateInfo, nullptr, &image);
 	if (result != VK_SUCCESS) {
-		SpoutLogWarning("spoutVK::LinkVulkanImage - could not create Vulkan image");
+		SpoutLogWarning("spoutVK::ImportD3D11Texture - could not create Vulkan image");
+		image = nullptr;
 		return false;
 	}
 
@@ -190,12 +293,14 @@ bool spoutVK::LinkVulkanImage(VkPhysicalDevice physicaldevice,
 
 	// Get memory requirements for the image
 	VkMemoryRequirements memRequirements;
-	vkGetImageMemoryRequirements(logicaldevice, m_vkLinkedImage, &memRequirements);
+	vkGetImageMemoryRequirements(logicaldevice, image, &memRequirements);
 
 	uint32_t memoryTypeIndex = findMemoryType(physicaldevice, memRequirements.memoryTypeBits,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 	if (memoryTypeIndex == UINT32_MAX) {
-		SpoutLogWarning("spoutVK::LinkVulkanImage - no suitable memory type");
+		SpoutLogWarning("spoutVK::ImportD3D11Texture - no suitable memory type");
+		vkDestroyImage(logicaldevice, image, nullptr);
+		image = nullptr;
 		return false;
 	}
 
@@ -230,7 +335,7 @@ bool spoutVK::LinkVulkanImage(VkPhysicalDevice physicaldevice,
 	VkMemoryDedicatedAllocateInfo dedicatedAllocInfo = {
 		.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
 		.pNext = &importMemoryInfo,
-		.image = m_vkLinkedImage,
+		.image = image,
 		.buffer = VK_NULL_HANDLE
 	};
 
@@ -251,142 +356,336 @@ bool spoutVK::LinkVulkanImage(VkPhysicalDevice physicaldevice,
 		.memoryTypeIndex = memoryTypeIndex
 	};
 
-	result = vkAllocateMemory(logicaldevice, &allocInfo, nullptr, &m_vkImageMemory);
+	result = vkAllocateMemory(logicaldevice, &allocInfo, nullptr, &memory);
 	if (result != VK_SUCCESS) {
-		SpoutLogWarning("spoutVK::LinkVulkanImage - could not allocate image memory");
+		SpoutLogWarning("spoutVK::ImportD3D11Texture - could not allocate image memory");
+		vkDestroyImage(logicaldevice, image, nullptr);
+		image = nullptr;
+		memory = nullptr;
 		return false;
 	}
 
 	// Bind memory to the Vulkan Image
-	result = vkBindImageMemory(logicaldevice, m_vkLinkedImage, m_vkImageMemory, 0);
+	result = vkBindImageMemory(logicaldevice, image, memory, 0);
 	if (result != VK_SUCCESS) {
-		SpoutLogWarning("spoutVK::LinkVulkanImage - could not bind image memory");
+		SpoutLogWarning("spoutVK::ImportD3D11Texture - could not bind image memory");
+		vkDestroyImage(logicaldevice, image, nullptr);
+		vkFreeMemory(logicaldevice, memory, nullptr);
+		image = nullptr;
+		memory = nullptr;
 		return false;
 	}
 
-	m_bInitialized = true;
 	return true;
+}
+
+//
+// Receivers of the same sender in this process share one imported image.
+// An image is imported for the first receiver, and the last to release it
+// destroys it once the frames that used it have completed. The image is in GENERAL layout between uses, as for
+// other processes, so receivers do not depend on each other's state.
+//
+bool spoutVK::AcquireImportedImage(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	HANDLE dxShareHandle, uint32_t width, uint32_t height, DWORD D3D11format)
+{
+	if (!dxShareHandle)
+		return false;
+
+	std::lock_guard<std::mutex> lock(importMutex);
+	for (ImportedImage& imported : importedImages) {
+		if (imported.device == logicaldevice && imported.shareHandle == dxShareHandle
+			&& imported.width == width && imported.height == height
+			&& imported.dwFormat == D3D11format) {
+			imported.refs++;
+			m_vkLinkedImage = imported.image;
+			m_vkImageMemory = imported.memory;
+			ResetLinkedState();
+			return true;
+		}
+	}
+
+	ImportedImage imported = { logicaldevice, dxShareHandle, width, height, D3D11format };
+	if (!ImportD3D11Texture(physicaldevice, logicaldevice, dxShareHandle,
+		width, height, D3D11format, imported.image, imported.memory))
+		return false;
+	imported.refs = 1;
+	importedImages.push_back(imported);
+
+	m_vkLinkedImage = imported.image;
+	m_vkImageMemory = imported.memory;
+	ResetLinkedState();
+	return true;
+}
+
+// Returns false if the image was not imported by a receiver, or this was
+// the last receiver, and the caller is responsible for releasing it
+bool spoutVK::ReleaseImportedImage(VkDevice logicaldevice, VkImage image)
+{
+	if (!image)
+		return false;
+
+	std::lock_guard<std::mutex> lock(importMutex);
+	for (auto it = importedImages.begin(); it != importedImages.end(); it++) {
+		if (it->device != logicaldevice || it->image != image)
+			continue;
+		if (--it->refs > 0)
+			return true;
+		importedImages.erase(it);
+		return false;
+	}
+	return false;
+}
 
+//
+// The linked image might have been written by another process or by
+// DirectX since it was last used. It is in GENERAL layout between uses,
+// and the state is reset so that the transition from GENERAL is always
+// recorded and makes those writes visible.
+//
+void spoutVK::ResetLinkedState()
+{
+	m_LinkedState = spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_GENERAL, true);
 }
 
 // Copy from a Vulkan image to a destination image 
 // Images sizes and formats can be different for blit copy
+//
+// If the command cache is enabled, the copy is recorded once to a secondary
+// command buffer for the images, layouts, formats and sizes. The linked image
+// is in GENERAL layout before and after the copy, so its state is not part of
+// the key. The same command buffer is executed for following frames.
+//
+// Rectangles in source image coordinates limit the copy to those regions
+// if the images are the same size. A scaled copy is of the whole image.
+// They change from frame to frame, so the copy is not cached.
+//
+// The copy is labelled if debug labels are enabled, and timed
+// without the command cache if timestamps are enabled.
+//
 void spoutVK::CopyVulkanImage(VkPhysicalDevice physicaldevice,
 	VkCommandBuffer commandBuffer,
 	VkImage srcImage, VkImageLayout srcLayout, VkFormat srcFormat,
 	VkImage dstImage, VkImageLayout dstLayout, VkFormat dstFormat,
 	uint32_t srcWidth, uint32_t srcHeight,
-	uint32_t dstWidth, uint32_t dstHeight)
+	uint32_t dstWidth, uint32_t dstHeight,
+	const VkRect2D* rects, uint32_t rectCount)
 {
-	// Transition the source image to TRANSFER_SRC_OPTIMAL layout
-	VkImageMemoryBarrier barrier{};
-	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	barrier.oldLayout = srcLayout;
-	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-	barrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-	barrier.image = srcImage; // source image
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.baseMipLevel = 0;
-	barrier.subresourceRange.levelCount = 1;
-	barrier.subresourceRange.baseArrayLayer = 0;
-	barrier.subresourceRange.layerCount = 1;
-	vkCmdPipelineBarrier(commandBuffer,
-		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-		0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-	// Transition destination image to TRANSFER_DST_OPTIMAL layout
-	barrier.oldLayout = dstLayout;
-	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-	barrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-	barrier.image = dstImage; // destination image
-	vkCmdPipelineBarrier(commandBuffer,
-		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-		0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-	// Check format support for blit
-	// Source must support VK_FORMAT_FEATURE_BLIT_SRC_BIT
-	// Destination must support VK_FORMAT_FEATURE_BLIT_DST_BIT
-	bool bBlitSupported = false;
-	VkFormatProperties props;
-	vkGetPhysicalDeviceFormatProperties(physicaldevice, srcFormat, &props);
-	if (props.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT) {
-		vkGetPhysicalDeviceFormatProperties(physicaldevice, dstFormat, &props);
-		if (props.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT) {
-			bBlitSupported = true;
+	bool bSend = (dstImage == m_vkLinkedImage);
+	bool bReceive = (srcImage == m_vkLinkedImage);
+	BeginLabel(commandBuffer, bSend ? "SpoutVK send" : (bReceive ? "SpoutVK receive" : "SpoutVK copy"));
+
+	// Only send and receive copies are measured
+	if (m_vkTimestampPool && (bSend || bReceive)) {
+		BeginTimestamps(commandBuffer);
+		RecordCopy(physicaldevice, commandBuffer,
+			srcImage, srcLayout, srcFormat, dstImage, dstLayout, dstFormat,
+			srcWidth, srcHeight, dstWidth, dstHeight, rects, rectCount);
+		EndLabel(commandBuffer);
+		return;
+	}
+
+	if (!m_bCommandCache || !m_vkCommandPool || (rects && rectCount > 0)) {
+		RecordCopy(physicaldevice, commandBuffer,
+			srcImage, srcLayout, srcFormat, dstImage, dstLayout, dstFormat,
+			srcWidth, srcHeight, dstWidth, dstHeight, rects, rectCount);
+		EndLabel(commandBuffer);
+		return;
+	}
+
+	for (const CopyCommands& cmd : m_CopyCommands) {
+		if (cmd.srcImage == srcImage && cmd.srcLayout == srcLayout && cmd.srcFormat == srcFormat
+			&& cmd.dstImage == dstImage && cmd.dstLayout == dstLayout && cmd.dstFormat == dstFormat
+			&& cmd.srcWidth == srcWidth && cmd.srcHeight == srcHeight
+			&& cmd.dstWidth == dstWidth && cmd.dstHeight == dstHeight) {
+			vkCmdExecuteCommands(commandBuffer, 1, &cmd.commandBuffer);
+			EndLabel(commandBuffer);
+			return;
 		}
 	}
 
+	// Limit the number of command buffers retained
+	if (m_CopyCommands.size() >= 16)
+		ClearCommandCache();
+
+	// Record the copy to a new secondary command buffer.
+	// It can be pending in more than one frame at the same time.
+	VkCommandBufferAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+	allocInfo.commandPool = m_vkCommandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+	allocInfo.commandBufferCount = 1;
+	VkCommandBuffer secondary = nullptr;
+	if (vkAllocateCommandBuffers(m_vkDevice, &allocInfo, &secondary) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVK::CopyVulkanImage - could not allocate command buffer");
+		RecordCopy(physicaldevice, commandBuffer,
+			srcImage, srcLayout, srcFormat, dstImage, dstLayout, dstFormat,
+			srcWidth, srcHeight, dstWidth, dstHeight);
+		EndLabel(commandBuffer);
+		return;
+	}
+
+	VkCommandBufferInheritanceInfo inheritanceInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+	vkBeginCommandBuffer(secondary, &beginInfo);
+
+	CopyCommands cmd = { srcImage, srcLayout, srcFormat, dstImage, dstLayout, dstFormat,
+		srcWidth, srcHeight, dstWidth, dstHeight };
+	RecordCopy(physicaldevice, secondary,
+		srcImage, srcLayout, srcFormat, dstImage, dstLayout, dstFormat,
+		srcWidth, srcHeight, dstWidth, dstHeight);
+	cmd.commandBuffer = secondary;
+
+	vkEndCommandBuffer(secondary);
+	m_CopyCommands.push_back(cmd);
+
+	vkCmdExecuteCommands(commandBuffer, 1, &secondary);
+	EndLabel(commandBuffer);
+}
+
+//
+// Record the copy and barriers to a command buffer
+//
+// The linked image shares memory with a D3D11 texture that other processes
+// use in GENERAL layout. It is transitioned from GENERAL for each copy and
+// returned to GENERAL after it, whatever the layout passed in.
+// Other images are transitioned from the layout passed in and returned to it.
+//
+// Blit and copy use a region for each rectangle, scaled for blit.
+// The compute shader path always converts the whole image.
+//
+void spoutVK::RecordCopy(VkPhysicalDevice physicaldevice,
+	VkCommandBuffer commandBuffer,
+	VkImage srcImage, VkImageLayout srcLayout, VkFormat srcFormat,
+	VkImage dstImage, VkImageLayout dstLayout, VkFormat dstFormat,
+	uint32_t srcWidth, uint32_t srcHeight,
+	uint32_t dstWidth, uint32_t dstHeight,
+	const VkRect2D* rects, uint32_t rectCount)
+{
+	// The whole image if no rectangles or if the image is scaled
+	VkRect2D whole = { { 0, 0 }, { srcWidth, srcHeight } };
+	if (!rects || rectCount == 0 || srcWidth != dstWidth || srcHeight != dstHeight) {
+		rects = &whole;
+		rectCount = 1;
+	}
+
+	spoutVKimageState srcImageState = spoutVKbarriers::GetLayoutState(srcLayout, true);
+	spoutVKimageState dstImageState = spoutVKbarriers::GetLayoutState(dstLayout, true);
+	spoutVKimageState& srcState = (srcImage == m_vkLinkedImage) ? m_LinkedState : srcImageState;
+	spoutVKimageState& dstState = (dstImage == m_vkLinkedImage) ? m_LinkedState : dstImageState;
+	if (srcImage == m_vkLinkedImage || dstImage == m_vkLinkedImage) {
+		srcLayout = (srcImage == m_vkLinkedImage) ? VK_IMAGE_LAYOUT_GENERAL : srcLayout;
+		dstLayout = (dstImage == m_vkLinkedImage) ? VK_IMAGE_LAYOUT_GENERAL : dstLayout;
+		ResetLinkedState();
+	}
+
+	// Check format support for blit (cached)
+	// Source must support VK_FORMAT_FEATURE_BLIT_SRC_BIT
+	// Destination must support VK_FORMAT_FEATURE_BLIT_DST_BIT
+	bool bBlitSupported = (GetFormatFeatures(physicaldevice, srcFormat) & VK_FORMAT_FEATURE_BLIT_SRC_BIT)
+		&& (GetFormatFeatures(physicaldevice, dstFormat) & VK_FORMAT_FEATURE_BLIT_DST_BIT);
+
 	//
-	// Blit if supported
-	//
-	// Blit can copy between different image sizes and
-	// Higher<>lower bit depth and Float>unorm.
-	//
-	// Success is dependent on driver support but is most likely
-	// for copy between the same format types such as BGRA<>RGBA.
-	// (see GetVulkanFormat) .
+	// If blit is not supported, use a compute shader for different sizes or formats.
+	// Copy can only be used between images of the same size and the same format.
+	// Copy between formats of the same pixel size remains as a fallback,
+	// but the channels are not converted.
 	//
-	if (bBlitSupported) {
-
-		VkImageBlit blitRegion {};
-		blitRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		blitRegion.srcSubresource.layerCount = 1;
-		blitRegion.srcOffsets[0] = { 0, 0, 0 };
-		blitRegion.srcOffsets[1] = { (int32_t)srcWidth, (int32_t)srcHeight, 1 };
-		blitRegion.dstSubresource = blitRegion.srcSubresource;
-		blitRegion.dstOffsets[0] = { 0, 0, 0 };
-		blitRegion.dstOffsets[1] = { (int32_t)dstWidth, (int32_t)dstHeight, 1 };
-		vkCmdBlitImage(commandBuffer,
-			srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-			dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			1, &blitRegion,
-			VK_FILTER_LINEAR);
+	bool bCopied = false;
+	if (!bBlitSupported && (srcWidth != dstWidth || srcHeight != dstHeight || srcFormat != dstFormat)) {
+		WriteTimestamp(commandBuffer, 1); // The compute copy records its own barriers
+		bCopied = ComputeCopy(commandBuffer,
+			srcImage, srcState, srcFormat, srcWidth, srcHeight,
+			dstImage, dstState, dstFormat, dstWidth, dstHeight);
 	}
-	else if(srcWidth == dstWidth && srcHeight == dstHeight) {
 
+	if (!bCopied) {
+
+		// Transition the source image to TRANSFER_SRC_OPTIMAL layout
+		// and the destination image to TRANSFER_DST_OPTIMAL layout
+		m_barriers.Transition(srcImage, srcState,
+			spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL));
+		m_barriers.Transition(dstImage, dstState,
+			spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+		m_barriers.Flush(commandBuffer);
+		WriteTimestamp(commandBuffer, 1);
+
+		//
+		// Blit if supported
 		//
-		// Copy if blit is not supported
-		// Source and destiation image sizes must match
-		// Formats must have the same component counts, bit depth and type
+		// Blit can copy between different image sizes and
+		// Higher<>lower bit depth and Float>unorm.
 		//
+		// Success is dependent on driver support but is most likely
+		// for copy between the same format types such as BGRA<>RGBA.
+		// (see GetVulkanFormat) .
+		//
+		if (bBlitSupported) {
 
-		// Define copy region
-		VkImageCopy copyRegion {};
-		copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		copyRegion.srcSubresource.baseArrayLayer = 0;
-		copyRegion.srcSubresource.mipLevel = 0;
-		copyRegion.srcSubresource.layerCount = 1;
-		copyRegion.dstSubresource = copyRegion.srcSubresource;
-		copyRegion.srcOffset = { 0, 0, 0 };
-		copyRegion.dstOffset = { 0, 0, 0 };
-		copyRegion.extent.width  = dstWidth;
-		copyRegion.extent.height = dstHeight;
-		copyRegion.extent.depth = 1;
-		// Copy the image
-		vkCmdCopyImage(commandBuffer,
-			srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-			dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			1, &copyRegion);
+			std::vector<VkImageBlit> blitRegions(rectCount);
+			for (uint32_t i = 0; i < rectCount; i++) {
+				const VkRect2D& rc = rects[i];
+				VkImageBlit& blitRegion = blitRegions[i];
+				blitRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				blitRegion.srcSubresource.layerCount = 1;
+				blitRegion.srcOffsets[0] = { rc.offset.x, rc.offset.y, 0 };
+				blitRegion.srcOffsets[1] = { rc.offset.x + (int32_t)rc.extent.width,
+					rc.offset.y + (int32_t)rc.extent.height, 1 };
+				blitRegion.dstSubresource = blitRegion.srcSubresource;
+				blitRegion.dstOffsets[0] = { (int32_t)((uint64_t)blitRegion.srcOffsets[0].x*dstWidth/srcWidth),
+					(int32_t)((uint64_t)blitRegion.srcOffsets[0].y*dstHeight/srcHeight), 0 };
+				blitRegion.dstOffsets[1] = { (int32_t)((uint64_t)blitRegion.srcOffsets[1].x*dstWidth/srcWidth),
+					(int32_t)((uint64_t)blitRegion.srcOffsets[1].y*dstHeight/srcHeight), 1 };
+			}
+			vkCmdBlitImage(commandBuffer,
+				srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				rectCount, blitRegions.data(),
+				VK_FILTER_LINEAR);
+		}
+		else if(srcWidth == dstWidth && srcHeight == dstHeight
+			&& GetBytesPerPixel(srcFormat) == GetBytesPerPixel(dstFormat)) {
+
+			//
+			// Copy if blit is not supported
+			// Source and destiation image sizes must match
+			// Formats must have the same component counts, bit depth and type
+			//
+
+			// Define copy regions
+			std::vector<VkImageCopy> copyRegions(rectCount);
+			for (uint32_t i = 0; i < rectCount; i++) {
+				VkImageCopy& copyRegion = copyRegions[i];
+				copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				copyRegion.srcSubresource.baseArrayLayer = 0;
+				copyRegion.srcSubresource.mipLevel = 0;
+				copyRegion.srcSubresource.layerCount = 1;
+				copyRegion.dstSubresource = copyRegion.srcSubresource;
+				copyRegion.srcOffset = { rects[i].offset.x, rects[i].offset.y, 0 };
+				copyRegion.dstOffset = copyRegion.srcOffset;
+				copyRegion.extent.width  = rects[i].extent.width;
+				copyRegion.extent.height = rects[i].extent.height;
+				copyRegion.extent.depth = 1;
+			}
+			// Copy the image
+			vkCmdCopyImage(commandBuffer,
+				srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				rectCount, copyRegions.data());
+		}
+		else if (!m_bCopyWarning) {
+			SpoutLogWarning("spoutVK::CopyVulkanImage - no copy method for these images");
+			m_bCopyWarning = true;
+		}
 	}
 
-	// Transition destination image back to dstLayout
-	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-	barrier.newLayout = dstLayout;
-	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-	barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-	barrier.image = dstImage;
-	vkCmdPipelineBarrier(commandBuffer,
-		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-		0, 0, nullptr, 0, nullptr, 1, &barrier);
+	WriteTimestamp(commandBuffer, 2);
 
-	// Transition source image back to to srcLayout
-	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-	barrier.newLayout = srcLayout;
-	vkCmdPipelineBarrier(commandBuffer,
-		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-		0, 0, nullptr, 0, nullptr, 1, &barrier);
+	// Return the source and destination images to the layouts passed in
+	m_barriers.Transition(dstImage, dstState, spoutVKbarriers::GetLayoutState(dstLayout));
+	m_barriers.Transition(srcImage, srcState, spoutVKbarriers::GetLayoutState(srcLayout));
+	m_barriers.Flush(commandBuffer);
+	WriteTimestamp(commandBuffer, 3);
 
 }
 
@@ -396,10 +695,310 @@ void spoutVK::ReleaseVulkanImage(VkDevice logicaldevice)
 	if(!logicaldevice)
 		return;
 
-	if (m_vkLinkedImage) vkDestroyImage(logicaldevice, m_vkLinkedImage, nullptr);
-	if (m_vkImageMemory) vkFreeMemory(logicaldevice, m_vkImageMemory, nullptr);
+	// Not while a receiver in the same process records a copy
+	std::lock_guard<std::recursive_mutex> localLock(localMutex);
+
+	ReleaseReadback();
+	ReleaseUpload();
+	CancelResize(logicaldevice);
+	CompleteLocalReaders(logicaldevice, m_LocalReaders, m_LocalReaderTimeout);
+	ReleaseLinkedImage(logicaldevice);
+	ReleaseLinkedPool(logicaldevice);
+	ReleaseRetired(logicaldevice, true);
+	if (m_vkRetireFence) {
+		vkDestroyFence(logicaldevice, m_vkRetireFence, nullptr);
+		m_vkRetireFence = nullptr;
+	}
+	ReleaseMipImage(logicaldevice);
+	ReleaseThumbnail(logicaldevice);
+	ReleaseTimestamps(logicaldevice);
+	ReleaseCompute();
+
+	if (m_vkAcquireSampler) {
+		vkDestroySampler(logicaldevice, m_vkAcquireSampler, nullptr);
+		m_vkAcquireSampler = nullptr;
+	}
+
+	if (m_vkCommandPool) {
+		vkDestroyCommandPool(logicaldevice, m_vkCommandPool, nullptr);
+		m_vkCommandPool = nullptr;
+	}
+	if (m_vkSubmitPool) {
+		vkDestroyCommandPool(logicaldevice, m_vkSubmitPool, nullptr);
+		m_vkSubmitPool = nullptr;
+	}
+	m_vkQueue = nullptr;
+}
+
+void spoutVK::ReleaseLinkedImage(VkDevice logicaldevice)
+{
+	if(!logicaldevice)
+		return;
+
+	// Copy commands recorded for the linked image
+	ClearCommandCache();
+
+	// Copies between the linked image and host memory
+	for (StagingSlot& slot : m_Readback) {
+		if (slot.state == SLOT_PENDING) {
+			vkWaitForFences(logicaldevice, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+			slot.state = SLOT_READY;
+		}
+	}
+	for (StagingSlot& slot : m_Upload) {
+		if (slot.state == SLOT_PENDING) {
+			vkWaitForFences(logicaldevice, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+			slot.state = SLOT_FREE;
+		}
+	}
+
+	// Frames in flight might still use the image, and a receiver's image
+	// is released by ReleaseRetired when no other receiver uses it
+	if (m_vkLinkedImage || m_vkLinkedView) {
+		Retired retired {};
+		retired.image = m_vkLinkedImage;
+		retired.memory = m_vkImageMemory;
+		retired.view = m_vkLinkedView;
+		Retire(retired);
+	}
+	m_vkLinkedView = nullptr;
+	m_vkLinkedImage = nullptr;
+	m_vkImageMemory = nullptr;
+	m_LinkedHandle = nullptr;
+}
+
+// Image view of the linked image, created when first required
+VkImageView spoutVK::GetLinkedView()
+{
+	if (!m_vkLinkedView && m_vkLinkedImage) {
+		VkImageViewCreateInfo viewInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+		viewInfo.image = m_vkLinkedImage;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = GetVulkanFormat(m_dwFormat);
+		viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		if (vkCreateImageView(m_vkDevice, &viewInfo, nullptr, &m_vkLinkedView) != VK_SUCCESS) {
+			SpoutLogWarning("spoutVK::GetLinkedView - could not create image view");
+			m_vkLinkedView = nullptr;
+		}
+	}
+	return m_vkLinkedView;
+}
+
+//
+// Linked image pool
+//
+// On a change of size or format, the linked image and its view are
+// retained with the key of the texture share handle, size and format,
+// together with the D3D11 texture for a sender. A change back acquires
+// them again without creating a texture or importing its memory.
+//
+// Pooled images are not destroyed until they are released to keep
+// within the budget, so the device only waits then.
+//
+void spoutVK::SetLinkedPoolBudget(VkDeviceSize bytes)
+{
+	m_LinkedPoolBudget = bytes;
+	TrimLinkedPool(m_vkDevice, m_LinkedPoolBudget);
+}
+
+VkDeviceSize spoutVK::GetLinkedPoolSize()
+{
+	VkDeviceSize total = 0;
+	for (const PooledImage& entry : m_LinkedPool)
+		total += entry.size;
+	return total;
+}
+
+//
+// Create a sender texture and linked image in the pool so that a later
+// change to this size and format does not create them.
+// For example the sizes of a window that is changed between modes.
+//
+bool spoutVK::PrewarmLinkedImage(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	uint32_t width, uint32_t height, VkFormat format)
+{
+	if (!CheckVulkanExtensions(physicaldevice)) {
+		SpoutLogError("spoutVK::PrewarmLinkedImage - required Vulkan extensions not supported");
+		return false;
+	}
+
+	if (!m_pD3D11Device || width == 0 || height == 0)
+		return false;
+
+	DWORD dwFormat = GetD3Dformat(format);
+	if (GetVulkanFormat(dwFormat) != format) {
+		SpoutLogWarning("spoutVK::PrewarmLinkedImage - format %d not supported", format);
+		return false;
+	}
+
+	if (m_vkDevice && m_vkDevice != logicaldevice) {
+		SpoutLogWarning("spoutVK::PrewarmLinkedImage - device is not the device of the linked image");
+		return false;
+	}
+	if (physicaldevice != m_vkPhysicalDevice)
+		m_FormatFeatures.clear();
+	m_vkPhysicalDevice = physicaldevice;
+	m_vkDevice = logicaldevice;
+
+	// The sender texture or one already pooled
+	if (m_vkLinkedImage && m_pSharedTexture && m_LinkedWidth == width
+		&& m_LinkedHeight == height && m_LinkedFormat == dwFormat)
+		return true;
+	for (const PooledImage& entry : m_LinkedPool) {
+		if (entry.texture && entry.width == width && entry.height == height && entry.dwFormat == dwFormat)
+			return true;
+	}
+
+	PooledImage entry {};
+	if (!spoutdx.CreateSharedDX11Texture(m_pD3D11Device, width, height,
+		(DXGI_FORMAT)dwFormat, &entry.texture, entry.shareHandle)) {
+		SpoutLogWarning("spoutVK::PrewarmLinkedImage - could not create texture");
+		return false;
+	}
+	if (!ImportD3D11Texture(physicaldevice, logicaldevice, entry.shareHandle,
+		width, height, dwFormat, entry.image, entry.memory)) {
+		SpoutLogWarning("spoutVK::PrewarmLinkedImage - could not link image");
+		spoutdx.ReleaseDX11Texture(entry.texture);
+		return false;
+	}
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(logicaldevice, entry.image, &memRequirements);
+	entry.width = width;
+	entry.height = height;
+	entry.dwFormat = dwFormat;
+	entry.size = memRequirements.size;
+	entry.lastUsed = ++m_LinkedPoolClock;
+	m_LinkedPool.push_back(entry);
+	TrimLinkedPool(logicaldevice, m_LinkedPoolBudget);
+
+	// Not retained if larger than the budget
+	VkImage image = entry.image;
+	return std::any_of(m_LinkedPool.begin(), m_LinkedPool.end(),
+		[image](const PooledImage& e) { return e.image == image; });
+}
+
+// Move the linked image and any sender texture to the pool.
+// Returns false if it is not retained and must be released.
+bool spoutVK::PoolLinkedImage(VkDevice logicaldevice)
+{
+	if (!m_vkLinkedImage || !logicaldevice || logicaldevice != m_vkDevice)
+		return false;
+
+	// Retired instead while receivers in this process might use it
+	if (!CompleteLocalReaders(logicaldevice, m_LocalReaders))
+		return false;
+
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(logicaldevice, m_vkLinkedImage, &memRequirements);
+	if (memRequirements.size > m_LinkedPoolBudget)
+		return false;
+
+	// Copy commands recorded for the linked image
+	ClearCommandCache();
+
+	PooledImage entry {};
+	entry.shareHandle = m_LinkedHandle;
+	entry.width = m_LinkedWidth;
+	entry.height = m_LinkedHeight;
+	entry.dwFormat = m_LinkedFormat;
+	entry.texture = m_pSharedTexture;
+	entry.image = m_vkLinkedImage;
+	entry.memory = m_vkImageMemory;
+	entry.view = m_vkLinkedView;
+	entry.size = memRequirements.size;
+	entry.lastUsed = ++m_LinkedPoolClock;
+	m_LinkedPool.push_back(entry);
+
+	// The texture now belongs to the pool
+	if (m_pSharedTexture) {
+		m_pSharedTexture = nullptr;
+		m_dxShareHandle = nullptr;
+	}
+	m_vkLinkedView = nullptr;
 	m_vkLinkedImage = nullptr;
 	m_vkImageMemory = nullptr;
+	m_LinkedHandle = nullptr;
+
+	// Older images are released if over the budget
+	TrimLinkedPool(logicaldevice, m_LinkedPoolBudget);
+
+	return true;
+}
+
+//
+// Make a pooled image the linked image.
+// A receiver finds the image linked with the sender share handle.
+// A sender (null handle) finds an image with a texture of the size and format.
+//
+bool spoutVK::AcquirePooledImage(HANDLE shareHandle, uint32_t width, uint32_t height, DWORD dwFormat)
+{
+	for (auto it = m_LinkedPool.begin(); it != m_LinkedPool.end(); it++) {
+		if (it->width != width || it->height != height || it->dwFormat != dwFormat)
+			continue;
+		if (shareHandle ? (it->texture || it->shareHandle != shareHandle) : !it->texture)
+			continue;
+
+		if (it->texture) {
+			m_pSharedTexture = it->texture;
+			m_dxShareHandle = it->shareHandle;
+		}
+		m_vkLinkedImage = it->image;
+		m_vkImageMemory = it->memory;
+		m_vkLinkedView = it->view;
+		ResetLinkedState();
+		m_LinkedHandle = it->shareHandle;
+		m_LinkedWidth = it->width;
+		m_LinkedHeight = it->height;
+		m_LinkedFormat = it->dwFormat;
+		m_LinkedGeneration++;
+		m_LinkedPool.erase(it);
+		return true;
+	}
+	return false;
+}
+
+//
+// Release the least recently used images until the pool is within the budget.
+// The device waits once before any are destroyed, because a pooled image
+// might still be used by a frame in flight.
+//
+void spoutVK::TrimLinkedPool(VkDevice logicaldevice, VkDeviceSize budget)
+{
+	if (!logicaldevice || GetLinkedPoolSize() <= budget)
+		return;
+
+	vkDeviceWaitIdle(logicaldevice);
+	while (!m_LinkedPool.empty() && GetLinkedPoolSize() > budget) {
+		auto oldest = std::min_element(m_LinkedPool.begin(), m_LinkedPool.end(),
+			[](const PooledImage& a, const PooledImage& b) { return a.lastUsed < b.lastUsed; });
+		if (oldest->view) vkDestroyImageView(logicaldevice, oldest->view, nullptr);
+		if (!ReleaseImportedImage(logicaldevice, oldest->image)) {
+			if (oldest->image) vkDestroyImage(logicaldevice, oldest->image, nullptr);
+			if (oldest->memory) vkFreeMemory(logicaldevice, oldest->memory, nullptr);
+		}
+		if (oldest->texture) spoutdx.ReleaseDX11Texture(oldest->texture);
+		m_LinkedPool.erase(oldest);
+	}
+}
+
+// Images are retired, as for ReleaseLinkedImage.
+// Vulkan resources are not released without a device.
+void spoutVK::ReleaseLinkedPool(VkDevice logicaldevice)
+{
+	for (PooledImage& entry : m_LinkedPool) {
+		if (logicaldevice) {
+			Retired retired {};
+			retired.texture = entry.texture;
+			retired.image = entry.image;
+			retired.memory = entry.memory;
+			retired.view = entry.view;
+			Retire(retired);
+		}
+		else if (entry.texture && m_pD3D11Device) {
+			spoutdx.ReleaseDX11Texture(entry.texture);
+		}
+	}
+	m_LinkedPool.clear();
 }
 
 uint32_t spoutVK::findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties)
@@ -416,33 +1015,596 @@ uint32_t spoutVK::findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeF
     return UINT32_MAX;
 }
 
-bool spoutVK::CheckVulkanExtensions(VkPhysicalDevice physicalDevice)
+uint32_t spoutVK::GetBytesPerPixel(VkFormat format)
 {
-    // Instance extensions
-    const std::vector<const char*> requiredInstanceExtensions = {
-        "VK_KHR_surface",
-        "VK_KHR_win32_surface",
-        "VK_KHR_get_physical_device_properties2"
-    };
+	switch (format) {
+		case VK_FORMAT_R8G8B8_UNORM:
+		case VK_FORMAT_B8G8R8_UNORM:
+			return 3;
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+		case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+		case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+		case VK_FORMAT_A2R10G10B10_UNORM_PACK32:
+			return 4;
+		case VK_FORMAT_R16G16B16A16_UNORM:
+		case VK_FORMAT_R16G16B16A16_SFLOAT:
+			return 8;
+		case VK_FORMAT_R32G32B32A32_SFLOAT:
+			return 16;
+		default:
+			return 0;
+	}
+}
 
-    uint32_t instanceExtCount = 0;
-    vkEnumerateInstanceExtensionProperties(nullptr, &instanceExtCount, nullptr);
-    std::vector<VkExtensionProperties> instanceExtensions(instanceExtCount);
-    vkEnumerateInstanceExtensionProperties(nullptr, &instanceExtCount, instanceExtensions.data());
+// Format features for optimal tiling are queried once for each format
+VkFormatFeatureFlags spoutVK::GetFormatFeatures(VkPhysicalDevice physicaldevice, VkFormat format)
+{
+	auto it = m_FormatFeatures.find(format);
+	if (it != m_FormatFeatures.end())
+		return it->second;
 
-    for (const char* ext : requiredInstanceExtensions) {
-        bool found = false;
-        for (const auto& available : instanceExtensions) {
-            if (strcmp(ext, available.extensionName) == 0) {
-                found = true;
-                break;
-            }
-        }
-        if (!found) {
-            SpoutLogError("spoutVK::CheckVulkanExtensions - missing instance extension: %s", ext);
-            return false;
-        }
-    }
+	VkFormatProperties props{};
+	vkGetPhysicalDeviceFormatProperties(physicaldevice, format, &props);
+	m_FormatFeatures[format] = props.optimalTilingFeatures;
+	return props.optimalTilingFeatures;
+}
+
+bool spoutVK::CreateVulkanImage(uint32_t width, uint32_t height, VkFormat format,
+	VkImageUsageFlags usage, VkImage& image, VkDeviceMemory& memory, VkImageView* view)
+{
+	VkImageCreateInfo imageCreateInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+	imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageCreateInfo.format = format;
+	imageCreateInfo.extent = { width, height, 1 };
+	imageCreateInfo.mipLevels = 1;
+	imageCreateInfo.arrayLayers = 1;
+	imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageCreateInfo.usage = usage;
+	imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	if (vkCreateImage(m_vkDevice, &imageCreateInfo, nullptr, &image) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVK::CreateVulkanImage - could not create image");
+		image = nullptr;
+		return false;
+	}
+
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(m_vkDevice, image, &memRequirements);
+	VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+	allocInfo.allocationSize = memRequirements.size;
+	allocInfo.memoryTypeIndex = findMemoryType(m_vkPhysicalDevice,
+		memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	if (allocInfo.memoryTypeIndex == UINT32_MAX
+		|| vkAllocateMemory(m_vkDevice, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVK::CreateVulkanImage - could not allocate image memory");
+		vkDestroyImage(m_vkDevice, image, nullptr);
+		image = nullptr;
+		memory = nullptr;
+		return false;
+	}
+	vkBindImageMemory(m_vkDevice, image, memory, 0);
+
+	if (view) {
+		VkImageViewCreateInfo viewInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		if (vkCreateImageView(m_vkDevice, &viewInfo, nullptr, view) != VK_SUCCESS) {
+			SpoutLogWarning("spoutVK::CreateVulkanImage - could not create image view");
+			*view = nullptr;
+		}
+	}
+
+	return true;
+}
+
+bool spoutVK::CreateVulkanBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+	VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& memory)
+{
+	VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+	bufferInfo.size = size;
+	bufferInfo.usage = usage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if (vkCreateBuffer(m_vkDevice, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVK::CreateVulkanBuffer - could not create buffer");
+		buffer = nullptr;
+		return false;
+	}
+
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements(m_vkDevice, buffer, &memRequirements);
+	VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+	allocInfo.allocationSize = memRequirements.size;
+	allocInfo.memoryTypeIndex = findMemoryType(m_vkPhysicalDevice, memRequirements.memoryTypeBits, properties);
+	if (allocInfo.memoryTypeIndex == UINT32_MAX
+		|| vkAllocateMemory(m_vkDevice, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVK::CreateVulkanBuffer - could not allocate buffer memory");
+		vkDestroyBuffer(m_vkDevice, buffer, nullptr);
+		buffer = nullptr;
+		memory = nullptr;
+		return false;
+	}
+	vkBindBufferMemory(m_vkDevice, buffer, memory, 0);
+
+	return true;
+}
+
+//
+// Staging buffer for transfers between host and device memory.
+// The buffer remains mapped and is re-created if smaller than required.
+// Readback buffers use host cached memory if available, which is
+// faster to read but may not be coherent.
+//
+bool spoutVK::CreateStagingSlot(StagingSlot& slot, VkDeviceSize size, bool bReadback)
+{
+	if (!slot.commandBuffer) {
+		VkCommandBufferAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+		allocInfo.commandPool = m_vkSubmitPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+		if (vkAllocateCommandBuffers(m_vkDevice, &allocInfo, &slot.commandBuffer) != VK_SUCCESS) {
+			SpoutLogWarning("spoutVK::CreateStagingSlot - could not allocate command buffer");
+			slot.commandBuffer = nullptr;
+			return false;
+		}
+	}
+
+	if (!slot.fence) {
+		VkFenceCreateInfo fenceInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+		if (vkCreateFence(m_vkDevice, &fenceInfo, nullptr, &slot.fence) != VK_SUCCESS) {
+			SpoutLogWarning("spoutVK::CreateStagingSlot - could not create fence");
+			slot.fence = nullptr;
+			return false;
+		}
+	}
+
+	if (slot.buffer && slot.size >= size)
+		return true;
+
+	if (slot.buffer) vkDestroyBuffer(m_vkDevice, slot.buffer, nullptr);
+	if (slot.memory) vkFreeMemory(m_vkDevice, slot.memory, nullptr);
+	slot.buffer = nullptr;
+	slot.memory = nullptr;
+	slot.mapped = nullptr;
+	slot.size = 0;
+
+	VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	if (bReadback) {
+		VkPhysicalDeviceMemoryProperties memProperties;
+		vkGetPhysicalDeviceMemoryProperties(m_vkPhysicalDevice, &memProperties);
+		for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+			if ((memProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT)
+				&& (memProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+				properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+				break;
+			}
+		}
+	}
+
+	VkBufferUsageFlags usage = bReadback ? VK_BUFFER_USAGE_TRANSFER_DST_BIT : VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	if (!CreateVulkanBuffer(size, usage, properties, slot.buffer, slot.memory))
+		return false;
+
+	if (vkMapMemory(m_vkDevice, slot.memory, 0, VK_WHOLE_SIZE, 0, &slot.mapped) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVK::CreateStagingSlot - could not map buffer memory");
+		vkDestroyBuffer(m_vkDevice, slot.buffer, nullptr);
+		vkFreeMemory(m_vkDevice, slot.memory, nullptr);
+		slot.buffer = nullptr;
+		slot.memory = nullptr;
+		slot.mapped = nullptr;
+		return false;
+	}
+	slot.size = size;
+	// Cached memory is treated as not coherent
+	slot.bCoherent = (properties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+	return true;
+}
+
+// The slot must not be pending
+void spoutVK::ReleaseStagingSlot(StagingSlot& slot)
+{
+	if (slot.commandBuffer) vkFreeCommandBuffers(m_vkDevice, m_vkSubmitPool, 1, &slot.commandBuffer);
+	if (slot.fence) vkDestroyFence(m_vkDevice, slot.fence, nullptr);
+	if (slot.buffer) vkDestroyBuffer(m_vkDevice, slot.buffer, nullptr);
+	if (slot.memory) vkFreeMemory(m_vkDevice, slot.memory, nullptr); // Unmaps the memory
+	slot = {};
+}
+
+//
+// Compute shader scale and convert
+//
+// Used when blit is not supported for the source or destination format
+// and the images differ in size or format, so that they cannot be copied.
+//
+// The source is sampled, with a box filter for large downscales, and
+// the result is written to a buffer packed for the destination format.
+// The buffer is then copied to the destination image.
+//
+// The linked image is sampled directly. Other source images may not have
+// been created for sampling and are first copied to an intermediate image.
+//
+bool spoutVK::ComputeCopy(VkCommandBuffer commandBuffer,
+	VkImage srcImage, spoutVKimageState& srcState, VkFormat srcFormat,
+	uint32_t srcWidth, uint32_t srcHeight,
+	VkImage dstImage, spoutVKimageState& dstState, VkFormat dstFormat,
+	uint32_t dstWidth, uint32_t dstHeight)
+{
+	// Destination formats packed by the shader
+	uint32_t dstCode = 0;
+	switch (dstFormat) {
+		case VK_FORMAT_R8G8B8A8_UNORM:           dstCode = 0; break;
+		case VK_FORMAT_B8G8R8A8_UNORM:           dstCode = 1; break;
+		case VK_FORMAT_A2B10G10R10_UNORM_PACK32: dstCode = 2; break;
+		case VK_FORMAT_R16G16B16A16_UNORM:       dstCode = 3; break;
+		case VK_FORMAT_R16G16B16A16_SFLOAT:      dstCode = 4; break;
+		case VK_FORMAT_R32G32B32A32_SFLOAT:      dstCode = 5; break;
+		default:
+			return false;
+	}
+
+	VkFormatFeatureFlags srcFeatures = GetFormatFeatures(m_vkPhysicalDevice, srcFormat);
+	if (!(srcFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+		return false;
+
+	if (!CreateComputePipeline())
+		return false;
+
+	//
+	// Source image to sample
+	//
+	VkImageView srcView = nullptr;
+	if (srcImage == m_vkLinkedImage) {
+		srcView = GetLinkedView();
+		if (!srcView)
+			return false;
+		m_barriers.Transition(srcImage, srcState,
+			spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL));
+	}
+	else {
+		// Intermediate image for the source size and format
+		if (!m_vkComputeInput || srcWidth != m_ComputeInputWidth
+			|| srcHeight != m_ComputeInputHeight || srcFormat != m_ComputeInputFormat) {
+			// Released when frames that used it have completed
+			if (m_vkComputeInput) {
+				Retired retired {};
+				retired.view = m_vkComputeInputView;
+				retired.image = m_vkComputeInput;
+				retired.memory = m_vkComputeInputMemory;
+				Retire(retired);
+			}
+			m_vkComputeInputView = nullptr;
+			m_vkComputeInput = nullptr;
+			m_vkComputeInputMemory = nullptr;
+			if (!CreateVulkanImage(srcWidth, srcHeight, srcFormat,
+				VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+				m_vkComputeInput, m_vkComputeInputMemory, &m_vkComputeInputView)
+				|| !m_vkComputeInputView)
+				return false;
+			m_ComputeInputWidth = srcWidth;
+			m_ComputeInputHeight = srcHeight;
+			m_ComputeInputFormat = srcFormat;
+			m_ComputeInputState = {};
+		}
+
+		m_barriers.Transition(srcImage, srcState,
+			spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL));
+		m_barriers.Transition(m_vkComputeInput, m_ComputeInputState,
+			spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+		m_barriers.Flush(commandBuffer);
+
+		VkImageCopy copyRegion {};
+		copyRegion.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		copyRegion.dstSubresource = copyRegion.srcSubresource;
+		copyRegion.extent = { srcWidth, srcHeight, 1 };
+		vkCmdCopyImage(commandBuffer,
+			srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			m_vkComputeInput, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1, &copyRegion);
+
+		m_barriers.Transition(m_vkComputeInput, m_ComputeInputState,
+			spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL));
+		srcView = m_vkComputeInputView;
+	}
+
+	//
+	// Buffer for the packed destination pixels
+	//
+	VkDeviceSize bufferSize = (VkDeviceSize)dstWidth * dstHeight * GetBytesPerPixel(dstFormat);
+	if (!m_vkComputeBuffer || bufferSize > m_ComputeBufferSize) {
+		if (m_vkComputeBuffer) {
+			Retired retired {};
+			retired.buffer = m_vkComputeBuffer;
+			retired.memory = m_vkComputeBufferMemory;
+			Retire(retired);
+		}
+		m_vkComputeBuffer = nullptr;
+		m_vkComputeBufferMemory = nullptr;
+		m_ComputeBufferSize = 0;
+		if (!CreateVulkanBuffer(bufferSize,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_vkComputeBuffer, m_vkComputeBufferMemory)) {
+			m_barriers.Flush(commandBuffer);
+			return false;
+		}
+		m_ComputeBufferSize = bufferSize;
+	}
+
+	// The last copy from the buffer must be complete before it is written
+	m_barriers.Memory(VK_PIPELINE_STAGE_2_TRANSFER_BIT, 0,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_WRITE_BIT);
+	m_barriers.Transition(dstImage, dstState,
+		spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+	m_barriers.Flush(commandBuffer);
+
+	// A new descriptor set if the source view or buffer have changed.
+	// The previous set might be used by frames in flight, so it is retired
+	// rather than updated, together with the command buffers recorded with it.
+	VkSampler sampler = (srcFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+		? m_vkSamplerLinear : m_vkSamplerNearest;
+	if (!m_vkComputeSet || srcView != m_ComputeSetView || sampler != m_ComputeSetSampler
+		|| m_vkComputeBuffer != m_ComputeSetBuffer) {
+		ClearCommandCache();
+		if (m_vkComputeSet) {
+			Retired retired {};
+			retired.set = m_vkComputeSet;
+			Retire(retired);
+			m_vkComputeSet = nullptr;
+		}
+		VkDescriptorSetAllocateInfo setInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+		setInfo.descriptorPool = m_vkComputePool;
+		setInfo.descriptorSetCount = 1;
+		setInfo.pSetLayouts = &m_vkComputeSetLayout;
+		if (vkAllocateDescriptorSets(m_vkDevice, &setInfo, &m_vkComputeSet) != VK_SUCCESS) {
+			// All sets of the pool are retired
+			ReleaseRetired(m_vkDevice, true);
+			if (vkAllocateDescriptorSets(m_vkDevice, &setInfo, &m_vkComputeSet) != VK_SUCCESS) {
+				SpoutLogWarning("spoutVK::ComputeCopy - could not allocate descriptor set");
+				m_vkComputeSet = nullptr;
+				m_ComputeSetView = nullptr;
+				return false;
+			}
+		}
+		VkDescriptorImageInfo imageInfo = { sampler, srcView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		VkDescriptorBufferInfo bufferInfo = { m_vkComputeBuffer, 0, VK_WHOLE_SIZE };
+		VkWriteDescriptorSet writes[2] = {};
+		writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[0].dstSet = m_vkComputeSet;
+		writes[0].dstBinding = 0;
+		writes[0].descriptorCount = 1;
+		writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].pImageInfo = &imageInfo;
+		writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[1].dstSet = m_vkComputeSet;
+		writes[1].dstBinding = 1;
+		writes[1].descriptorCount = 1;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[1].pBufferInfo = &bufferInfo;
+		vkUpdateDescriptorSets(m_vkDevice, 2, writes, 0, nullptr);
+		m_ComputeSetView = srcView;
+		m_ComputeSetSampler = sampler;
+		m_ComputeSetBuffer = m_vkComputeBuffer;
+	}
+
+	// Box filter taps for downscale of more than twice
+	float ratio = (std::max)((float)srcWidth / (float)dstWidth, (float)srcHeight / (float)dstHeight);
+	uint32_t taps = 1;
+	if (ratio > 2.0f)
+		taps = (std::min)((uint32_t)ceilf(ratio), 8u);
+
+	struct {
+		float srcOrigin[2];
+		float srcScale[2];
+		uint32_t dstSize[2];
+		uint32_t format;
+		uint32_t taps;
+	} params = { { 0.0f, 0.0f }, { 1.0f, 1.0f }, { dstWidth, dstHeight }, dstCode, taps };
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vkComputePipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+		m_vkComputePipelineLayout, 0, 1, &m_vkComputeSet, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, m_vkComputePipelineLayout,
+		VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+	vkCmdDispatch(commandBuffer, (dstWidth + 15) / 16, (dstHeight + 15) / 16, 1);
+
+	// Copy the packed pixels to the destination image
+	m_barriers.Memory(VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+	m_barriers.Flush(commandBuffer);
+
+	VkBufferImageCopy region {};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0; // Tightly packed
+	region.bufferImageHeight = 0;
+	region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { dstWidth, dstHeight, 1 };
+	vkCmdCopyBufferToImage(commandBuffer, m_vkComputeBuffer, dstImage,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+	return true;
+}
+
+// Create the scale and convert pipeline from the embedded shader
+bool spoutVK::CreateComputePipeline()
+{
+	if (m_vkComputePipeline)
+		return true;
+
+	if (!m_vkDevice)
+		return false;
+
+	VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	vkCreateSampler(m_vkDevice, &samplerInfo, nullptr, &m_vkSamplerLinear);
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	vkCreateSampler(m_vkDevice, &samplerInfo, nullptr, &m_vkSamplerNearest);
+
+	VkDescriptorSetLayoutBinding bindings[2] = {};
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[0].descriptorCount = 1;
+	bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	bindings[1].binding = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[1].descriptorCount = 1;
+	bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	VkDescriptorSetLayoutCreateInfo layoutInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+	layoutInfo.bindingCount = 2;
+	layoutInfo.pBindings = bindings;
+	if (vkCreateDescriptorSetLayout(m_vkDevice, &layoutInfo, nullptr, &m_vkComputeSetLayout) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVK::CreateComputePipeline - could not create descriptor set layout");
+		ReleaseCompute();
+		return false;
+	}
+
+	VkPushConstantRange pushRange = { VK_SHADER_STAGE_COMPUTE_BIT, 0, 32 };
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &m_vkComputeSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushRange;
+	if (vkCreatePipelineLayout(m_vkDevice, &pipelineLayoutInfo, nullptr, &m_vkComputePipelineLayout) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVK::CreateComputePipeline - could not create pipeline layout");
+		ReleaseCompute();
+		return false;
+	}
+
+	VkShaderModuleCreateInfo moduleInfo = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+	moduleInfo.codeSize = sizeof(spoutvk_scale_comp);
+	moduleInfo.pCode = spoutvk_scale_comp;
+	VkShaderModule shaderModule = nullptr;
+	if (vkCreateShaderModule(m_vkDevice, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVK::CreateComputePipeline - could not create shader module");
+		ReleaseCompute();
+		return false;
+	}
+
+	VkComputePipelineCreateInfo pipelineInfo = { VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = shaderModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = m_vkComputePipelineLayout;
+	VkResult result = vkCreateComputePipelines(m_vkDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_vkComputePipeline);
+	vkDestroyShaderModule(m_vkDevice, shaderModule, nullptr);
+	if (result != VK_SUCCESS) {
+		SpoutLogWarning("spoutVK::CreateComputePipeline - could not create pipeline");
+		m_vkComputePipeline = nullptr;
+		ReleaseCompute();
+		return false;
+	}
+
+	VkDescriptorPoolSize poolSizes[2] = {
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_ComputeSets },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_ComputeSets }
+	};
+	// Sets are allocated by ComputeCopy and retired when replaced
+	VkDescriptorPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+	poolInfo.maxSets = m_ComputeSets;
+	poolInfo.poolSizeCount = 2;
+	poolInfo.pPoolSizes = poolSizes;
+	if (vkCreateDescriptorPool(m_vkDevice, &poolInfo, nullptr, &m_vkComputePool) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVK::CreateComputePipeline - could not create descriptor pool");
+		ReleaseCompute();
+		return false;
+	}
+
+	SpoutLogNotice("spoutVK::CreateComputePipeline - scale and convert pipeline created");
+
+	return true;
+}
+
+void spoutVK::ReleaseCompute()
+{
+	if (!m_vkDevice)
+		return;
+
+	if (m_vkComputeBuffer) vkDestroyBuffer(m_vkDevice, m_vkComputeBuffer, nullptr);
+	if (m_vkComputeBufferMemory) vkFreeMemory(m_vkDevice, m_vkComputeBufferMemory, nullptr);
+	if (m_vkComputeInputView) vkDestroyImageView(m_vkDevice, m_vkComputeInputView, nullptr);
+	if (m_vkComputeInput) vkDestroyImage(m_vkDevice, m_vkComputeInput, nullptr);
+	if (m_vkComputeInputMemory) vkFreeMemory(m_vkDevice, m_vkComputeInputMemory, nullptr);
+	if (m_vkComputePool) vkDestroyDescriptorPool(m_vkDevice, m_vkComputePool, nullptr);
+	if (m_vkComputePipeline) vkDestroyPipeline(m_vkDevice, m_vkComputePipeline, nullptr);
+	if (m_vkComputePipelineLayout) vkDestroyPipelineLayout(m_vkDevice, m_vkComputePipelineLayout, nullptr);
+	if (m_vkComputeSetLayout) vkDestroyDescriptorSetLayout(m_vkDevice, m_vkComputeSetLayout, nullptr);
+	if (m_vkSamplerLinear) vkDestroySampler(m_vkDevice, m_vkSamplerLinear, nullptr);
+	if (m_vkSamplerNearest) vkDestroySampler(m_vkDevice, m_vkSamplerNearest, nullptr);
+
+	m_vkComputeBuffer = nullptr;
+	m_vkComputeBufferMemory = nullptr;
+	m_ComputeBufferSize = 0;
+	m_vkComputeInputView = nullptr;
+	m_vkComputeInput = nullptr;
+	m_vkComputeInputMemory = nullptr;
+	m_ComputeInputWidth = 0;
+	m_ComputeInputHeight = 0;
+	m_ComputeInputFormat = VK_FORMAT_UNDEFINED;
+	m_vkComputePool = nullptr;
+	m_vkComputeSet = nullptr;
+	m_vkComputePipeline = nullptr;
+	m_vkComputePipelineLayout = nullptr;
+	m_vkComputeSetLayout = nullptr;
+	m_vkSamplerLinear = nullptr;
+	m_vkSamplerNearest = nullptr;
+	m_ComputeSetView = nullptr;
+	m_ComputeSetSampler = nullptr;
+	m_ComputeSetBuffer = nullptr;
+}
+
+//
+// The result is retained for each physical device
+// so that the extensions are only enumerated once.
+//
+bool spoutVK::CheckVulkanExtensions(VkPhysicalDevice physicalDevice)
+{
+	static std::mutex checkMutex;
+	static std::unordered_map<VkPhysicalDevice, bool> checked;
+	std::lock_guard<std::mutex> lock(checkMutex);
+	auto it = checked.find(physicalDevice);
+	if (it != checked.end())
+		return it->second;
+	checked[physicalDevice] = false;
+
+    // Instance extensions
+    const std::vector<const char*> requiredInstanceExtensions = {
+        "VK_KHR_surface",
+        "VK_KHR_win32_surface",
+        "VK_KHR_get_physical_device_properties2"
+    };
+
+    uint32_t instanceExtCount = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &instanceExtCount, nullptr);
+    std::vector<VkExtensionProperties> instanceExtensions(instanceExtCount);
+    vkEnumerateInstanceExtensionProperties(nullptr, &instanceExtCount, instanceExtensions.data());
+
+    for (const char* ext : requiredInstanceExtensions) {
+        bool found = false;
+        for (const auto& available : instanceExtensions) {
+            if (strcmp(ext, available.extensionName) == 0) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            SpoutLogError("spoutVK::CheckVulkanExtensions - missing instance extension: %s", ext);
+            return false;
+        }
+    }
 
     // Device extensions
     const std::vector<const char*> requiredDeviceExtensions = {
@@ -472,101 +1634,389 @@ bool spoutVK::CheckVulkanExtensions(VkPhysicalDevice physicalDevice)
     }
 
 	SpoutLogNotice("spoutVK::CheckVulkanExtensions - all required extensions found");
+	checked[physicalDevice] = true;
 
     return true;
 }
 
+bool spoutVK::EnableSynchronization2(VkDevice logicaldevice, bool bEnable)
+{
+	return m_barriers.EnableSynchronization2(logicaldevice, bEnable);
+}
 
 //
-// DXGI formats supported
-//
-//	DXGI_FORMAT_B8G8R8A8_UNORM
-//	DXGI_FORMAT_R8G8B8A8_UNORM
-//  DXGI_FORMAT_R10G10B10A2_UNORM
-//	DXGI_FORMAT_R16G16B16A16_UNORM
-//	DXGI_FORMAT_R16G16B16A16_FLOAT
-//	DXGI_FORMAT_R32G32B32A32_FLOAT
+// The queue family must be that of the command buffers passed to
+// SendImage and ReceiveImage, which execute the cached command buffers.
 //
-DWORD spoutVK::GetD3Dformat(VkFormat vulkanFormat)
+bool spoutVK::EnableCommandCache(VkDevice logicaldevice, uint32_t queueFamilyIndex, bool bEnable)
 {
-	DXGI_FORMAT dxFormat;
-	switch (vulkanFormat) {
-		case DXGI_FORMAT_R8G8B8A8_UNORM: {
-			dxFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
-			break;
-		}
-		case VK_FORMAT_A2B10G10R10_UNORM_PACK32: {
-			dxFormat = DXGI_FORMAT_R10G10B10A2_UNORM;
-			break;
-		}
-		case VK_FORMAT_R16G16B16A16_UNORM: {
-			dxFormat = DXGI_FORMAT_R16G16B16A16_UNORM;
-			break;
-		}
-		case VK_FORMAT_R16G16B16A16_SFLOAT: {
-			dxFormat = DXGI_FORMAT_R16G16B16A16_FLOAT;
-			break;
-		}
-		case VK_FORMAT_R32G32B32A32_SFLOAT: {
-			dxFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;
-			break;
-		}
-		default:
-		case VK_FORMAT_B8G8R8A8_UNORM: {
-			dxFormat = DXGI_FORMAT_B8G8R8A8_UNORM;
-			break;
-		}
+	if (m_vkCommandPool) {
+		// Retired command buffers are freed before the pool
+		ClearCommandCache();
+		ReleaseRetired(logicaldevice, true);
+		vkDestroyCommandPool(logicaldevice, m_vkCommandPool, nullptr);
+		m_vkCommandPool = nullptr;
 	}
-	return (DWORD)dxFormat;
+	m_bCommandCache = false;
+
+	if (!bEnable || !logicaldevice)
+		return false;
+
+	VkCommandPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+	poolInfo.queueFamilyIndex = queueFamilyIndex;
+	if (vkCreateCommandPool(logicaldevice, &poolInfo, nullptr, &m_vkCommandPool) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVK::EnableCommandCache - could not create command pool");
+		m_vkCommandPool = nullptr;
+		return false;
+	}
+	m_vkDevice = logicaldevice;
+	m_bCommandCache = true;
+
+	return true;
 }
 
 //
-// Vulkan formats supported
-//
-//  VK_FORMAT_B8G8R8A8_UNORM            44
-//	VK_FORMAT_R8G8B8A8_UNORM            37
-//  VK_FORMAT_A2B10G10R10_UNORM_PACK32  64
-//	VK_FORMAT_R16G16B16A16_UNORM        91
-//	VK_FORMAT_R16G16B16A16_SFLOAT       97
-//	VK_FORMAT_R32G32B32A32_SFLOAT      109
+// Cached command buffers can be pending execution in frames in flight.
+// They are retired and freed when those frames have completed, so this
+// does not wait for the device.
 //
-VkFormat spoutVK::GetVulkanFormat(DWORD dwFormat)
+void spoutVK::ClearCommandCache()
 {
-	VkFormat vkFormat;
-	DXGI_FORMAT dxFormat = (DXGI_FORMAT)dwFormat;
-	switch (dxFormat) {
-		case DXGI_FORMAT_R8G8B8A8_UNORM: {
-			vkFormat = VK_FORMAT_R8G8B8A8_UNORM;
-			break;
-		}
-		case DXGI_FORMAT_R10G10B10A2_UNORM: {
-			vkFormat = VK_FORMAT_A2B10G10R10_UNORM_PACK32;
-			break;
-		}
-		case DXGI_FORMAT_R16G16B16A16_UNORM: {
-			vkFormat = VK_FORMAT_R16G16B16A16_UNORM;
-			break;
-		}
-		case DXGI_FORMAT_R16G16B16A16_FLOAT: {
-			vkFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
-			break;
-		}
-		case DXGI_FORMAT_R32G32B32A32_FLOAT: {
-			vkFormat = VK_FORMAT_R32G32B32A32_SFLOAT;
-			break;
-		}
-		default:
-		case DXGI_FORMAT_B8G8R8A8_UNORM: {
-			vkFormat = VK_FORMAT_B8G8R8A8_UNORM;
-			break;
-		}
+	for (const CopyCommands& cmd : m_CopyCommands) {
+		Retired retired {};
+		retired.commandBuffer = cmd.commandBuffer;
+		Retire(retired);
 	}
-	return vkFormat;
+	m_CopyCommands.clear();
 }
 
-bool spoutVK::SendImage(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
-	VkCommandBuffer commandbuffer, VkImage vulkanimage, VkImageLayout layout,
-	uint32_t width, uint32_t height, VkFormat format)
+//
+// Queue for copies that SpoutVK submits itself, such as ReceiveToMemory.
+// Access to the queue must be synchronized with the application,
+// so submit from the same thread.
+//
+bool spoutVK::SetVulkanQueue(VkDevice logicaldevice, VkQueue queue, uint32_t queueFamilyIndex)
+{
+	if (m_vkSubmitPool) {
+		ReleaseReadback();
+		ReleaseUpload();
+		vkDestroyCommandPool(m_vkDevice, m_vkSubmitPool, nullptr);
+		m_vkSubmitPool = nullptr;
+	}
+	m_vkQueue = nullptr;
+
+	if (!logicaldevice || !queue)
+		return false;
+
+	VkCommandPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = queueFamilyIndex;
+	if (vkCreateCommandPool(logicaldevice, &poolInfo, nullptr, &m_vkSubmitPool) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVK::SetVulkanQueue - could not create command pool");
+		m_vkSubmitPool = nullptr;
+		return false;
+	}
+	m_vkDevice = logicaldevice;
+	m_vkQueue = queue;
+	m_QueueFamilyIndex = queueFamilyIndex;
+
+	return true;
+}
+
+
+//
+// Timestamps
+//
+// Timestamps are written before the copy, after the barriers to the copy
+// layouts, after the copy and after the barriers that follow. Each copy
+// uses one slot of a ring of queries, reset in the command buffer. Results
+// are read at the next copy if available, so a slot still in use drops
+// its sample rather than waiting. A copy measured is not cached.
+// Ticks wrap at the valid bits of the queue family.
+//
+bool spoutVK::EnableTimestamps(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	uint32_t queueFamilyIndex, bool bEnable)
+{
+	ReleaseTimestamps(logicaldevice);
+
+	if (!bEnable || !physicaldevice || !logicaldevice)
+		return false;
+
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(physicaldevice, &properties);
+	if (!properties.limits.timestampComputeAndGraphics || properties.limits.timestampPeriod <= 0.0f) {
+		SpoutLogWarning("spoutVK::EnableTimestamps - timestamps not supported");
+		return false;
+	}
+
+	uint32_t familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicaldevice, &familyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> families(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicaldevice, &familyCount, families.data());
+	if (queueFamilyIndex >= familyCount || families[queueFamilyIndex].timestampValidBits == 0) {
+		SpoutLogWarning("spoutVK::EnableTimestamps - timestamps not supported by queue family %u", queueFamilyIndex);
+		return false;
+	}
+	uint32_t validBits = families[queueFamilyIndex].timestampValidBits;
+
+	VkQueryPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+	poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	poolInfo.queryCount = m_TimestampSlots*m_TimestampQueries;
+	if (vkCreateQueryPool(logicaldevice, &poolInfo, nullptr, &m_vkTimestampPool) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVK::EnableTimestamps - could not create query pool");
+		m_vkTimestampPool = nullptr;
+		return false;
+	}
+	m_vkDevice = logicaldevice;
+	m_TimestampPeriod = (double)properties.limits.timestampPeriod;
+	m_TimestampMask = (validBits >= 64) ? UINT64_MAX : ((1ull << validBits) - 1);
+
+	return true;
+}
+
+bool spoutVK::GetCopyTime(double &copytime, double &barriertime)
+{
+	if (m_CopyTimes.empty())
+		return false;
+
+	copytime = m_CopyTime;
+	barriertime = m_BarrierTime;
+	return true;
+}
+
+double spoutVK::GetCopyTimePercentile(double percentile)
+{
+	if (m_CopyTimes.empty())
+		return 0.0;
+
+	std::vector<double> times = m_CopyTimes;
+	std::sort(times.begin(), times.end());
+	percentile = std::min(std::max(percentile, 0.0), 100.0);
+	size_t index = (size_t)std::ceil(percentile/100.0*times.size());
+	return times[index > 0 ? index - 1 : 0];
+}
+
+// Read completed slots and reset the next for the copy to be recorded
+void spoutVK::BeginTimestamps(VkCommandBuffer commandBuffer)
+{
+	ReadTimestamps();
+
+	uint32_t first = m_TimestampSlot*m_TimestampQueries;
+	vkCmdResetQueryPool(commandBuffer, m_vkTimestampPool, first, m_TimestampQueries);
+	m_TimestampPending[m_TimestampSlot] = false;
+	m_TimestampQuery = 0;
+	WriteTimestamp(commandBuffer, 0);
+}
+
+// Each query is written once, in order
+void spoutVK::WriteTimestamp(VkCommandBuffer commandBuffer, uint32_t query)
+{
+	if (!m_vkTimestampPool || query != m_TimestampQuery)
+		return;
+
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		m_vkTimestampPool, m_TimestampSlot*m_TimestampQueries + query);
+	m_TimestampQuery++;
+
+	if (m_TimestampQuery == m_TimestampQueries) {
+		m_TimestampPending[m_TimestampSlot] = true;
+		m_TimestampSlot = (m_TimestampSlot + 1) % m_TimestampSlots;
+		m_TimestampQuery = UINT32_MAX;
+	}
+}
+
+// Oldest first, so that the times are those of the last copy completed
+void spoutVK::ReadTimestamps()
+{
+	for (uint32_t i = 0; i < m_TimestampSlots; i++) {
+		uint32_t slot = (m_TimestampSlot + i) % m_TimestampSlots;
+		if (!m_TimestampPending[slot])
+			continue;
+
+		uint64_t ticks[m_TimestampQueries] {};
+		if (vkGetQueryPoolResults(m_vkDevice, m_vkTimestampPool,
+			slot*m_TimestampQueries, m_TimestampQueries, sizeof(ticks), ticks,
+			sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+			continue;
+		m_TimestampPending[slot] = false;
+
+		// Differences modulo the valid bits in case the ticks wrap
+		double msec = m_TimestampPeriod/1000000.0;
+		m_BarrierTime = (double)(((ticks[1] - ticks[0]) & m_TimestampMask)
+			+ ((ticks[3] - ticks[2]) & m_TimestampMask))*msec;
+		m_CopyTime = (double)((ticks[2] - ticks[1]) & m_TimestampMask)*msec;
+
+		if (m_CopyTimes.size() < 120) {
+			m_CopyTimes.push_back(m_CopyTime);
+		}
+		else {
+			m_CopyTimes[m_CopyTimeIndex] = m_CopyTime;
+			m_CopyTimeIndex = (m_CopyTimeIndex + 1) % m_CopyTimes.size();
+		}
+	}
+}
+
+// The query pool can be in use by copies in progress
+void spoutVK::ReleaseTimestamps(VkDevice logicaldevice)
+{
+	if (m_vkTimestampPool && logicaldevice) {
+		vkDeviceWaitIdle(logicaldevice);
+		vkDestroyQueryPool(logicaldevice, m_vkTimestampPool, nullptr);
+	}
+	m_vkTimestampPool = nullptr;
+	for (bool& bPending : m_TimestampPending)
+		bPending = false;
+	m_TimestampSlot = 0;
+	m_TimestampQuery = UINT32_MAX;
+	m_CopyTime = 0.0;
+	m_BarrierTime = 0.0;
+	m_CopyTimes.clear();
+	m_CopyTimeIndex = 0;
+}
+
+//
+// Debug labels
+//
+// VK_EXT_debug_utils must be enabled for the instance.
+//
+bool spoutVK::EnableDebugLabels(VkDevice logicaldevice, bool bEnable)
+{
+	m_pfnCmdBeginDebugUtilsLabel = nullptr;
+	m_pfnCmdEndDebugUtilsLabel = nullptr;
+	if (!bEnable || !logicaldevice)
+		return false;
+
+	m_pfnCmdBeginDebugUtilsLabel = (PFN_vkCmdBeginDebugUtilsLabelEXT)vkGetDeviceProcAddr(logicaldevice, "vkCmdBeginDebugUtilsLabelEXT");
+	m_pfnCmdEndDebugUtilsLabel = (PFN_vkCmdEndDebugUtilsLabelEXT)vkGetDeviceProcAddr(logicaldevice, "vkCmdEndDebugUtilsLabelEXT");
+	if (!m_pfnCmdBeginDebugUtilsLabel || !m_pfnCmdEndDebugUtilsLabel) {
+		SpoutLogWarning("spoutVK::EnableDebugLabels - VK_EXT_debug_utils not available");
+		m_pfnCmdBeginDebugUtilsLabel = nullptr;
+		m_pfnCmdEndDebugUtilsLabel = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+void spoutVK::BeginLabel(VkCommandBuffer commandBuffer, const char* name)
+{
+	if (!m_pfnCmdBeginDebugUtilsLabel)
+		return;
+
+	VkDebugUtilsLabelEXT label = { VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT };
+	label.pLabelName = name;
+	m_pfnCmdBeginDebugUtilsLabel(commandBuffer, &label);
+}
+
+void spoutVK::EndLabel(VkCommandBuffer commandBuffer)
+{
+	if (m_pfnCmdEndDebugUtilsLabel)
+		m_pfnCmdEndDebugUtilsLabel(commandBuffer);
+}
+
+
+//
+// DXGI formats supported
+//
+//	DXGI_FORMAT_B8G8R8A8_UNORM
+//	DXGI_FORMAT_R8G8B8A8_UNORM
+//  DXGI_FORMAT_R10G10B10A2_UNORM
+//	DXGI_FORMAT_R16G16B16A16_UNORM
+//	DXGI_FORMAT_R16G16B16A16_FLOAT
+//	DXGI_FORMAT_R32G32B32A32_FLOAT
+//
+DWORD spoutVK::GetD3Dformat(VkFormat vulkanFormat)
+{
+	DXGI_FORMAT dxFormat;
+	switch (vulkanFormat) {
+		case VK_FORMAT_R8G8B8A8_UNORM: {
+			dxFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+			break;
+		}
+		case VK_FORMAT_A2B10G10R10_UNORM_PACK32: {
+			dxFormat = DXGI_FORMAT_R10G10B10A2_UNORM;
+			break;
+		}
+		case VK_FORMAT_R16G16B16A16_UNORM: {
+			dxFormat = DXGI_FORMAT_R16G16B16A16_UNORM;
+			break;
+		}
+		case VK_FORMAT_R16G16B16A16_SFLOAT: {
+			dxFormat = DXGI_FORMAT_R16G16B16A16_FLOAT;
+			break;
+		}
+		case VK_FORMAT_R32G32B32A32_SFLOAT: {
+			dxFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;
+			break;
+		}
+		default:
+		case VK_FORMAT_B8G8R8A8_UNORM: {
+			dxFormat = DXGI_FORMAT_B8G8R8A8_UNORM;
+			break;
+		}
+	}
+	return (DWORD)dxFormat;
+}
+
+//
+// Vulkan formats supported
+//
+//  VK_FORMAT_B8G8R8A8_UNORM            44
+//	VK_FORMAT_R8G8B8A8_UNORM            37
+//  VK_FORMAT_A2B10G10R10_UNORM_PACK32  64
+//	VK_FORMAT_R16G16B16A16_UNORM        91
+//	VK_FORMAT_R16G16B16A16_SFLOAT       97
+//	VK_FORMAT_R32G32B32A32_SFLOAT      109
+//
+VkFormat spoutVK::GetVulkanFormat(DWORD dwFormat)
+{
+	VkFormat vkFormat;
+	DXGI_FORMAT dxFormat = (DXGI_FORMAT)dwFormat;
+	switch (dxFormat) {
+		case DXGI_FORMAT_R8G8B8A8_UNORM: {
+			vkFormat = VK_FORMAT_R8G8B8A8_UNORM;
+			break;
+		}
+		case DXGI_FORMAT_R10G10B10A2_UNORM: {
+			vkFormat = VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+			break;
+		}
+		case DXGI_FORMAT_R16G16B16A16_UNORM: {
+			vkFormat = VK_FORMAT_R16G16B16A16_UNORM;
+			break;
+		}
+		case DXGI_FORMAT_R16G16B16A16_FLOAT: {
+			vkFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+			break;
+		}
+		case DXGI_FORMAT_R32G32B32A32_FLOAT: {
+			vkFormat = VK_FORMAT_R32G32B32A32_SFLOAT;
+			break;
+		}
+		default:
+		case DXGI_FORMAT_B8G8R8A8_UNORM: {
+			vkFormat = VK_FORMAT_B8G8R8A8_UNORM;
+			break;
+		}
+	}
+	return vkFormat;
+}
+
+//
+// Rectangles are the regions of the image changed since the last frame.
+// Only these are copied, and their union is published with the frame number
+// for receivers (GetDirtyRect). The whole image is copied if there are none,
+// if the shared texture has been re-created, or if the image is scaled to the
+// sender size. Filtered texels at the edges of a scaled region depend on
+// pixels outside it, so the region copied would not match the one published.
+//
+// The sender has the output resolution and format if set (SetOutputResolution),
+// otherwise the size and format of the image.
+//
+bool spoutVK::SendImage(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	VkCommandBuffer commandbuffer, VkImage vulkanimage, VkImageLayout layout,
+	uint32_t width, uint32_t height, VkFormat format,
+	const VkRect2D* rects, uint32_t rectCount)
 {
 	// 1) Check for required extensions
 	// 2) If not initialized
@@ -583,323 +2033,3858 @@ bool spoutVK::SendImage(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
 		return false;
 	}
 
+	// Receivers in the same process record copies from the linked image
+	std::unique_lock<std::recursive_mutex> localLock(localMutex, std::defer_lock);
+	if (m_bLocalSender)
+		localLock.lock();
+	m_bPixelSender = false;
+
+	uint32_t outWidth = width;
+	uint32_t outHeight = height;
+	VkFormat outFormat = format;
+	if (m_OutputWidth > 0 && m_OutputHeight > 0) {
+		outWidth = m_OutputWidth;
+		outHeight = m_OutputHeight;
+	}
+	if (m_OutputFormat != VK_FORMAT_UNDEFINED)
+		outFormat = m_OutputFormat;
+
+	uint32_t generation = m_LinkedGeneration;
 	if(CheckSender(physicaldevice, logicaldevice,
-		m_SenderName, width, height, GetD3Dformat(format))) {
+		m_SenderName, outWidth, outHeight, GetD3Dformat(outFormat))) {
+		// Skip the frame if no receiver is registered (SetSkipWithoutReceivers)
+		// unless a thumbnail copy is due
+		if (m_bSkipWithoutReceivers && GetReceiverCount() == 0
+			&& !(m_bThumbnail && !m_bThumbPending
+				&& std::chrono::steady_clock::now() - m_ThumbTime >= std::chrono::milliseconds(m_ThumbInterval))) {
+			m_bSkipped = true;
+			return true;
+		}
 		 // 3) Get access to the shared texture
 		if (frame.CheckAccess()) {
+			// The image is scaled and converted to the sender size and format
+			// for an output resolution, or while a resize is in progress.
+			bool bScaled = (width != m_Width || height != m_Height || GetD3Dformat(format) != m_dwFormat);
+
+			// Changed regions within the image and their union
+			VkRect2D dirty = { { 0, 0 }, { m_Width, m_Height } };
+			std::vector<VkRect2D> regions;
+			if (rects && rectCount > 0 && !bScaled && generation == m_LinkedGeneration && !m_bSkipped) {
+				int32_t x0 = (int32_t)width, y0 = (int32_t)height, x1 = 0, y1 = 0;
+				for (uint32_t i = 0; i < rectCount; i++) {
+					int32_t left   = std::max(rects[i].offset.x, 0);
+					int32_t top    = std::max(rects[i].offset.y, 0);
+					int32_t right  = (int32_t)std::min<int64_t>((int64_t)rects[i].offset.x + rects[i].extent.width, width);
+					int32_t bottom = (int32_t)std::min<int64_t>((int64_t)rects[i].offset.y + rects[i].extent.height, height);
+					if (right <= left || bottom <= top)
+						continue;
+					regions.push_back({ { left, top }, { (uint32_t)(right - left), (uint32_t)(bottom - top) } });
+					x0 = std::min(x0, left);
+					y0 = std::min(y0, top);
+					x1 = std::max(x1, right);
+					y1 = std::max(y1, bottom);
+				}
+				dirty = {};
+				if (!regions.empty())
+					dirty = { { x0, y0 }, { (uint32_t)(x1 - x0), (uint32_t)(y1 - y0) } };
+			}
+
 			// 4) Copy the image to the linked Vulkan image
 			//    to update the sender's shared texture.
-			CopyVulkanImage(physicaldevice, commandbuffer,
-				vulkanimage,                 // Sending image source
-				layout,                      // Sending image layout
-				GetVulkanFormat(m_dwFormat), // Sending image format
-				m_vkLinkedImage,             // Linked image destination
-				VK_IMAGE_LAYOUT_GENERAL,     // Linked image layout
-				GetVulkanFormat(m_dwFormat), // Linked image format
-				width, height,               // Sending image dimensions
-				width, height);              // Linked image dimensions
+			if (dirty.extent.width > 0 && dirty.extent.height > 0) {
+				CopyVulkanImage(physicaldevice, commandbuffer,
+					vulkanimage,                 // Sending image source
+					layout,                      // Sending image layout
+					bScaled ? format : GetVulkanFormat(m_dwFormat), // Sending image format
+					m_vkLinkedImage,             // Linked image destination
+					VK_IMAGE_LAYOUT_GENERAL,     // Linked image layout
+					GetVulkanFormat(m_dwFormat), // Linked image format
+					width, height,               // Sending image dimensions
+					m_Width, m_Height,           // Linked image dimensions
+					regions.data(), (uint32_t)regions.size()); // Changed regions
+				// 5) Generate the levels of the mip texture
+				if (m_MipLevels > 0 && UpdateMipImage(physicaldevice, logicaldevice))
+					GenerateMips(commandbuffer);
+			}
+			m_bSkipped = false;
 			frame.AllowAccess();
-			// 5) Signal a new frame for receivers
-			frame.SetNewFrame();
+			// 6) Signal and publish the frame
+			PublishFrame(physicaldevice, commandbuffer, dirty);
 			return true;
 		}
 	}
 	return false;
 }
 
-bool spoutVK::SetSenderName(const char* sendername)
+//
+// Zero copy send
+//
+// The linked image is returned as a colour attachment with its view,
+// so that the application renders to the sender's shared texture instead
+// of copying to it with SendImage. The named access mutex is held from
+// BeginFrame to EndFrame, and EndFrame publishes the frame.
+//
+// The sender has the output resolution and format if set. The size returned
+// can differ from that requested while a change of size is delayed
+// (EnableAsyncResize, SetResizeDebounce), so render to the size returned.
+//
+bool spoutVK::BeginFrame(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	VkCommandBuffer commandbuffer, uint32_t width, uint32_t height, VkFormat format,
+	spoutVKacquired& target)
 {
-	// Executable name default
-	if (!sendername)
-		strcpy_s(m_SenderName, 256, GetExeName().c_str());
-	else
-		strcpy_s(m_SenderName, 256, sendername);
+	if (!CheckVulkanExtensions(physicaldevice)) {
+		SpoutLogError("spoutVK::BeginFrame - required Vulkan extensions not supported");
+		return false;
+	}
 
-	// Create an incremented name if a sender with this name is already registered,
-	// Although this function precedes SpoutSenderNames::RegisterSenderName,
-	// a further increment is not applied when a sender with the new name is created.
-	char name[256]{};
-	strcpy_s(name, 256, m_SenderName);
-	if (sendernames.FindSenderName(name)) {
-		int i = 1;
-		do {
-			sprintf_s(name, 256, "%s_%d", m_SenderName, i);
-			i++;
-		} while (sendernames.FindSenderName(name));
-		// Re-set the global sender name
-		strcpy_s(m_SenderName, 256, name);
+	std::unique_lock<std::recursive_mutex> localLock(localMutex, std::defer_lock);
+	if (m_bLocalSender)
+		localLock.lock();
+	m_bPixelSender = false;
+
+	if (m_bAcquired) {
+		SpoutLogWarning("spoutVK::BeginFrame - frame not ended");
+		return false;
 	}
 
-	// Remove the sender from the names list if it's
-	// shared memory information does not exist.
-	// This can happen if the sender has crashed or if a
-	// console window was closed instead of the main program.
-	sendernames.CleanSenders();
+	if (m_OutputWidth > 0 && m_OutputHeight > 0) {
+		width = m_OutputWidth;
+		height = m_OutputHeight;
+	}
+	if (m_OutputFormat != VK_FORMAT_UNDEFINED)
+		format = m_OutputFormat;
+
+	// The shared texture has the format rendered
+	if (GetVulkanFormat(GetD3Dformat(format)) != format
+		|| !(GetFormatFeatures(physicaldevice, format) & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT)) {
+		SpoutLogWarning("spoutVK::BeginFrame - format %d not supported", format);
+		return false;
+	}
+
+	if (!CheckSender(physicaldevice, logicaldevice,
+		m_SenderName, width, height, GetD3Dformat(format)))
+		return false;
+
+	VkImageView view = GetLinkedView();
+	if (!view)
+		return false;
+
+	if (!frame.CheckAccess())
+		return false;
+	m_bAcquired = true;
+
+	spoutVKimageState renderState = spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+	ResetLinkedState();
+	m_barriers.Transition(m_vkLinkedImage, m_LinkedState, renderState);
+	m_barriers.Flush(commandbuffer);
+
+	target = {};
+	target.image = m_vkLinkedImage;
+	target.view = view;
+	target.layout = renderState.layout;
+	target.stages = renderState.stages;
+	target.access = renderState.access;
+	target.format = GetVulkanFormat(m_dwFormat);
+	target.width = m_Width;
+	target.height = m_Height;
+	target.bNewFrame = true;
 
 	return true;
 }
 
-bool spoutVK::CreateSender(std::string sendername, uint32_t width, uint32_t height, DWORD dwFormat)
+// Record after the commands that render to the image
+bool spoutVK::EndFrame(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	VkCommandBuffer commandbuffer)
 {
-	if(sendername.empty())
-		SetSenderName(); // Executable name
-	else
-		strcpy_s(m_SenderName, 256, sendername.c_str());
-
-	// Create the sender
-	if(!sendernames.CreateSender(m_SenderName, width, height, m_dxShareHandle, dwFormat)) {
-		SpoutLogWarning( "spoutVK::CreateSender - could not create sender" );
+	if (!m_bAcquired || !m_pSharedTexture)
 		return false;
+
+	std::unique_lock<std::recursive_mutex> localLock(localMutex, std::defer_lock);
+	if (m_bLocalSender)
+		localLock.lock();
+
+	// The image is returned to the layout that copies expect
+	// with the rendering available to receivers
+	m_barriers.Transition(m_vkLinkedImage, m_LinkedState,
+		spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_GENERAL));
+	m_barriers.Flush(commandbuffer);
+
+	if (m_MipLevels > 0 && UpdateMipImage(physicaldevice, logicaldevice))
+		GenerateMips(commandbuffer);
+	m_bSkipped = false;
+
+	frame.AllowAccess();
+	m_bAcquired = false;
+	PublishFrame(physicaldevice, commandbuffer, { { 0, 0 }, { m_Width, m_Height } });
+
+	return true;
+}
+
+// Signal a new frame for receivers, publish the changed region
+// and the mip texture, and copy a thumbnail at the interval
+void spoutVK::PublishFrame(VkPhysicalDevice physicaldevice, VkCommandBuffer commandbuffer, const VkRect2D& dirty)
+{
+	frame.SetNewFrame();
+
+	spoutVKinfo info{};
+	info.frame = frame.GetSenderFrame();
+	info.dirtyRect = dirty;
+	if (m_pMipTexture) {
+		info.mipLevels = (uint32_t)m_MipStates.size();
+		info.mipHandle = PtrToUint(m_MipShareHandle);
+		info.mipExtent = { m_MipWidth, m_MipHeight };
 	}
-	// Create a sender mutex for access to the shared texture
-	frame.CreateAccessMutex(m_SenderName);
+	WriteSenderInfo(info);
+
+	if (m_bThumbnail)
+		UpdateThumbnail(physicaldevice, commandbuffer);
+}
+
+//
+// Send pixels from host memory
+//
+// The pixels are copied to one of a ring of host visible buffers
+// that remain mapped, and from there to the linked image with a copy
+// submitted to the queue set by SetVulkanQueue. The caller can write the
+// next frame while the upload is in progress, and only waits if all
+// buffers of the ring are still in use.
+//
+// The format must be one of those supported for a sender.
+// Pitch is the row size in bytes and must be a multiple of the pixel size.
+//
+bool spoutVK::SendPixels(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	const void* pixels, uint32_t pitch, uint32_t width, uint32_t height, VkFormat format)
+{
+	if (!CheckVulkanExtensions(physicaldevice)) {
+		SpoutLogError("spoutVK::SendPixels - required Vulkan extensions not supported");
+		return false;
+	}
+
+	if (!m_vkQueue) {
+		SpoutLogError("spoutVK::SendPixels - queue not set");
+		return false;
+	}
+
+	if (!pixels || width == 0 || height == 0)
+		return false;
+
+	// The pixels are copied without conversion
+	uint32_t bpp = GetBytesPerPixel(format);
+	if (GetVulkanFormat(GetD3Dformat(format)) != format || bpp == 0) {
+		SpoutLogError("spoutVK::SendPixels - format %d not supported", format);
+		return false;
+	}
+	if (pitch == 0)
+		pitch = width*bpp;
+	if (pitch < width*bpp || (pitch % bpp) != 0) {
+		SpoutLogError("spoutVK::SendPixels - pitch %d not valid for width %d", pitch, width);
+		return false;
+	}
+
+	// The upload is submitted here rather than with the frame timeline that
+	// receivers in the same process wait for, so they use the shared texture
+	std::unique_lock<std::recursive_mutex> localLock(localMutex, std::defer_lock);
+	if (m_bLocalSender)
+		localLock.lock();
+	m_bPixelSender = true;
+
+	// Find completed uploads
+	for (StagingSlot& slot : m_Upload) {
+		if (slot.state == SLOT_PENDING && vkGetFenceStatus(logicaldevice, slot.fence) == VK_SUCCESS)
+			slot.state = SLOT_FREE;
+	}
+
+	// A free buffer, or a new one if less than the ring depth,
+	// otherwise wait for the oldest upload
+	StagingSlot* slot = nullptr;
+	for (StagingSlot& s : m_Upload) {
+		if (s.state == SLOT_FREE) {
+			slot = &s;
+			break;
+		}
+	}
+	if (!slot) {
+		if ((uint32_t)m_Upload.size() < m_UploadDepth) {
+			m_Upload.push_back(StagingSlot{});
+			slot = &m_Upload.back();
+		}
+		else {
+			for (StagingSlot& s : m_Upload) {
+				if (!slot || s.sequence < slot->sequence)
+					slot = &s;
+			}
+			vkWaitForFences(logicaldevice, 1, &slot->fence, VK_TRUE, UINT64_MAX);
+			slot->state = SLOT_FREE;
+		}
+	}
+
+	VkDeviceSize size = (VkDeviceSize)pitch*height;
+	if (!CreateStagingSlot(*slot, size, false))
+		return false;
+
+	// Copy the pixels with the source pitch, which the
+	// buffer to image copy then takes as the row length
+	memcpy(slot->mapped, pixels, (size_t)pitch*(height-1) + width*bpp);
+
+	if (CheckSender(physicaldevice, logicaldevice,
+		m_SenderName, width, height, GetD3Dformat(format))) {
+		// Pixels cannot be converted while an async format change is in progress
+		if (GetD3Dformat(format) != m_dwFormat)
+			return false;
+		if (frame.CheckAccess()) {
+			// Copies recorded by local receivers before they changed to the shared texture
+			CompleteLocalReaders(logicaldevice, m_LocalReaders, m_LocalReaderTimeout);
+
+			VkCommandBuffer cmd = slot->commandBuffer;
+			vkResetCommandBuffer(cmd, 0);
+			VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			vkBeginCommandBuffer(cmd, &beginInfo);
+
+			ResetLinkedState();
+			m_barriers.Transition(m_vkLinkedImage, m_LinkedState,
+				spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+			m_barriers.Flush(cmd);
+
+			// While an async resize is in progress the pixels
+			// are cropped to the current sender size
+			VkBufferImageCopy region{};
+			region.bufferRowLength = pitch/bpp;
+			region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+			region.imageExtent = { (std::min)(width, m_Width), (std::min)(height, m_Height), 1 };
+			vkCmdCopyBufferToImage(cmd, slot->buffer, m_vkLinkedImage,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+			m_barriers.Transition(m_vkLinkedImage, m_LinkedState,
+				spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_GENERAL));
+			m_barriers.Flush(cmd);
+			vkEndCommandBuffer(cmd);
+
+			// Host writes to coherent memory are visible to the submitted copy
+			vkResetFences(logicaldevice, 1, &slot->fence);
+			VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &cmd;
+			bool bSubmitted = (vkQueueSubmit(m_vkQueue, 1, &submitInfo, slot->fence) == VK_SUCCESS);
+			frame.AllowAccess();
+
+			if (!bSubmitted) {
+				SpoutLogWarning("spoutVK::SendPixels - could not submit copy");
+				return false;
+			}
+			slot->state = SLOT_PENDING;
+			slot->sequence = ++m_UploadSequence;
+			slot->width = width;
+			slot->height = height;
+			slot->pitch = pitch;
+			slot->format = format;
+
+			// Signal a new frame for receivers
+			frame.SetNewFrame();
+			return true;
+		}
+	}
+	return false;
+}
+
+// Waits for uploads in progress
+void spoutVK::ReleaseUpload()
+{
+	for (StagingSlot& slot : m_Upload) {
+		if (slot.state == SLOT_PENDING)
+			vkWaitForFences(m_vkDevice, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+		ReleaseStagingSlot(slot);
+	}
+	m_Upload.clear();
+	m_UploadSequence = 0;
+}
+
+bool spoutVK::SetSenderName(const char* sendername)
+{
+	// Executable name default
+	if (!sendername)
+		strcpy_s(m_SenderName, 256, GetExeName().c_str());
+	else
+		strcpy_s(m_SenderName, 256, sendername);
+
+	// Create an incremented name if a sender with this name is already registered,
+	// Although this function precedes SpoutSenderNames::RegisterSenderName,
+	// a further increment is not applied when a sender with the new name is created.
+	char name[256]{};
+	strcpy_s(name, 256, m_SenderName);
+	if (sendernames.FindSenderName(name)) {
+		int i = 1;
+		do {
+			sprintf_s(name, 256, "%s_%d", m_SenderName, i);
+			i++;
+		} while (sendernames.FindSenderName(name));
+		// Re-set the global sender name
+		strcpy_s(m_SenderName, 256, name);
+	}
+
+	// Remove the sender from the names list if it's
+	// shared memory information does not exist.
+	// This can happen if the sender has crashed or if a
+	// console window was closed instead of the main program.
+	sendernames.CleanSenders();
+
+	return true;
+}
+
+bool spoutVK::CreateSender(std::string sendername, uint32_t width, uint32_t height, DWORD dwFormat)
+{
+	if(sendername.empty())
+		SetSenderName(); // Executable name
+	else
+		strcpy_s(m_SenderName, 256, sendername.c_str());
+
+	// Create the sender
+	if(!sendernames.CreateSender(m_SenderName, width, height, m_dxShareHandle, dwFormat)) {
+		SpoutLogWarning( "spoutVK::CreateSender - could not create sender" );
+		return false;
+	}
+	// Create a sender mutex for access to the shared texture
+	frame.CreateAccessMutex(m_SenderName);
+
+	// Enable frame counting so the receiver gets frame number and fps
+	frame.EnableFrameCount(m_SenderName);
+
+	// Update globals
+	m_Width = width;
+	m_Height = height;
+	m_dwFormat = dwFormat;
+
+	// SpoutVK sender information
+	CreateSenderInfo();
+
+	// Receivers in the same process
+	RegisterLocalSender();
+
+	return true;
+}
+
+// o Create a DirectX11 shared texture and share handle.
+// o Create a Vulkan image and link with the DirectX11 memory
+//   using the texture share handle
+// o Create a sender
+// o For a size change, update images and the sender
+bool spoutVK::CheckSender(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	std::string sendername, uint32_t width, uint32_t height, DWORD dwFormat)
+{
+	// Objects replaced by the sender are released after frames in flight
+	m_SenderFrames++;
+	if (!m_Retired.empty())
+		ReleaseRetired(logicaldevice, false);
+
+	if (!m_bInitialized) {
+		// Use a texture and linked image created by PrewarmLinkedImage,
+		// or create a D3D11 shared texture with a share handle (m_dxShareHandle)
+		// that will be used to link the texture with a Vulkan Image
+		bool bLinked = logicaldevice == m_vkDevice && !m_vkLinkedImage
+			&& AcquirePooledImage(nullptr, width, height, dwFormat);
+		if (bLinked || CreateSharedDX11texture(width, height, dwFormat)) {
+			// Create a Vulkan image and link with the D3D11 texture memory
+			if (bLinked || LinkVulkanImage(physicaldevice, logicaldevice,
+				m_dxShareHandle, width, height, dwFormat)) {
+				// Create a sender using the shared texure handle
+				// which is linked to the Vulkan image
+				CreateSender(sendername.c_str(), width, height, dwFormat);
+				m_bInitialized = true;
+			}
+		}
+	}
+	else if (width != m_Width || height != m_Height || dwFormat != m_dwFormat) {
+		//
+		// With resize debounce, the new size is only used when it has not
+		// changed for the debounce interval. Each size that changes again
+		// before then is a re-link avoided for the sender and its receivers.
+		//
+		if (m_ResizeDebounce > 0 && m_vkLinkedImage) {
+			auto now = std::chrono::steady_clock::now();
+			if (width != m_DebounceWidth || height != m_DebounceHeight || dwFormat != m_DebounceFormat) {
+				if (m_DebounceWidth > 0)
+					m_RelinksAvoided++;
+				m_DebounceWidth = width;
+				m_DebounceHeight = height;
+				m_DebounceFormat = dwFormat;
+				m_DebounceStart = now;
+			}
+			if (now - m_DebounceStart < std::chrono::milliseconds(m_ResizeDebounce))
+				return true;
+		}
+
+		//
+		// With async resize, the texture and linked image for the new size
+		// are created on a worker thread unless they are pooled. Frames are
+		// scaled to the current size until they are ready, and the sender
+		// is then updated with the new texture in one step.
+		//
+		bool bPooled = std::any_of(m_LinkedPool.begin(), m_LinkedPool.end(),
+			[&](const PooledImage& e) { return e.texture && e.width == width
+				&& e.height == height && e.dwFormat == dwFormat; });
+		if (m_bAsyncResize && m_vkLinkedImage && !bPooled) {
+			if (!m_ResizeResult.valid())
+				StartResize(physicaldevice, logicaldevice, width, height, dwFormat);
+			if (m_ResizeResult.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				return true;
+			if (m_ResizeJob.width != width || m_ResizeJob.height != height || m_ResizeJob.dwFormat != dwFormat) {
+				// The size has changed again since the resize started
+				CancelResize(logicaldevice);
+				StartResize(physicaldevice, logicaldevice, width, height, dwFormat);
+				return true;
+			}
+			if (SwapResize(logicaldevice))
+				return true;
+			// Otherwise create them here
+		}
+
+		//
+		// For size or format change, retain the existing D3D11 texture
+		// and Vulkan image in the pool for a change back, or release them,
+		// and use a pooled texture and image of the new size or create them.
+		//
+		if (!PoolLinkedImage(logicaldevice)) {
+			if (!CompleteLocalReaders(logicaldevice, m_LocalReaders)) {
+				// Receivers in this process might not have submitted
+				// their copies, so the device cannot be waited for
+				RetireLinkedImage();
+			}
+			else {
+				// Ensure the GPU is not using the resources
+				vkDeviceWaitIdle(logicaldevice);
+				ReleaseLinkedImage(logicaldevice);
+			}
+			// Free the sender D3D11 texture
+			ReleaseSharedDX11texture();
+		}
+		m_bInitialized = false;
+		bool bLinked = AcquirePooledImage(nullptr, width, height, dwFormat);
+		if (bLinked) {
+			m_bInitialized = true;
+		}
+		// Create a new texture with the new size
+		else if (CreateSharedDX11texture(width, height, dwFormat)) {
+			// Recreate the linked Vulkan image with new size
+			bLinked = LinkVulkanImage(physicaldevice, logicaldevice, m_dxShareHandle, width, height, dwFormat);
+		}
+		if (bLinked) {
+			// Update the sender information
+			sendernames.UpdateSender(m_SenderName, width, height, m_dxShareHandle, dwFormat);
+			// Update globals
+			m_Width = width;
+			m_Height = height;
+			m_dwFormat = dwFormat;
+		}
+	}
+	else {
+		// Back to the current size before a new size was used
+		if (m_DebounceWidth > 0) {
+			if (m_DebounceWidth != m_Width || m_DebounceHeight != m_Height || m_DebounceFormat != m_dwFormat)
+				m_RelinksAvoided++;
+			m_DebounceWidth = 0;
+			m_DebounceHeight = 0;
+			m_DebounceFormat = 0;
+		}
+		if (m_ResizeResult.valid()
+			&& m_ResizeResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+			CancelResize(logicaldevice);
+	}
+	return true;
+}
+
+void spoutVK::SetResizeDebounce(uint32_t msec)
+{
+	m_ResizeDebounce = msec;
+}
+
+uint32_t spoutVK::GetResizeDebounce()
+{
+	return m_ResizeDebounce;
+}
+
+uint64_t spoutVK::GetRelinksAvoided()
+{
+	return m_RelinksAvoided;
+}
+
+//
+// Output resolution
+//
+// The sender size and format do not follow the image passed to SendImage,
+// which is scaled and converted by the blit or compute shader copy to the
+// shared texture. Window size changes then do not change the sender.
+//
+bool spoutVK::SetOutputResolution(uint32_t width, uint32_t height, VkFormat format)
+{
+	if ((width == 0) != (height == 0)) {
+		SpoutLogWarning("spoutVK::SetOutputResolution - width and height must both be set or zero");
+		return false;
+	}
+	if (format != VK_FORMAT_UNDEFINED && GetVulkanFormat(GetD3Dformat(format)) != format) {
+		SpoutLogWarning("spoutVK::SetOutputResolution - format %d not supported for a sender", format);
+		return false;
+	}
+	m_OutputWidth = width;
+	m_OutputHeight = height;
+	m_OutputFormat = format;
+	return true;
+}
+
+//
+// Mip texture
+//
+// The shared texture keeps a single level so that any Spout receiver
+// can copy it. A second shared texture of half the sender size carries
+// the mip levels, blitted from the linked image and then from each level
+// to the next after the frame is copied. The levels, share handle and size
+// are published in the sender information for SpoutVK receivers.
+//
+void spoutVK::SetSenderMipLevels(uint32_t levels)
+{
+	if (levels == 0)
+		RetireMipImage();
+	m_MipLevels = levels;
+}
+
+uint32_t spoutVK::GetSenderMipLevels()
+{
+	return m_MipLevels;
+}
+
+// Create the mip texture for the sender size and format
+// and retire one of a previous size
+bool spoutVK::UpdateMipImage(VkPhysicalDevice physicaldevice, VkDevice logicaldevice)
+{
+	// Levels that fit within the sender size
+	uint32_t levels = 0;
+	while (levels < m_MipLevels && (m_Width >> (levels + 1)) > 0 && (m_Height >> (levels + 1)) > 0)
+		levels++;
+
+	if (m_pMipTexture && m_MipWidth == m_Width/2 && m_MipHeight == m_Height/2
+		&& m_MipFormat == m_dwFormat && (uint32_t)m_MipStates.size() == levels)
+		return true;
+
+	RetireMipImage();
+	if (levels == 0 || !m_pD3D11Device)
+		return false;
+
+	// The blit chain requires linear filtering for the format
+	VkFormatFeatureFlags features = GetFormatFeatures(physicaldevice, GetVulkanFormat(m_dwFormat));
+	VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT
+		| VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	if ((features & required) != required) {
+		if (!m_bMipWarning) {
+			SpoutLogWarning("spoutVK::UpdateMipImage - blit not supported for the sender format");
+			m_bMipWarning = true;
+		}
+		return false;
+	}
+
+	D3D11_TEXTURE2D_DESC desc{};
+	desc.Width = m_Width/2;
+	desc.Height = m_Height/2;
+	desc.MipLevels = levels;
+	desc.ArraySize = 1;
+	desc.Format = (DXGI_FORMAT)m_dwFormat;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_SHARED;
+	if (FAILED(m_pD3D11Device->CreateTexture2D(&desc, nullptr, &m_pMipTexture))) {
+		SpoutLogWarning("spoutVK::UpdateMipImage - could not create texture");
+		m_pMipTexture = nullptr;
+		return false;
+	}
+
+	IDXGIResource* pResource = nullptr;
+	if (FAILED(m_pMipTexture->QueryInterface(__uuidof(IDXGIResource), (void**)&pResource))
+		|| FAILED(pResource->GetSharedHandle(&m_MipShareHandle))) {
+		SpoutLogWarning("spoutVK::UpdateMipImage - could not get share handle");
+		if (pResource) pResource->Release();
+		m_pMipTexture->Release();
+		m_pMipTexture = nullptr;
+		m_MipShareHandle = nullptr;
+		return false;
+	}
+	pResource->Release();
+
+	if (!ImportD3D11Texture(physicaldevice, logicaldevice, m_MipShareHandle,
+		m_Width/2, m_Height/2, m_dwFormat, m_vkMipImage, m_vkMipMemory, levels)) {
+		m_pMipTexture->Release();
+		m_pMipTexture = nullptr;
+		m_MipShareHandle = nullptr;
+		return false;
+	}
+
+	m_MipWidth = m_Width/2;
+	m_MipHeight = m_Height/2;
+	m_MipFormat = m_dwFormat;
+	ResetMipStates();
+
+	return true;
+}
+
+//
+// The mip texture is shared with other processes in GENERAL layout, as the
+// linked image. The levels are transitioned from GENERAL for each use,
+// with any previous write, and returned to GENERAL after it.
+//
+void spoutVK::ResetMipStates()
+{
+	m_MipStates.assign(m_MipStates.size(), spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_GENERAL, true));
+}
+
+// Blit the linked image to level 0 and each level to the next
+void spoutVK::GenerateMips(VkCommandBuffer commandBuffer)
+{
+	BeginLabel(commandBuffer, "SpoutVK mips");
+	spoutVKimageState srcState = spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+	spoutVKimageState dstState = spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	ResetMipStates();
+	m_barriers.Transition(m_vkLinkedImage, m_LinkedState, srcState);
+
+	int32_t srcWidth = (int32_t)m_Width;
+	int32_t srcHeight = (int32_t)m_Height;
+	for (uint32_t level = 0; level < (uint32_t)m_MipStates.size(); level++) {
+		int32_t dstWidth = std::max((int32_t)(m_MipWidth >> level), 1);
+		int32_t dstHeight = std::max((int32_t)(m_MipHeight >> level), 1);
+
+		if (level > 0)
+			m_barriers.Transition(m_vkMipImage, m_MipStates[level - 1], srcState, level - 1, 1);
+		m_barriers.Transition(m_vkMipImage, m_MipStates[level], dstState, level, 1);
+		m_barriers.Flush(commandBuffer);
+
+		VkImageBlit blit{};
+		blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level > 0 ? level - 1 : 0, 0, 1 };
+		blit.srcOffsets[1] = { srcWidth, srcHeight, 1 };
+		blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+		blit.dstOffsets[1] = { dstWidth, dstHeight, 1 };
+		vkCmdBlitImage(commandBuffer,
+			level > 0 ? m_vkMipImage : m_vkLinkedImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			m_vkMipImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1, &blit, VK_FILTER_LINEAR);
+
+		srcWidth = dstWidth;
+		srcHeight = dstHeight;
+	}
+
+	// The linked image and the levels are returned to GENERAL
+	spoutVKimageState general = spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_GENERAL);
+	m_barriers.Transition(m_vkLinkedImage, m_LinkedState, general);
+	for (uint32_t level = 0; level < (uint32_t)m_MipStates.size(); level++)
+		m_barriers.Transition(m_vkMipImage, m_MipStates[level], general, level, 1);
+	m_barriers.Flush(commandBuffer);
+	EndLabel(commandBuffer);
+}
+
+// Move the sender mip texture and image to the retired list
+void spoutVK::RetireMipImage()
+{
+	// A receiver imports the image without a texture
+	if (!m_pMipTexture && !m_vkMipImage)
+		return;
+
+	Retired retired {};
+	retired.texture = m_pMipTexture;
+	retired.image = m_vkMipImage;
+	retired.memory = m_vkMipMemory;
+	Retire(retired);
+
+	m_pMipTexture = nullptr;
+	m_MipShareHandle = nullptr;
+	m_vkMipImage = nullptr;
+	m_vkMipMemory = nullptr;
+	m_MipStates.clear();
+}
+
+void spoutVK::ReleaseMipImage(VkDevice logicaldevice)
+{
+	if (logicaldevice) {
+		if (m_vkMipImage) vkDestroyImage(logicaldevice, m_vkMipImage, nullptr);
+		if (m_vkMipMemory) vkFreeMemory(logicaldevice, m_vkMipMemory, nullptr);
+		m_vkMipImage = nullptr;
+		m_vkMipMemory = nullptr;
+	}
+	if (m_pMipTexture && m_pD3D11Device)
+		spoutdx.ReleaseDX11Texture(m_pMipTexture);
+	m_pMipTexture = nullptr;
+	m_MipShareHandle = nullptr;
+	m_MipStates.clear();
+}
+
+//
+// Thumbnail
+//
+// At the interval, the linked image is scaled to a small RGBA8 image and
+// copied to a mapped buffer with the frame. An event is set after the copy
+// and the buffer is written to shared memory by a following frame once the
+// event status shows that the copy has completed, so that the sender does
+// not wait. Frames sent by SendPixels are not included.
+//
+void spoutVK::EnableThumbnail(bool bEnable, uint32_t msec)
+{
+	m_bThumbnail = bEnable;
+	m_ThumbInterval = msec;
+	if (!bEnable)
+		m_Thumbnail.Close();
+}
+
+void spoutVK::UpdateThumbnail(VkPhysicalDevice physicaldevice, VkCommandBuffer commandBuffer)
+{
+	// The event is set when the copy has completed
+	if (m_bThumbPending && vkGetEventStatus(m_vkDevice, m_vkThumbEvent) == VK_EVENT_SET) {
+		m_bThumbPending = false;
+		std::string name = std::string(m_SenderName) + "_vkthumb";
+		if (!m_Thumbnail.Name() || name != m_Thumbnail.Name()) {
+			m_Thumbnail.Close();
+			if (m_Thumbnail.Create(name.c_str(), (int)SPOUTVK_THUMB_MAPSIZE) == SPOUT_CREATE_FAILED) {
+				SpoutLogWarning("spoutVK::UpdateThumbnail - could not create %s", name.c_str());
+				return;
+			}
+		}
+		char* pBuffer = m_Thumbnail.Lock();
+		if (pBuffer) {
+			spoutVKthumb* pThumb = (spoutVKthumb*)pBuffer;
+			pThumb->size = sizeof(spoutVKthumb);
+			pThumb->width = m_ThumbWidth;
+			pThumb->height = m_ThumbHeight;
+			pThumb->frame = m_ThumbFrame;
+			memcpy(pBuffer + sizeof(spoutVKthumb), m_pThumbPixels, (size_t)m_ThumbWidth*m_ThumbHeight*4);
+			m_Thumbnail.Unlock();
+		}
+	}
+
+	auto now = std::chrono::steady_clock::now();
+	if (m_bThumbPending || now - m_ThumbTime < std::chrono::milliseconds(m_ThumbInterval))
+		return;
+	m_ThumbTime = now;
+
+	// Fit within the thumbnail size with the aspect ratio of the sender
+	uint32_t width = SPOUTVK_THUMB_WIDTH;
+	uint32_t height = (uint32_t)((uint64_t)m_Height*SPOUTVK_THUMB_WIDTH/m_Width);
+	if (height > SPOUTVK_THUMB_HEIGHT) {
+		height = SPOUTVK_THUMB_HEIGHT;
+		width = (uint32_t)((uint64_t)m_Width*SPOUTVK_THUMB_HEIGHT/m_Height);
+	}
+	width = std::max(width, 1u);
+	height = std::max(height, 1u);
+
+	// The previous copy has completed
+	if (m_vkThumbImage && (width != m_ThumbWidth || height != m_ThumbHeight))
+		ReleaseThumbnail(m_vkDevice);
+
+	if (!m_vkThumbImage) {
+		if (!CreateVulkanImage(width, height, VK_FORMAT_R8G8B8A8_UNORM,
+			VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+			m_vkThumbImage, m_vkThumbMemory))
+			return;
+		if (!CreateVulkanBuffer((VkDeviceSize)width*height*4, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			m_vkThumbBuffer, m_vkThumbBufferMemory)
+			|| vkMapMemory(m_vkDevice, m_vkThumbBufferMemory, 0, VK_WHOLE_SIZE, 0, &m_pThumbPixels) != VK_SUCCESS) {
+			SpoutLogWarning("spoutVK::UpdateThumbnail - could not create buffer");
+			ReleaseThumbnail(m_vkDevice);
+			return;
+		}
+		VkEventCreateInfo eventInfo = { VK_STRUCTURE_TYPE_EVENT_CREATE_INFO };
+		if (vkCreateEvent(m_vkDevice, &eventInfo, nullptr, &m_vkThumbEvent) != VK_SUCCESS) {
+			SpoutLogWarning("spoutVK::UpdateThumbnail - could not create event");
+			m_vkThumbEvent = nullptr;
+			ReleaseThumbnail(m_vkDevice);
+			return;
+		}
+		m_ThumbWidth = width;
+		m_ThumbHeight = height;
+		m_ThumbState = {};
+	}
+
+	// The thumbnail image is kept in the layout to copy to the buffer
+	BeginLabel(commandBuffer, "SpoutVK thumbnail");
+	spoutVKimageState srcState = spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+	m_barriers.Transition(m_vkThumbImage, m_ThumbState, srcState);
+	m_barriers.Flush(commandBuffer);
+	// Recorded directly rather than timed and labelled as a receive copy
+	RecordCopy(physicaldevice, commandBuffer,
+		m_vkLinkedImage, VK_IMAGE_LAYOUT_GENERAL, GetVulkanFormat(m_dwFormat),
+		m_vkThumbImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_FORMAT_R8G8B8A8_UNORM,
+		m_Width, m_Height, width, height);
+
+	VkBufferImageCopy region{};
+	region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	region.imageExtent = { width, height, 1 };
+	vkCmdCopyImageToBuffer(commandBuffer, m_vkThumbImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		m_vkThumbBuffer, 1, &region);
+	m_ThumbState = srcState;
+
+	// Make the copy available to the host and set the event after it.
+	// The previous copy has completed, so the event can be reset by the host.
+	m_barriers.Memory(VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_2_HOST_BIT, VK_ACCESS_2_HOST_READ_BIT);
+	m_barriers.Flush(commandBuffer);
+	vkResetEvent(m_vkDevice, m_vkThumbEvent);
+	vkCmdSetEvent(commandBuffer, m_vkThumbEvent, VK_PIPELINE_STAGE_TRANSFER_BIT);
+	EndLabel(commandBuffer);
+
+	m_bThumbPending = true;
+	m_ThumbFrame = frame.GetSenderFrame();
+}
+
+// Resources of the thumbnail copy, after any copy in progress
+void spoutVK::ReleaseThumbnail(VkDevice logicaldevice)
+{
+	if (!logicaldevice)
+		return;
+
+	if (m_bThumbPending && m_vkThumbEvent
+		&& vkGetEventStatus(logicaldevice, m_vkThumbEvent) != VK_EVENT_SET)
+		vkDeviceWaitIdle(logicaldevice);
+
+	if (m_vkThumbBufferMemory && m_pThumbPixels) vkUnmapMemory(logicaldevice, m_vkThumbBufferMemory);
+	if (m_vkThumbBuffer) vkDestroyBuffer(logicaldevice, m_vkThumbBuffer, nullptr);
+	if (m_vkThumbBufferMemory) vkFreeMemory(logicaldevice, m_vkThumbBufferMemory, nullptr);
+	if (m_vkThumbImage) vkDestroyImage(logicaldevice, m_vkThumbImage, nullptr);
+	if (m_vkThumbMemory) vkFreeMemory(logicaldevice, m_vkThumbMemory, nullptr);
+	if (m_vkThumbEvent) vkDestroyEvent(logicaldevice, m_vkThumbEvent, nullptr);
+	m_pThumbPixels = nullptr;
+	m_vkThumbBuffer = nullptr;
+	m_vkThumbBufferMemory = nullptr;
+	m_vkThumbImage = nullptr;
+	m_vkThumbMemory = nullptr;
+	m_vkThumbEvent = nullptr;
+	m_ThumbWidth = 0;
+	m_ThumbHeight = 0;
+	m_bThumbPending = false;
+}
+
+//
+// Async resize
+//
+// The worker thread only creates the D3D11 texture and imports it to a new
+// Vulkan image, neither of which are used by the device until the swap.
+// The replaced texture and image are pooled, or retired and released when
+// the frames that used them have completed rather than waiting for the device.
+//
+void spoutVK::EnableAsyncResize(bool bEnable)
+{
+	m_bAsyncResize = bEnable;
+}
+
+bool spoutVK::IsResizePending()
+{
+	return m_ResizeResult.valid();
+}
+
+void spoutVK::SetRetireFrames(uint32_t frames)
+{
+	m_RetireFrames = frames;
+}
+
+void spoutVK::SetFrameTimeline(VkSemaphore semaphore, uint64_t value)
+{
+	m_vkFrameTimeline = semaphore;
+	m_FrameValue = value;
+}
+
+void spoutVK::StartResize(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	uint32_t width, uint32_t height, DWORD dwFormat)
+{
+	m_ResizeJob = {};
+	m_ResizeJob.width = width;
+	m_ResizeJob.height = height;
+	m_ResizeJob.dwFormat = dwFormat;
+	ResizeJob* job = &m_ResizeJob;
+	m_ResizeResult = std::async(std::launch::async, [this, job, physicaldevice, logicaldevice]() {
+		if (!spoutdx.CreateSharedDX11Texture(m_pD3D11Device, job->width, job->height,
+			(DXGI_FORMAT)job->dwFormat, &job->texture, job->shareHandle))
+			return false;
+		if (!ImportD3D11Texture(physicaldevice, logicaldevice, job->shareHandle,
+			job->width, job->height, job->dwFormat, job->image, job->memory)) {
+			spoutdx.ReleaseDX11Texture(job->texture);
+			job->texture = nullptr;
+			return false;
+		}
+		return true;
+	});
+}
+
+// Make the completed resize the sender texture and linked image
+bool spoutVK::SwapResize(VkDevice logicaldevice)
+{
+	if (!m_ResizeResult.get()) {
+		SpoutLogWarning("spoutVK::SwapResize - could not create texture %dx%d", m_ResizeJob.width, m_ResizeJob.height);
+		m_ResizeJob = {};
+		return false;
+	}
+
+	// Retain the current texture and image for a change back,
+	// or release them after frames in flight
+	if (!PoolLinkedImage(logicaldevice))
+		RetireLinkedImage();
+
+	m_pSharedTexture = m_ResizeJob.texture;
+	m_dxShareHandle = m_ResizeJob.shareHandle;
+	m_vkLinkedImage = m_ResizeJob.image;
+	m_vkImageMemory = m_ResizeJob.memory;
+	m_vkLinkedView = nullptr;
+	m_LinkedHandle = m_ResizeJob.shareHandle;
+	m_LinkedWidth = m_ResizeJob.width;
+	m_LinkedHeight = m_ResizeJob.height;
+	m_LinkedFormat = m_ResizeJob.dwFormat;
+	ResetLinkedState();
+	m_LinkedGeneration++;
+
+	// Receivers find the new texture with the sender information
+	sendernames.UpdateSender(m_SenderName, m_LinkedWidth, m_LinkedHeight, m_dxShareHandle, m_LinkedFormat);
+	m_Width = m_LinkedWidth;
+	m_Height = m_LinkedHeight;
+	m_dwFormat = m_LinkedFormat;
+
+	m_ResizeJob = {};
+	return true;
+}
+
+// Wait for any resize in progress and release what it created.
+// The image has not been used by the device.
+void spoutVK::CancelResize(VkDevice logicaldevice)
+{
+	if (!m_ResizeResult.valid())
+		return;
+
+	if (m_ResizeResult.get()) {
+		if (logicaldevice) {
+			vkDestroyImage(logicaldevice, m_ResizeJob.image, nullptr);
+			vkFreeMemory(logicaldevice, m_ResizeJob.memory, nullptr);
+		}
+		if (m_ResizeJob.texture && m_pD3D11Device)
+			spoutdx.ReleaseDX11Texture(m_ResizeJob.texture);
+	}
+	m_ResizeJob = {};
+}
+
+// Move the linked image and sender texture to the retired list
+void spoutVK::RetireLinkedImage()
+{
+	if (!m_vkLinkedImage)
+		return;
+
+	// Copy commands recorded for the linked image
+	ClearCommandCache();
+
+	Retired retired {};
+	retired.texture = m_pSharedTexture;
+	retired.image = m_vkLinkedImage;
+	retired.memory = m_vkImageMemory;
+	retired.view = m_vkLinkedView;
+	{
+		std::lock_guard<std::recursive_mutex> lock(localMutex);
+		retired.readers.swap(m_LocalReaders);
+	}
+	Retire(retired);
+
+	m_pSharedTexture = nullptr;
+	m_dxShareHandle = nullptr;
+	m_vkLinkedView = nullptr;
+	m_vkLinkedImage = nullptr;
+	m_vkImageMemory = nullptr;
+	m_LinkedHandle = nullptr;
+}
+
+//
+// Retired objects
+//
+// An object is retired in the frame in which it is replaced and released
+// when the command buffers recorded until then have completed.
+//
+// With a frame timeline, that is when the timeline reaches the value
+// current when the object was retired. Otherwise, after the retire frames,
+// a fence is submitted to the queue set by SetVulkanQueue and the objects
+// are released when it has signalled. Without a queue the device waits.
+// Neither the timeline nor the fence are waited for. A linked image is also
+// held until the copies of receivers in this process have completed.
+//
+void spoutVK::Retire(const Retired& retired)
+{
+	Retired entry = retired;
+	entry.frame = m_SenderFrames;
+	entry.timeline = m_vkFrameTimeline;
+	entry.value = m_FrameValue;
+	m_Retired.push_back(entry);
+}
+
+// Vulkan resources are not released without a device
+void spoutVK::ReleaseRetired(VkDevice logicaldevice, bool bAll)
+{
+	if (bAll) {
+		if (logicaldevice && !m_Retired.empty())
+			vkDeviceWaitIdle(logicaldevice);
+		for (Retired& retired : m_Retired)
+			CompleteLocalReaders(logicaldevice, retired.readers, m_LocalReaderTimeout);
+		m_bRetireFencePending = false;
+	}
+	else if (logicaldevice) {
+		if (m_bRetireFencePending && vkGetFenceStatus(logicaldevice, m_vkRetireFence) == VK_SUCCESS) {
+			m_RetireCompleteFrame = m_RetireFenceFrame;
+			m_bRetireFencePending = false;
+		}
+
+		// Frames whose command buffers have been submitted
+		uint64_t submitted = (m_SenderFrames > m_RetireFrames) ? m_SenderFrames - m_RetireFrames : 0;
+		bool bWaiting = false;
+		for (const Retired& retired : m_Retired) {
+			if (!retired.timeline && retired.frame > m_RetireCompleteFrame && retired.frame <= submitted)
+				bWaiting = true;
+		}
+		if (bWaiting && !m_bRetireFencePending) {
+			if (m_vkQueue && !m_vkRetireFence) {
+				VkFenceCreateInfo fenceInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+				if (vkCreateFence(logicaldevice, &fenceInfo, nullptr, &m_vkRetireFence) != VK_SUCCESS)
+					m_vkRetireFence = nullptr;
+			}
+			// The fence signals when all work submitted before it has completed
+			if (m_vkQueue && m_vkRetireFence) {
+				vkResetFences(logicaldevice, 1, &m_vkRetireFence);
+				if (vkQueueSubmit(m_vkQueue, 0, nullptr, m_vkRetireFence) == VK_SUCCESS) {
+					m_bRetireFencePending = true;
+					m_RetireFenceFrame = submitted;
+				}
+			}
+			if (!m_bRetireFencePending) {
+				vkDeviceWaitIdle(logicaldevice);
+				m_RetireCompleteFrame = submitted;
+			}
+		}
+	}
+
+	for (auto it = m_Retired.begin(); it != m_Retired.end();) {
+		bool bComplete = bAll;
+		if (!bComplete && logicaldevice) {
+			if (it->timeline) {
+				uint64_t value = 0;
+				bComplete = vkGetSemaphoreCounterValue(logicaldevice, it->timeline, &value) == VK_SUCCESS
+					&& value >= it->value;
+			}
+			else {
+				bComplete = it->frame <= m_RetireCompleteFrame;
+			}
+			bComplete = bComplete && CompleteLocalReaders(logicaldevice, it->readers);
+		}
+		if (bComplete) {
+			if (logicaldevice) {
+				if (it->view) vkDestroyImageView(logicaldevice, it->view, nullptr);
+				if (it->buffer) vkDestroyBuffer(logicaldevice, it->buffer, nullptr);
+				// A receiver's image might still be used by other receivers
+				if (!ReleaseImportedImage(logicaldevice, it->image)) {
+					if (it->image) vkDestroyImage(logicaldevice, it->image, nullptr);
+					if (it->memory) vkFreeMemory(logicaldevice, it->memory, nullptr);
+				}
+				if (it->set) vkFreeDescriptorSets(logicaldevice, m_vkComputePool, 1, &it->set);
+				if (it->commandBuffer) vkFreeCommandBuffers(logicaldevice, m_vkCommandPool, 1, &it->commandBuffer);
+			}
+			if (it->texture && m_pD3D11Device)
+				spoutdx.ReleaseDX11Texture(it->texture);
+			it = m_Retired.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+}
+
+void spoutVK::ReleaseSender()
+{
+	if(!m_dxShareHandle)
+		return;
+
+	// A frame that has not been ended
+	ReleaseImage(nullptr);
+	UnregisterLocalSender();
+
+	// A resize in progress is for this sender
+	CancelResize(m_vkDevice);
+	RetireMipImage();
+
+	// Release the sender from the name list
+	if(m_SenderName && m_SenderName[0])
+		sendernames.ReleaseSenderName(m_SenderName);
+	m_SenderName[0] = 0;
+	m_SenderInfo.Close();
+	m_Thumbnail.Close();
+	m_bThumbPending = false;
+
+	// Release sender resources
+	ReleaseSharedDX11texture();
+
+}
+
+void spoutVK::SetReceiverName(const char* sendername)
+{
+	if (sendername && sendername[0])
+		strcpy_s(m_SenderName, 256, sendername);
+	else
+		m_SenderName[0] = 0;
+}
+
+bool spoutVK::ReceiveImage(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	VkCommandBuffer commandbuffer, VkImage vulkanimage, VkImageLayout layout,
+	VkFormat vulkanformat, uint32_t width, uint32_t height)
+{
+	if (!CheckVulkanExtensions(physicaldevice)) {
+		SpoutLogError("spoutVK::ReceiveImage - required Vulkan extensions not supported");
+		return false;
+	}
+
+	// The receiving image dimensions can be different to the sender.
+	// Fit to destination if the receiving size is specified and the
+	// sender and destination receiver sizes are different.
+	// A sender in this process on the same device
+	if (ReceiveLocalImage(physicaldevice, logicaldevice, commandbuffer,
+		vulkanimage, layout, vulkanformat, width, height))
+		return true;
+
+	int w = width;
+	int h = height;
+	if (ReceiveSenderTexture(physicaldevice, logicaldevice)) {
+		if(width  == 0) w = GetSenderWidth();
+		if(height == 0) h = GetSenderHeight();
+		// The receiving image already has the sender's frame
+		frame.GetNewFrame();
+		m_bIsNewFrame = CheckNewFrame(vulkanimage, w, h, vulkanformat,
+			frame.GetSenderFrame(), m_LinkedGeneration);
+		if (!m_bIsNewFrame)
+			return true;
+		if (frame.CheckAccess()) { // Get access to the shared texture
+			// Copy from a level of the sender's mip texture for smaller sizes
+			// or from the linked image to the receiving image
+			if (!ReceiveMipLevel(physicaldevice, logicaldevice, commandbuffer,
+				vulkanimage, layout, vulkanformat, w, h)) {
+				CopyVulkanImage(physicaldevice, commandbuffer,
+					m_vkLinkedImage,             // Linked image
+					VK_IMAGE_LAYOUT_GENERAL,     // Linked image layout
+					GetVulkanFormat(m_dwFormat), // Linked image format
+					vulkanimage,                 // Receiving image
+					layout,                      // Receiving image layout
+					vulkanformat,                // Receiving image format
+					GetSenderWidth(), GetSenderHeight(), // Sender dimensions
+					w, h); // Receiving image dimensions
+			}
+			frame.AllowAccess();
+			return true;
+		}
+		// Not copied, so copy with the next call
+		m_ReceivedFrames.erase(std::remove_if(m_ReceivedFrames.begin(), m_ReceivedFrames.end(),
+			[vulkanimage](const ReceivedFrame& received) { return received.image == vulkanimage; }),
+			m_ReceivedFrames.end());
+		m_bIsNewFrame = false;
+	}
+	return false;
+}
+
+//
+// Zero copy receive
+//
+// The linked image is transitioned for sampling in the receiver's command
+// buffer and returned with its view and a sampler, instead of being copied.
+// The named access mutex is held from AcquireImage to ReleaseImage as for
+// the recording of a copy by ReceiveImage. The transition from GENERAL is
+// recorded for every acquire, so that the sampling is ordered after writes
+// by the sender. ReleaseImage returns the image to GENERAL after it.
+//
+bool spoutVK::AcquireImage(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	VkCommandBuffer commandbuffer, spoutVKacquired& acquired)
+{
+	if (!CheckVulkanExtensions(physicaldevice)) {
+		SpoutLogError("spoutVK::AcquireImage - required Vulkan extensions not supported");
+		return false;
+	}
+
+	if (m_bAcquired) {
+		SpoutLogWarning("spoutVK::AcquireImage - image not released");
+		return false;
+	}
+
+	if (!ReceiveSenderTexture(physicaldevice, logicaldevice) || !m_vkLinkedImage)
+		return false;
+
+	VkImageView view = GetLinkedView();
+	if (!view)
+		return false;
+
+	if (!m_vkAcquireSampler) {
+		VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		if (vkCreateSampler(logicaldevice, &samplerInfo, nullptr, &m_vkAcquireSampler) != VK_SUCCESS) {
+			SpoutLogWarning("spoutVK::AcquireImage - could not create sampler");
+			m_vkAcquireSampler = nullptr;
+			return false;
+		}
+	}
+
+	m_bIsNewFrame = frame.GetNewFrame();
+	if (!frame.CheckAccess())
+		return false;
+	m_bAcquired = true;
+
+	spoutVKimageState readState = spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	ResetLinkedState();
+	m_barriers.Transition(m_vkLinkedImage, m_LinkedState, readState);
+	m_barriers.Flush(commandbuffer);
+
+	acquired.image = m_vkLinkedImage;
+	acquired.view = view;
+	acquired.sampler = m_vkAcquireSampler;
+	acquired.layout = readState.layout;
+	acquired.stages = readState.stages;
+	acquired.access = readState.access;
+	acquired.format = GetVulkanFormat(m_dwFormat);
+	acquired.width = m_Width;
+	acquired.height = m_Height;
+	acquired.bNewFrame = m_bIsNewFrame;
+
+	return true;
+}
+
+// The image is returned to GENERAL after the sampling recorded in the
+// command buffer. Without one, e.g. when the receiver is released,
+// access is only allowed.
+void spoutVK::ReleaseImage(VkCommandBuffer commandbuffer)
+{
+	if (!m_bAcquired)
+		return;
+	if (commandbuffer && m_vkLinkedImage) {
+		m_barriers.Transition(m_vkLinkedImage, m_LinkedState,
+			spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_GENERAL));
+		m_barriers.Flush(commandbuffer);
+	}
+	frame.AllowAccess();
+	m_bAcquired = false;
+}
+
+//
+// Find whether the sender has produced a frame that has not been
+// copied to the receiving image. The frame copied is recorded for each
+// image, so that a receiver that alternates between images copies
+// to each of them. A different size or format, or a new linked image,
+// is copied again. Always true if the sender does not count frames.
+//
+bool spoutVK::CheckNewFrame(VkImage image, uint32_t width, uint32_t height, VkFormat format,
+	long senderFrame, uint32_t generation)
+{
+	if (senderFrame == 0)
+		return true;
+
+	for (size_t i = 0; i < m_ReceivedFrames.size(); i++) {
+		ReceivedFrame& received = m_ReceivedFrames[i];
+		if (received.image == image) {
+			bool bNew = (received.frame != senderFrame || received.generation != generation
+				|| received.width != width || received.height != height || received.format != format);
+			received = { image, senderFrame, generation, width, height, format };
+			return bNew;
+		}
+	}
+
+	// The oldest image is removed for the maximum
+	if (m_ReceivedFrames.size() >= m_MaxReceivedFrames)
+		m_ReceivedFrames.erase(m_ReceivedFrames.begin());
+	m_ReceivedFrames.push_back({ image, senderFrame, generation, width, height, format });
+	return true;
+}
+
+bool spoutVK::IsFrameNew()
+{
+	return m_bIsNewFrame;
+}
+
+//
+// Same process fast path
+//
+// A sender registers itself by name for receivers in the same process.
+// The sender information has the process of the sender, and a receiver
+// that finds it is in the same process copies from the sender's linked
+// image on the same device, with no import of the shared texture and no
+// named mutex. Recording by the sender and the receiver is serialized by
+// a process lock instead.
+//
+// The GPU work is ordered by the frame timelines of the sender and receiver
+// (SetFrameTimeline). The receiver's submission waits for the value of the
+// sender's frame that it copies (GetLocalWait). The sender records the
+// receiver's timeline and value, and a linked image that it replaces is
+// retired until those have been reached rather than waiting for the device,
+// because the receiver's command buffer might not have been submitted.
+// Without both timelines the shared texture is used. SendPixels submits
+// its own upload, so a sender that sends with it also uses the shared texture.
+//
+// The sender's image is transitioned from the layout recorded by the sender
+// and returned to it. A frame being rendered between BeginFrame and EndFrame
+// is not copied.
+//
+void spoutVK::SetLocalFastPath(bool bEnable)
+{
+	m_bLocalFastPath = bEnable;
+}
+
+bool spoutVK::IsLocalReceive()
+{
+	return m_bLocalReceive;
+}
+
+void spoutVK::RegisterLocalSender()
+{
+	std::lock_guard<std::recursive_mutex> lock(localMutex);
+	UnregisterLocalSender();
+	if (m_SenderName[0]) {
+		localSenders[m_SenderName] = this;
+		m_bLocalSender = true;
+	}
+}
+
+void spoutVK::UnregisterLocalSender()
+{
+	if (!m_bLocalSender)
+		return;
+	std::lock_guard<std::recursive_mutex> lock(localMutex);
+	for (auto it = localSenders.begin(); it != localSenders.end(); it++) {
+		if (it->second == this) {
+			localSenders.erase(it);
+			break;
+		}
+	}
+	m_bLocalSender = false;
+}
+
+// Returns false to receive through the shared texture
+bool spoutVK::ReceiveLocalImage(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	VkCommandBuffer commandbuffer, VkImage vulkanimage, VkImageLayout layout,
+	VkFormat vulkanformat, uint32_t width, uint32_t height)
+{
+	bool bLocal = false;
+	m_vkLocalWait = nullptr;
+	m_LocalWaitValue = 0;
+	if (m_bLocalFastPath && m_vkFrameTimeline) {
+		// The active sender if no name is set
+		if (!m_SenderName[0])
+			sendernames.GetActiveSender(m_SenderName);
+
+		// Check the process of the sender once
+		if (m_SenderName[0] && m_LocalChecked != m_SenderName) {
+			spoutVKinfo info{};
+			m_bLocalPeer = ReadSenderInfo(info) && info.senderPid == (uint32_t)GetCurrentProcessId();
+			m_LocalChecked = m_SenderName;
+		}
+
+		if (m_bLocalPeer) {
+			std::lock_guard<std::recursive_mutex> lock(localMutex);
+			auto it = localSenders.find(m_SenderName);
+			spoutVK* sender = (it != localSenders.end()) ? it->second : nullptr;
+			if (sender && sender->m_vkDevice == logicaldevice && sender->m_vkLinkedImage
+				&& sender->m_vkFrameTimeline && !sender->m_bPixelSender) {
+				if (!m_bLocalReceive) {
+					m_ReceivedFrames.clear();
+					m_bLocalReceive = true;
+				}
+				uint32_t w = width  ? width  : sender->m_Width;
+				uint32_t h = height ? height : sender->m_Height;
+				m_bIsNewFrame = !sender->m_bAcquired && CheckNewFrame(vulkanimage, w, h, vulkanformat,
+					sender->frame.GetSenderFrame(), sender->m_LinkedGeneration);
+				if (m_bIsNewFrame) {
+					BeginLabel(commandbuffer, "SpoutVK local receive");
+					RecordCopy(physicaldevice, commandbuffer,
+						sender->m_vkLinkedImage, sender->m_LinkedState.layout,
+						GetVulkanFormat(sender->m_dwFormat),
+						vulkanimage, layout, vulkanformat,
+						sender->m_Width, sender->m_Height, w, h);
+					EndLabel(commandbuffer);
+					// The copy waits for the sender's frame
+					// and the sender's image is held for the copy
+					m_vkLocalWait = sender->m_vkFrameTimeline;
+					m_LocalWaitValue = sender->m_FrameValue;
+					sender->AddLocalReader(m_vkFrameTimeline, m_FrameValue);
+				}
+				m_LocalWidth = sender->m_Width;
+				m_LocalHeight = sender->m_Height;
+				m_LocalFormat = sender->m_dwFormat;
+				bLocal = true;
+			}
+		}
+	}
+
+	if (bLocal) {
+		// Register so that a sender that skips frames without receivers sends
+		RegisterReceiver();
+	}
+	else if (m_bLocalReceive) {
+		// Link the shared texture again when it is received
+		m_bLocalReceive = false;
+		m_ReceivedFrames.clear();
+		m_Width = 0;
+		m_Height = 0;
+	}
+	return bLocal;
+}
+
+bool spoutVK::GetLocalWait(VkSemaphore &semaphore, uint64_t &value)
+{
+	if (!m_vkLocalWait)
+		return false;
+	semaphore = m_vkLocalWait;
+	value = m_LocalWaitValue;
+	return true;
+}
+
+// Called by a receiver with the process lock
+void spoutVK::AddLocalReader(VkSemaphore timeline, uint64_t value)
+{
+	for (LocalReader& reader : m_LocalReaders) {
+		if (reader.timeline == timeline) {
+			reader.value = std::max(reader.value, value);
+			return;
+		}
+	}
+	m_LocalReaders.push_back({ timeline, value });
+}
+
+// Remove readers whose timelines have reached the value.
+// With a timeout, wait for the others first.
+bool spoutVK::CompleteLocalReaders(VkDevice logicaldevice, std::vector<LocalReader>& readers, uint64_t timeout)
+{
+	std::lock_guard<std::recursive_mutex> lock(localMutex);
+	if (readers.empty())
+		return true;
+
+	if (!logicaldevice) {
+		readers.clear();
+		return true;
+	}
+
+	if (timeout > 0) {
+		std::vector<VkSemaphore> semaphores;
+		std::vector<uint64_t> values;
+		for (const LocalReader& reader : readers) {
+			semaphores.push_back(reader.timeline);
+			values.push_back(reader.value);
+		}
+		VkSemaphoreWaitInfo waitInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
+		waitInfo.semaphoreCount = (uint32_t)semaphores.size();
+		waitInfo.pSemaphores = semaphores.data();
+		waitInfo.pValues = values.data();
+		if (vkWaitSemaphores(logicaldevice, &waitInfo, timeout) != VK_SUCCESS) {
+			// Copies recorded but never submitted
+			SpoutLogWarning("spoutVK::CompleteLocalReaders - receiver copies not completed");
+			readers.clear();
+			return true;
+		}
+	}
+
+	readers.erase(std::remove_if(readers.begin(), readers.end(), [&](const LocalReader& reader) {
+		uint64_t value = 0;
+		return vkGetSemaphoreCounterValue(logicaldevice, reader.timeline, &value) == VK_SUCCESS
+			&& value >= reader.value; }), readers.end());
+
+	return readers.empty();
+}
+
+//
+// Copy from the sender's mip texture if the receiving image is no more than
+// half the sender size. The smallest level not smaller than the receiving
+// image is blitted so that only that level is read. The texture is imported
+// again if the sender creates a new one for a change of size.
+// Returns false to copy from the linked image instead.
+//
+bool spoutVK::ReceiveMipLevel(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	VkCommandBuffer commandBuffer, VkImage dstImage, VkImageLayout dstLayout, VkFormat dstFormat,
+	uint32_t dstWidth, uint32_t dstHeight)
+{
+	if (dstWidth == 0 || dstHeight == 0 || dstWidth*2 > m_Width || dstHeight*2 > m_Height)
+		return false;
+
+	// The information can be from before a change of sender size
+	spoutVKinfo info{};
+	if (!ReadSenderInfo(info) || info.mipLevels == 0 || !info.mipHandle
+		|| info.mipExtent.width != m_Width/2 || info.mipExtent.height != m_Height/2)
+		return false;
+
+	VkFormat format = GetVulkanFormat(m_dwFormat);
+	if (!(GetFormatFeatures(physicaldevice, format) & VK_FORMAT_FEATURE_BLIT_SRC_BIT)
+		|| !(GetFormatFeatures(physicaldevice, format) & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+		|| !(GetFormatFeatures(physicaldevice, dstFormat) & VK_FORMAT_FEATURE_BLIT_DST_BIT))
+		return false;
+
+	HANDLE mipHandle = (HANDLE)(LongToHandle((long)info.mipHandle));
+	if (mipHandle != m_MipShareHandle || info.mipLevels != (uint32_t)m_MipStates.size()
+		|| m_MipFormat != m_dwFormat) {
+		// The previous image may be in use by frames in flight
+		RetireMipImage();
+		// Not imported again for the same handle if this fails
+		m_MipShareHandle = mipHandle;
+		m_MipWidth = info.mipExtent.width;
+		m_MipHeight = info.mipExtent.height;
+		m_MipFormat = m_dwFormat;
+		m_MipStates.assign(info.mipLevels, spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_GENERAL, true));
+		if (!ImportD3D11Texture(physicaldevice, logicaldevice, mipHandle,
+			m_MipWidth, m_MipHeight, m_dwFormat, m_vkMipImage, m_vkMipMemory, info.mipLevels)) {
+			SpoutLogWarning("spoutVK::ReceiveMipLevel - could not import mip texture 0x%X", info.mipHandle);
+		}
+	}
+	if (!m_vkMipImage)
+		return false;
+
+	// Smallest level not smaller than the receiving image
+	uint32_t level = 0;
+	while (level + 1 < (uint32_t)m_MipStates.size()
+		&& (m_MipWidth >> (level + 1)) >= dstWidth && (m_MipHeight >> (level + 1)) >= dstHeight)
+		level++;
+
+	// The sender writes the levels in GENERAL layout.
+	// The transition from GENERAL preserves the content and makes it visible.
+	ResetMipStates();
+	spoutVKimageState dstState = spoutVKbarriers::GetLayoutState(dstLayout, true);
+	m_barriers.Transition(m_vkMipImage, m_MipStates[level],
+		spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL), level, 1);
+	m_barriers.Transition(dstImage, dstState,
+		spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+	m_barriers.Flush(commandBuffer);
+
+	VkImageBlit blit{};
+	blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+	blit.srcOffsets[1] = { (int32_t)(m_MipWidth >> level), (int32_t)(m_MipHeight >> level), 1 };
+	blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	blit.dstOffsets[1] = { (int32_t)dstWidth, (int32_t)dstHeight, 1 };
+	vkCmdBlitImage(commandBuffer,
+		m_vkMipImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		1, &blit, VK_FILTER_LINEAR);
+
+	m_barriers.Transition(dstImage, dstState, spoutVKbarriers::GetLayoutState(dstLayout));
+	m_barriers.Transition(m_vkMipImage, m_MipStates[level],
+		spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_GENERAL), level, 1);
+	m_barriers.Flush(commandBuffer);
+
+	return true;
+}
+
+HANDLE spoutVK::ReceiveSenderTexture(VkPhysicalDevice physicaldevice, VkDevice device)
+{
+	// Objects replaced by the receiver are released after frames in flight
+	m_SenderFrames++;
+	if (!m_Retired.empty())
+		ReleaseRetired(device, false);
+
+	// Set the initial width and height to current globals.
+	// New width and height are returned from the sender.
+	unsigned int width  = m_Width;
+	unsigned int height = m_Height;
+	DWORD dwFormat = m_dwFormat;
+
+	//
+	// Find if the sender exists.
+	// Return the sender name, width, height, sharehandle and format.
+	//
+	// If not yet intialized or SelectSender has been opened, the sender
+	// name will be empty and the active sender is returned if that exists.
+	if (sendernames.FindSender(m_SenderName, width, height, m_dxShareHandle, dwFormat)) {
+
+		// Set up if not initialized yet
+		if (!m_bSpoutInitialized) {
+			// Open a named mutex to control access to the sender's shared texture
+			frame.CreateAccessMutex(m_SenderName);
+			// Enable frame counting to get the sender frame number and fps
+			frame.EnableFrameCount(m_SenderName);
+			m_bSpoutInitialized = true;
+		}
+
+		// Check for size or format change
+		if (m_Width != width || m_Height != height || m_dwFormat != dwFormat) {
+
+			// Update globals for subsequent size checks
+			m_Width = width;
+			m_Height = height;
+			m_dwFormat = dwFormat;
+			m_bInitialized = false;
+
+			// Create a Vulkan image and link with D3D11 texture memory
+			// using the sender share handle retrieved by FindSender above
+			if (!LinkVulkanImage(physicaldevice, device, m_dxShareHandle, width, height, dwFormat)) {
+				SpoutLogWarning("spoutVK::ReceiveSenderTexture - could not create Vulkan image with received handle 0x%X", PtrToUint(m_dxShareHandle));
+				return nullptr;
+			}
+			m_bInitialized = true;
+			// The application can now access and copy the linked image.
+		}
+		// Register with a SpoutVK sender so that it sends frames
+		RegisterReceiver();
+		return m_dxShareHandle;
+	}
+
+	return nullptr;
+}
+
+//
+// Receive to host memory
+//
+// The linked image is copied to a ring of host visible buffers
+// that remain mapped, with a fence for each buffer. The copies are
+// submitted to the queue set by SetVulkanQueue and the oldest completed
+// copy is returned without waiting for any in progress.
+//
+// Returns false until a copy has completed. The pixels remain valid
+// until the next call. Pitch is the row size in bytes and the format,
+// width and height are those of the sender when the copy was made.
+//
+bool spoutVK::ReceiveToMemory(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	const void* &pixels, uint32_t &width, uint32_t &height, uint32_t &pitch, VkFormat &format)
+{
+	if (!CheckVulkanExtensions(physicaldevice)) {
+		SpoutLogError("spoutVK::ReceiveToMemory - required Vulkan extensions not supported");
+		return false;
+	}
+
+	if (!m_vkQueue) {
+		SpoutLogError("spoutVK::ReceiveToMemory - queue not set");
+		return false;
+	}
+
+	// Average interval between calls
+	auto now = std::chrono::steady_clock::now();
+	if (m_ReadbackLastCall.time_since_epoch().count() > 0) {
+		double interval = std::chrono::duration<double, std::milli>(now - m_ReadbackLastCall).count();
+		m_ReadbackInterval = (m_ReadbackInterval > 0.0) ? m_ReadbackInterval*0.9 + interval*0.1 : interval;
+	}
+	m_ReadbackLastCall = now;
+
+	// Find completed copies and the average latency from submit.
+	// The buffer returned by the last call is free again.
+	for (StagingSlot& slot : m_Readback) {
+		if (slot.state == SLOT_INUSE) {
+			slot.state = SLOT_FREE;
+		}
+		else if (slot.state == SLOT_PENDING && vkGetFenceStatus(logicaldevice, slot.fence) == VK_SUCCESS) {
+			slot.state = SLOT_READY;
+			double latency = std::chrono::duration<double, std::milli>(now - slot.submitTime).count();
+			m_ReadbackLatency = (m_ReadbackLatency > 0.0) ? m_ReadbackLatency*0.9 + latency*0.1 : latency;
+		}
+	}
+
+	// Ring depth
+	// Completion is found at the next call, so the latency includes up to
+	// one interval and the depth covers the copies in progress plus the
+	// one returned. Free buffers above the depth are released.
+	uint32_t depth = GetReadbackDepth();
+	for (auto it = m_Readback.begin(); it != m_Readback.end() && (uint32_t)m_Readback.size() > depth;) {
+		if (it->state == SLOT_FREE) {
+			ReleaseStagingSlot(*it);
+			it = m_Readback.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+
+	if (ReceiveSenderTexture(physicaldevice, logicaldevice)) {
+		if (frame.CheckAccess()) {
+			VkFormat linkedFormat = GetVulkanFormat(m_dwFormat);
+			uint32_t rowPitch = m_Width*GetBytesPerPixel(linkedFormat);
+			VkDeviceSize size = (VkDeviceSize)rowPitch*m_Height;
+
+			// A free buffer, or a new one if less than the ring depth.
+			// If all are in use, the copy is skipped for this frame.
+			StagingSlot* slot = nullptr;
+			for (StagingSlot& s : m_Readback) {
+				if (s.state == SLOT_FREE) {
+					slot = &s;
+					break;
+				}
+			}
+			if (!slot && (uint32_t)m_Readback.size() < depth) {
+				m_Readback.push_back(StagingSlot{});
+				slot = &m_Readback.back();
+			}
+
+			if (slot && size > 0 && CreateStagingSlot(*slot, size, true)) {
+				VkCommandBuffer cmd = slot->commandBuffer;
+				vkResetCommandBuffer(cmd, 0);
+				VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+				beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+				vkBeginCommandBuffer(cmd, &beginInfo);
+
+				ResetLinkedState();
+				m_barriers.Transition(m_vkLinkedImage, m_LinkedState,
+					spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL));
+				m_barriers.Flush(cmd);
+
+				VkBufferImageCopy region{};
+				region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+				region.imageExtent = { m_Width, m_Height, 1 };
+				vkCmdCopyImageToBuffer(cmd, m_vkLinkedImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+					slot->buffer, 1, &region);
+
+				// Make the copy available to the host
+				// and return the linked image to GENERAL
+				m_barriers.Memory(VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+					VK_PIPELINE_STAGE_2_HOST_BIT, VK_ACCESS_2_HOST_READ_BIT);
+				m_barriers.Transition(m_vkLinkedImage, m_LinkedState,
+					spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_GENERAL));
+				m_barriers.Flush(cmd);
+				vkEndCommandBuffer(cmd);
+
+				vkResetFences(logicaldevice, 1, &slot->fence);
+				VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+				submitInfo.commandBufferCount = 1;
+				submitInfo.pCommandBuffers = &cmd;
+				if (vkQueueSubmit(m_vkQueue, 1, &submitInfo, slot->fence) == VK_SUCCESS) {
+					slot->state = SLOT_PENDING;
+					slot->sequence = ++m_ReadbackSequence;
+					slot->submitTime = now;
+					slot->width = m_Width;
+					slot->height = m_Height;
+					slot->pitch = rowPitch;
+					slot->format = linkedFormat;
+				}
+				else {
+					SpoutLogWarning("spoutVK::ReceiveToMemory - could not submit copy");
+				}
+			}
+			frame.AllowAccess();
+		}
+	}
+
+	// The oldest completed copy
+	StagingSlot* ready = nullptr;
+	for (StagingSlot& s : m_Readback) {
+		if (s.state == SLOT_READY && (!ready || s.sequence < ready->sequence))
+			ready = &s;
+	}
+	if (!ready)
+		return false;
+
+	if (!ready->bCoherent) {
+		VkMappedMemoryRange range = { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
+		range.memory = ready->memory;
+		range.offset = 0;
+		range.size = VK_WHOLE_SIZE;
+		vkInvalidateMappedMemoryRanges(logicaldevice, 1, &range);
+	}
+	ready->state = SLOT_INUSE;
+
+	pixels = ready->mapped;
+	width  = ready->width;
+	height = ready->height;
+	pitch  = ready->pitch;
+	format = ready->format;
+
+	return true;
+}
+
+//
+// Number of buffers for ReceiveToMemory, from 2 to 8.
+// Zero (default) for a depth adapted to the measured copy latency
+// relative to the interval between calls.
+//
+void spoutVK::SetReadbackDepth(uint32_t depth)
+{
+	if (depth > 0)
+		depth = std::min(std::max(depth, 2u), 8u);
+	m_ReadbackDepth = depth;
+}
+
+uint32_t spoutVK::GetReadbackDepth()
+{
+	if (m_ReadbackDepth > 0)
+		return m_ReadbackDepth;
+
+	uint32_t depth = 2;
+	if (m_ReadbackInterval > 0.0)
+		depth = (uint32_t)std::ceil(m_ReadbackLatency/m_ReadbackInterval) + 1;
+	return std::min(std::max(depth, 2u), 8u);
+}
+
+// Waits for copies in progress
+void spoutVK::ReleaseReadback()
+{
+	for (StagingSlot& slot : m_Readback) {
+		if (slot.state == SLOT_PENDING)
+			vkWaitForFences(m_vkDevice, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+		ReleaseStagingSlot(slot);
+	}
+	m_Readback.clear();
+	m_ReadbackSequence = 0;
+	m_ReadbackLatency = 0.0;
+	m_ReadbackInterval = 0.0;
+	m_ReadbackLastCall = {};
+}
+
+uint32_t spoutVK::GetSenderWidth()
+{
+	return m_bLocalReceive ? m_LocalWidth : m_Width;
+}
+
+uint32_t spoutVK::GetSenderHeight()
+{
+	return m_bLocalReceive ? m_LocalHeight : m_Height;
+}
+
+VkFormat spoutVK::GetSenderFormat()
+{
+	return GetVulkanFormat(m_bLocalReceive ? m_LocalFormat : m_dwFormat);
+}
+
+//
+// Region of the sender image changed for a frame
+//
+// Returns false if the sender is not a SpoutVK sender.
+// The whole image for a sender that does not specify regions.
+// Compare the frame number with that received to find whether
+// the region applies to the frame.
+//
+bool spoutVK::GetDirtyRect(VkRect2D &rect, long &framenumber)
+{
+	spoutVKinfo info{};
+	if (!ReadSenderInfo(info))
+		return false;
+
+	rect = info.dirtyRect;
+	framenumber = (long)info.frame;
+	return true;
+}
+
+//
+// Thumbnail of a sender
+//
+// The shared memory is opened for each call, so any number of senders
+// can be previewed without creating a receiver for each.
+// Returns false if the sender does not publish a thumbnail.
+//
+bool spoutVK::ReadThumbnail(const char* sendername, void* pixels,
+	uint32_t &width, uint32_t &height, long &framenumber)
+{
+	if (!sendername || !sendername[0] || !pixels)
+		return false;
+
+	SpoutSharedMemory thumbnail;
+	std::string name = std::string(sendername) + "_vkthumb";
+	if (!thumbnail.Open(name.c_str()))
+		return false;
+
+	char* pBuffer = thumbnail.Lock();
+	if (!pBuffer)
+		return false;
+
+	bool bValid = false;
+	spoutVKthumb* pThumb = (spoutVKthumb*)pBuffer;
+	if (pThumb->size == sizeof(spoutVKthumb)
+		&& pThumb->width > 0 && pThumb->width <= SPOUTVK_THUMB_WIDTH
+		&& pThumb->height > 0 && pThumb->height <= SPOUTVK_THUMB_HEIGHT) {
+		width = pThumb->width;
+		height = pThumb->height;
+		framenumber = (long)pThumb->frame;
+		memcpy(pixels, pBuffer + pThumb->size, (size_t)width*height*4);
+		bValid = true;
+	}
+	thumbnail.Unlock();
+
+	return bValid;
+}
+
+void spoutVK::ReleaseReceiver()
+{
+	ReleaseImage(nullptr);
+	UnregisterReceiver();
+	m_bLocalReceive = false;
+	m_bLocalPeer = false;
+	m_LocalChecked.clear();
+
+	if (!m_bInitialized)
+		return;
+
+	SpoutLogNotice("spoutVK::ReleaseReceiver (%s)", m_SenderName);
+
+	// Wait 4 frames in case the same sender opens again
+	Sleep(67);
+
+	// Sender share handled texture
+	ReleaseSharedDX11texture();
+
+	// Close the named access mutex and frame counting semaphore.
+	frame.CloseAccessMutex();
+	frame.CleanupFrameCount();
+	m_SenderInfo.Close();
+	m_ReceivedFrames.clear();
+	m_bIsNewFrame = false;
+
+	// Zero width and height so that they are reset when a sender is found
+	m_Width = 0;
+	m_Height = 0;
+
+	// Clear the name to find the active sender
+	m_SenderName[0] = 0;
+	
+	// Initialize again when a sender is found
+	m_bInitialized = false;
+
+	return;
+
+}
+
+//
+// SpoutVK sender information shared memory
+//
+bool spoutVK::CreateSenderInfo()
+{
+	std::string name = std::string(m_SenderName) + "_vkinfo";
+	m_SenderInfo.Close();
+	if (m_SenderInfo.Create(name.c_str(), SPOUTVK_INFO_MAPSIZE) == SPOUT_CREATE_FAILED) {
+		SpoutLogWarning("spoutVK::CreateSenderInfo - could not create %s", name.c_str());
+		return false;
+	}
+	spoutVKinfo info{};
+	info.dirtyRect = { { 0, 0 }, { m_Width, m_Height } };
+	return WriteSenderInfo(info);
+}
+
+// Open the information of the sender being received
+bool spoutVK::OpenSenderInfo()
+{
+	if (!m_SenderName[0])
+		return false;
+
+	std::string name = std::string(m_SenderName) + "_vkinfo";
+	if (m_SenderInfo.Name() && name == m_SenderInfo.Name())
+		return true;
+
+	// Free the slot of the previous sender
+	UnregisterReceiver();
+	m_SenderInfo.Close();
+	return m_SenderInfo.Open(name.c_str());
+}
+
+bool spoutVK::WriteSenderInfo(const spoutVKinfo& info)
+{
+	if (!m_SenderInfo.Name())
+		return false;
+
+	char* pBuffer = m_SenderInfo.Lock();
+	if (!pBuffer)
+		return false;
+
+	spoutVKinfo* pInfo = (spoutVKinfo*)pBuffer;
+	*pInfo = info;
+	pInfo->size = sizeof(spoutVKinfo);
+	pInfo->version = SPOUTVK_INFO_VERSION;
+	pInfo->receiverSlots = SPOUTVK_RECEIVER_SLOTS;
+	pInfo->senderPid = (uint32_t)GetCurrentProcessId();
+	m_SenderInfo.Unlock();
+
+	return true;
+}
+
+// Members not written by the sender are zero
+bool spoutVK::ReadSenderInfo(spoutVKinfo& info)
+{
+	if (!OpenSenderInfo())
+		return false;
+
+	char* pBuffer = m_SenderInfo.Lock();
+	if (!pBuffer)
+		return false;
+
+	info = {};
+	uint32_t size = ((spoutVKinfo*)pBuffer)->size;
+	memcpy(&info, pBuffer, std::min<size_t>(size, sizeof(spoutVKinfo)));
+	m_SenderInfo.Unlock();
+
+	return true;
+}
+
+//
+// Receiver table
+//
+// A receiver registers in the table of a SpoutVK sender when it finds the
+// sender, and refreshes its slot at most every SPOUTVK_RECEIVER_REFRESH msec.
+// A slot that is not refreshed within SPOUTVK_RECEIVER_TIMEOUT is free again,
+// so a receiver that closes without releasing is removed after the timeout.
+//
+// A sender that skips frames without receivers (SetSkipWithoutReceivers)
+// checks the table for each frame, so the first frame is copied in full
+// by the next SendImage after a receiver registers.
+//
+void spoutVK::SetSkipWithoutReceivers(bool bSkip)
+{
+	m_bSkipWithoutReceivers = bSkip;
+}
+
+uint32_t spoutVK::GetReceiverCount()
+{
+	if (!m_SenderInfo.Name())
+		return 0;
+
+	char* pBuffer = m_SenderInfo.Lock();
+	if (!pBuffer)
+		return 0;
+
+	uint64_t now = GetTickCount64();
+	spoutVKreceiver* pTable = (spoutVKreceiver*)(pBuffer + SPOUTVK_RECEIVER_OFFSET);
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < SPOUTVK_RECEIVER_SLOTS; i++) {
+		if (pTable[i].pid != 0 && now - pTable[i].time <= SPOUTVK_RECEIVER_TIMEOUT)
+			count++;
+	}
+	m_SenderInfo.Unlock();
+
+	return count;
+}
+
+uint32_t spoutVK::NewReceiverId()
+{
+	static LONG receiverIds = 0;
+	return (uint32_t)InterlockedIncrement(&receiverIds);
+}
+
+void spoutVK::RegisterReceiver()
+{
+	if (m_ReceiverTime > 0 && GetTickCount64() - m_ReceiverTime < SPOUTVK_RECEIVER_REFRESH)
+		return;
+
+	if (OpenSenderInfo())
+		RegisterReceiver(m_SenderInfo, m_ReceiverId, m_ReceiverSlot, m_ReceiverTime, m_SenderName);
+}
+
+void spoutVK::UnregisterReceiver()
+{
+	UnregisterReceiver(m_SenderInfo, m_ReceiverId, m_ReceiverSlot, m_ReceiverTime);
+}
+
+void spoutVK::RegisterReceiver(SpoutSharedMemory& info, uint32_t id,
+	int& receiverSlot, uint64_t& receiverTime, const char* sendername)
+{
+	char* pBuffer = info.Lock();
+	if (!pBuffer)
+		return;
+
+	// Senders before version 3 have no table
+	spoutVKinfo* pInfo = (spoutVKinfo*)pBuffer;
+	uint32_t slots = 0;
+	if (pInfo->size >= offsetof(spoutVKinfo, receiverSlots) + sizeof(uint32_t))
+		slots = std::min<uint32_t>(pInfo->receiverSlots, SPOUTVK_RECEIVER_SLOTS);
+
+	// The time is read within the lock so that it is not earlier
+	// than the time of any slot
+	uint64_t now = GetTickCount64();
+	uint32_t pid = (uint32_t)GetCurrentProcessId();
+	spoutVKreceiver* pTable = (spoutVKreceiver*)(pBuffer + SPOUTVK_RECEIVER_OFFSET);
+
+	// The slot claimed before, unless it has timed out and been claimed by another receiver
+	int slot = -1;
+	if (receiverSlot >= 0 && receiverSlot < (int)slots
+		&& pTable[receiverSlot].pid == pid && pTable[receiverSlot].id == id)
+		slot = receiverSlot;
+	for (uint32_t i = 0; slot < 0 && i < slots; i++) {
+		if (pTable[i].pid == 0 || now - pTable[i].time > SPOUTVK_RECEIVER_TIMEOUT)
+			slot = (int)i;
+	}
+	if (slot >= 0)
+		pTable[slot] = { pid, id, now };
+	info.Unlock();
+
+	if (slot < 0 && slots > 0 && (receiverSlot >= 0 || receiverTime == 0))
+		SpoutLogWarning("spoutVK::RegisterReceiver - no free slot for %s", sendername);
+
+	// Retried after the refresh interval if there is no slot
+	receiverSlot = slot;
+	receiverTime = now;
+}
+
+void spoutVK::UnregisterReceiver(SpoutSharedMemory& info, uint32_t id, int& receiverSlot, uint64_t& receiverTime)
+{
+	if (receiverSlot >= 0 && info.Name()) {
+		char* pBuffer = info.Lock();
+		if (pBuffer) {
+			spoutVKreceiver& receiver = ((spoutVKreceiver*)(pBuffer + SPOUTVK_RECEIVER_OFFSET))[receiverSlot];
+			if (receiver.pid == (uint32_t)GetCurrentProcessId() && receiver.id == id)
+				receiver = {};
+			info.Unlock();
+		}
+	}
+	receiverSlot = -1;
+	receiverTime = 0;
+}
+
+std::string spoutVK::SelectSender(HWND hwnd)
+{
+	std::string senderstr;
+
+	// Create a sender list
+	std::vector<std::string> senderlist;
+	int nSenders = sendernames.GetSenderCount();
+	if (nSenders > 0) {
+		char sendername[256]{};
+		for (int i=0; i<nSenders; i++) {
+			if (sendernames.GetSender(i, sendername))
+				senderlist.push_back(sendername);
+		}
+	}
+
+	// Get the active sender index "selected".
+	// The index is passed in to SpoutMessageBox and used as the current combobox item.
+	int selected = 0;
+	char sendername[256]{};
+	if (sendernames.GetActiveSender(sendername))
+		selected = sendernames.GetSenderIndex(sendername);
+
+	// SpoutMessageBox opens either centered on the cursor position
+	// or on the application window if the handle is passed in.
+	if (!hwnd) {
+		POINT pt{};
+		GetCursorPos(&pt);
+		SpoutMessageBoxPosition(pt);
+	}
+
+	// Show the SpoutMessageBox even if the list is empty.
+	// This makes it clear to the user that no senders are running.
+	if (SpoutMessageBox(hwnd, NULL, "Select sender", MB_OKCANCEL, senderlist, selected) == IDOK && !senderlist.empty()) {
+		// Release the receiver
+		ReleaseReceiver();
+		// Set the selected sender as active for the next receive
+		sendernames.SetActiveSender(senderlist[selected].c_str());
+		// Return the selected sender name
+		// Not used in this example. the active sender is detected
+		senderstr = senderlist[selected].c_str();
+	} // endif messagebox query
+
+	return senderstr;
+
+}
+
+void spoutVK::HoldFps(int fps)
+{
+	frame.HoldFps(fps);
+}
+
+//
+// Barrier planner
+//
+
+//
+// The synchronization2 feature must have been enabled when the logical device was created
+// (VkPhysicalDeviceSynchronization2Features or Vulkan 1.3 VkPhysicalDeviceVulkan13Features).
+// The function cannot be tested from the device, so this is called by the application.
+//
+bool spoutVKbarriers::EnableSynchronization2(VkDevice device, bool bEnable)
+{
+	m_pfnCmdPipelineBarrier2 = nullptr;
+	if (!bEnable || !device)
+		return false;
+
+	// Core for Vulkan 1.3 or VK_KHR_synchronization2
+	m_pfnCmdPipelineBarrier2 = (PFN_vkCmdPipelineBarrier2)vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2");
+	if (!m_pfnCmdPipelineBarrier2)
+		m_pfnCmdPipelineBarrier2 = (PFN_vkCmdPipelineBarrier2)vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2KHR");
+	if (!m_pfnCmdPipelineBarrier2) {
+		SpoutLogWarning("spoutVKbarriers::EnableSynchronization2 - vkCmdPipelineBarrier2 not available");
+		return false;
+	}
+
+	return true;
+}
+
+bool spoutVKbarriers::IsSynchronization2()
+{
+	return (m_pfnCmdPipelineBarrier2 != nullptr);
+}
+
+void spoutVKbarriers::Transition(VkImage image, spoutVKimageState& state,
+	const spoutVKimageState& newstate, uint32_t baseMipLevel, uint32_t levelCount)
+{
+	if (!image)
+		return;
+
+	const VkAccessFlags2 writeAccess = VK_ACCESS_2_SHADER_WRITE_BIT
+		| VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT
+		| VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+		| VK_ACCESS_2_TRANSFER_WRITE_BIT
+		| VK_ACCESS_2_HOST_WRITE_BIT
+		| VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+	if (state.layout == newstate.layout) {
+		// Nothing to wait for
+		if (state.stages == 0) {
+			state = newstate;
+			return;
+		}
+		// Read after read needs no barrier. Keep the stages
+		// of both reads so that a following write waits for them.
+		if (!(state.access & writeAccess) && !(newstate.access & writeAccess)) {
+			state.stages |= newstate.stages;
+			state.access |= newstate.access;
+			return;
+		}
+	}
+
+	VkImageMemoryBarrier2 barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+	barrier.srcStageMask = state.stages;
+	barrier.srcAccessMask = state.access & writeAccess; // Only writes have to be made available
+	barrier.dstStageMask = newstate.stages;
+	barrier.dstAccessMask = newstate.access;
+	barrier.oldLayout = state.layout;
+	barrier.newLayout = newstate.layout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = baseMipLevel;
+	barrier.subresourceRange.levelCount = levelCount;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+	m_imageBarriers.push_back(barrier);
+
+	state = newstate;
+}
+
+void spoutVKbarriers::Memory(VkPipelineStageFlags2 srcStages, VkAccessFlags2 srcAccess,
+	VkPipelineStageFlags2 dstStages, VkAccessFlags2 dstAccess)
+{
+	VkMemoryBarrier2 barrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+	barrier.srcStageMask = srcStages;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstStageMask = dstStages;
+	barrier.dstAccessMask = dstAccess;
+	m_memoryBarriers.push_back(barrier);
+}
+
+void spoutVKbarriers::Flush(VkCommandBuffer commandBuffer)
+{
+	if (m_imageBarriers.empty() && m_memoryBarriers.empty())
+		return;
+
+	if (m_pfnCmdPipelineBarrier2) {
+		VkDependencyInfo dependencyInfo = { VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+		dependencyInfo.memoryBarrierCount = (uint32_t)m_memoryBarriers.size();
+		dependencyInfo.pMemoryBarriers = m_memoryBarriers.data();
+		dependencyInfo.imageMemoryBarrierCount = (uint32_t)m_imageBarriers.size();
+		dependencyInfo.pImageMemoryBarriers = m_imageBarriers.data();
+		m_pfnCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+	}
+	else {
+		//
+		// Classic barriers are recorded with one call using the combined stages.
+		// The stage and access bits used have the same values for both APIs.
+		//
+		VkPipelineStageFlags srcStages = 0;
+		VkPipelineStageFlags dstStages = 0;
+
+		std::vector<VkMemoryBarrier> memoryBarriers;
+		for (const VkMemoryBarrier2& b : m_memoryBarriers) {
+			VkMemoryBarrier barrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+			barrier.srcAccessMask = (VkAccessFlags)b.srcAccessMask;
+			barrier.dstAccessMask = (VkAccessFlags)b.dstAccessMask;
+			srcStages |= (VkPipelineStageFlags)b.srcStageMask;
+			dstStages |= (VkPipelineStageFlags)b.dstStageMask;
+			memoryBarriers.push_back(barrier);
+		}
+
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+		for (const VkImageMemoryBarrier2& b : m_imageBarriers) {
+			VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+			barrier.srcAccessMask = (VkAccessFlags)b.srcAccessMask;
+			barrier.dstAccessMask = (VkAccessFlags)b.dstAccessMask;
+			barrier.oldLayout = b.oldLayout;
+			barrier.newLayout = b.newLayout;
+			barrier.srcQueueFamilyIndex = b.srcQueueFamilyIndex;
+			barrier.dstQueueFamilyIndex = b.dstQueueFamilyIndex;
+			barrier.image = b.image;
+			barrier.subresourceRange = b.subresourceRange;
+			srcStages |= (VkPipelineStageFlags)b.srcStageMask;
+			dstStages |= (VkPipelineStageFlags)b.dstStageMask;
+			imageBarriers.push_back(barrier);
+		}
+
+		// No stages is not allowed for the classic barrier
+		if (!srcStages) srcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		if (!dstStages) dstStages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, srcStages, dstStages, 0,
+			(uint32_t)memoryBarriers.size(), memoryBarriers.data(),
+			0, nullptr,
+			(uint32_t)imageBarriers.size(), imageBarriers.data());
+	}
+
+	m_imageBarriers.clear();
+	m_memoryBarriers.clear();
+}
+
+//
+// Stages and access for an image in a given layout.
+//
+// An image in the present layout was last written as a colour attachment.
+// Following presentation is synchronized with semaphores, so that no stage
+// or access is waited for before the present.
+//
+spoutVKimageState spoutVKbarriers::GetLayoutState(VkImageLayout layout, bool bPrevious)
+{
+	spoutVKimageState state;
+	state.layout = layout;
+
+	switch (layout) {
+		case VK_IMAGE_LAYOUT_UNDEFINED:
+			break;
+		case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+			state.stages = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+			state.access = VK_ACCESS_2_TRANSFER_READ_BIT;
+			break;
+		case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+			state.stages = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+			state.access = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			break;
+		case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+			state.stages = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+			state.access = VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+			break;
+		case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+			state.stages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+			state.access = VK_ACCESS_2_SHADER_READ_BIT;
+			break;
+		case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+			if (bPrevious) {
+				state.stages = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+				state.access = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+			}
+			break;
+		case VK_IMAGE_LAYOUT_GENERAL:
+		default:
+			state.stages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+			state.access = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+			break;
+	}
+
+	return state;
+}
+
+//
+// Sender pool
+//
+
+spoutVKSenderPool::spoutVKSenderPool()
+{
+	// One D3D11 device for the textures of all senders
+	if (spoutdx.OpenDirectX11())
+		m_pD3D11Device = spoutdx.GetDX11Device();
+}
+
+spoutVKSenderPool::~spoutVKSenderPool()
+{
+	// Vulkan resources are released by ReleaseSenders
+	for (auto& sender : m_Senders) {
+		if (sender)
+			ReleaseSender(nullptr, *sender);
+	}
+	if (m_pD3D11Device)
+		spoutdx.CloseDirectX11();
+}
+
+int spoutVKSenderPool::AddSender(const char* sendername)
+{
+	if (!sendername || !sendername[0])
+		return -1;
+
+	// Increment the name if a sender with this name is already registered,
+	// or added to the pool and not yet registered by SendImages
+	std::unique_ptr<PoolSender> sender = std::make_unique<PoolSender>();
+	strcpy_s(sender->name, 256, sendername);
+	int n = 1;
+	while (sendernames.FindSenderName(sender->name) || HasSenderName(sender->name)) {
+		sprintf_s(sender->name, 256, "%s_%d", sendername, n);
+		n++;
+	}
+
+	// The sender is created by SendImages for the size and format of the source
+	m_Senders.push_back(std::move(sender));
+	return (int)m_Senders.size() - 1;
+}
+
+bool spoutVKSenderPool::HasSenderName(const char* sendername)
+{
+	for (const auto& sender : m_Senders) {
+		if (sender && strcmp(sender->name, sendername) == 0)
+			return true;
+	}
+	return false;
+}
+
+void spoutVKSenderPool::RemoveSender(VkDevice logicaldevice, int index)
+{
+	if (index < 0 || index >= (int)m_Senders.size() || !m_Senders[index])
+		return;
+
+	vkDeviceWaitIdle(logicaldevice);
+	ReleaseSender(logicaldevice, *m_Senders[index]);
+	m_Senders[index].reset();
+}
+
+uint32_t spoutVKSenderPool::GetSenderCount()
+{
+	return (uint32_t)m_Senders.size();
+}
+
+const char* spoutVKSenderPool::GetSenderName(int index)
+{
+	if (index < 0 || index >= (int)m_Senders.size() || !m_Senders[index])
+		return nullptr;
+	return m_Senders[index]->name;
+}
+
+bool spoutVKSenderPool::EnableSynchronization2(VkDevice logicaldevice, bool bEnable)
+{
+	return m_barriers.EnableSynchronization2(logicaldevice, bEnable);
+}
+
+//
+// 1) Create or update senders for the source sizes and formats,
+//    waiting for the device once if any linked image is re-created
+// 2) Get access to all the shared textures
+// 3) Transition all source and linked images with one barrier
+// 4) Copy each source to the linked image of its sender
+// 5) Return the sources to their layouts with one barrier
+// 6) Allow access and signal a new frame for all senders
+//
+// The linked image of each sender has the size and format of its source,
+// so that the images can always be copied.
+//
+bool spoutVKSenderPool::SendImages(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	VkCommandBuffer commandbuffer, const spoutVKsource* sources, uint32_t count)
+{
+	if (!spoutVK::CheckVulkanExtensions(physicaldevice)) {
+		SpoutLogError("spoutVKSenderPool::SendImages - required Vulkan extensions not supported");
+		return false;
+	}
+
+	if (!m_pD3D11Device || !sources)
+		return false;
+
+	count = std::min(count, (uint32_t)m_Senders.size());
+
+	// 1) Senders to create or update
+	bool bWait = false;
+	for (uint32_t i = 0; i < count; i++) {
+		const PoolSender* sender = m_Senders[i].get();
+		if (sender && sender->image && sources[i].image
+			&& (sender->width != sources[i].width || sender->height != sources[i].height
+				|| sender->dwFormat != spoutVK::GetD3Dformat(sources[i].format)))
+			bWait = true;
+	}
+	if (bWait)
+		vkDeviceWaitIdle(logicaldevice);
+
+	// 2) Senders with access to their shared texture
+	std::vector<uint32_t> active;
+	active.reserve(count);
+	for (uint32_t i = 0; i < count; i++) {
+		PoolSender* sender = m_Senders[i].get();
+		if (!sender || !sources[i].image)
+			continue;
+		if (!UpdateSender(physicaldevice, logicaldevice, *sender, sources[i]))
+			continue;
+		if (sender->frame.CheckAccess())
+			active.push_back(i);
+	}
+	if (active.empty())
+		return false;
+
+	// A source image can be sent by more than one sender,
+	// so its state is retained once for all.
+	std::vector<VkImage> srcImages;
+	std::vector<spoutVKimageState> srcStates;
+	for (uint32_t i : active) {
+		if (std::find(srcImages.begin(), srcImages.end(), sources[i].image) == srcImages.end()) {
+			srcImages.push_back(sources[i].image);
+			srcStates.push_back(spoutVKbarriers::GetLayoutState(sources[i].layout, true));
+		}
+	}
+
+	// 3) One barrier for all images
+	spoutVKimageState transferSrc = spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+	spoutVKimageState transferDst = spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	for (size_t j = 0; j < srcImages.size(); j++)
+		m_barriers.Transition(srcImages[j], srcStates[j], transferSrc);
+	// Sender images are in GENERAL between frames for other processes.
+	// The transition from GENERAL is always recorded.
+	for (uint32_t i : active) {
+		m_Senders[i]->state = spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_GENERAL, true);
+		m_barriers.Transition(m_Senders[i]->image, m_Senders[i]->state, transferDst);
+	}
+	m_barriers.Flush(commandbuffer);
+
+	// 4) Copy
+	for (uint32_t i : active) {
+		VkImageCopy copyRegion {};
+		copyRegion.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		copyRegion.dstSubresource = copyRegion.srcSubresource;
+		copyRegion.extent = { sources[i].width, sources[i].height, 1 };
+		vkCmdCopyImage(commandbuffer,
+			sources[i].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			m_Senders[i]->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1, &copyRegion);
+	}
+
+	// 5) Sources are returned to their layouts and sender images to GENERAL
+	for (uint32_t i : active)
+		m_barriers.Transition(m_Senders[i]->image, m_Senders[i]->state,
+			spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_GENERAL));
+	for (size_t j = 0; j < srcImages.size(); j++) {
+		for (uint32_t i : active) {
+			if (sources[i].image == srcImages[j]) {
+				m_barriers.Transition(srcImages[j], srcStates[j],
+					spoutVKbarriers::GetLayoutState(sources[i].layout));
+				break;
+			}
+		}
+	}
+	m_barriers.Flush(commandbuffer);
+
+	// 6) New frames for all senders
+	for (uint32_t i : active) {
+		PoolSender* sender = m_Senders[i].get();
+		sender->frame.AllowAccess();
+		sender->frame.SetNewFrame();
+		char* pBuffer = sender->info.Lock();
+		if (pBuffer) {
+			spoutVKinfo* pInfo = (spoutVKinfo*)pBuffer;
+			pInfo->size = sizeof(spoutVKinfo);
+			pInfo->version = SPOUTVK_INFO_VERSION;
+			pInfo->frame = sender->frame.GetSenderFrame();
+			pInfo->dirtyRect = { { 0, 0 }, { sender->width, sender->height } };
+			sender->info.Unlock();
+		}
+	}
+
+	return true;
+}
+
+// Create the sender, or update it for a change of source size or format
+bool spoutVKSenderPool::UpdateSender(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	PoolSender& sender, const spoutVKsource& source)
+{
+	DWORD dwFormat = spoutVK::GetD3Dformat(source.format);
+	bool bChanged = !sender.image || sender.width != source.width
+		|| sender.height != source.height || sender.dwFormat != dwFormat;
+	if (!bChanged && sender.bCreated)
+		return true;
+
+	if (bChanged) {
+		if (spoutVK::GetVulkanFormat(dwFormat) != source.format) {
+			SpoutLogWarning("spoutVKSenderPool::UpdateSender - format %d not supported for %s", source.format, sender.name);
+			return false;
+		}
+
+		// The device is idle (SendImages).
+		// A registered sender is released if the texture cannot be replaced,
+		// so that receivers do not find a share handle that is not updated.
+		if (sender.image) vkDestroyImage(logicaldevice, sender.image, nullptr);
+		if (sender.memory) vkFreeMemory(logicaldevice, sender.memory, nullptr);
+		if (sender.texture) spoutdx.ReleaseDX11Texture(sender.texture);
+		sender.image = nullptr;
+		sender.memory = nullptr;
+		sender.texture = nullptr;
+		sender.shareHandle = nullptr;
+
+		if (!spoutdx.CreateSharedDX11Texture(m_pD3D11Device, source.width, source.height,
+			(DXGI_FORMAT)dwFormat, &sender.texture, sender.shareHandle)) {
+			SpoutLogWarning("spoutVKSenderPool::UpdateSender - could not create texture for %s", sender.name);
+			ReleaseSender(logicaldevice, sender);
+			return false;
+		}
+
+		if (!spoutVK::ImportD3D11Texture(physicaldevice, logicaldevice, sender.shareHandle,
+			source.width, source.height, dwFormat, sender.image, sender.memory)) {
+			SpoutLogWarning("spoutVKSenderPool::UpdateSender - could not link image for %s", sender.name);
+			ReleaseSender(logicaldevice, sender);
+			return false;
+		}
+		sender.width = source.width;
+		sender.height = source.height;
+		sender.dwFormat = dwFormat;
+	}
+
+	// A sender that is not registered is not copied,
+	// so registration is tried again with the next frame
+	if (!sender.bCreated) {
+		if (!sendernames.CreateSender(sender.name, source.width, source.height, sender.shareHandle, dwFormat)) {
+			SpoutLogWarning("spoutVKSenderPool::UpdateSender - could not create sender %s", sender.name);
+			return false;
+		}
+		sender.frame.CreateAccessMutex(sender.name);
+		sender.frame.EnableFrameCount(sender.name);
+		// The sender information as written by spoutVK::CreateSenderInfo
+		std::string infoname = std::string(sender.name) + "_vkinfo";
+		if (sender.info.Create(infoname.c_str(), SPOUTVK_INFO_MAPSIZE) != SPOUT_CREATE_FAILED) {
+			char* pBuffer = sender.info.Lock();
+			if (pBuffer) {
+				spoutVKinfo* pInfo = (spoutVKinfo*)pBuffer;
+				*pInfo = {};
+				pInfo->size = sizeof(spoutVKinfo);
+				pInfo->version = SPOUTVK_INFO_VERSION;
+				pInfo->dirtyRect = { { 0, 0 }, { source.width, source.height } };
+				pInfo->receiverSlots = SPOUTVK_RECEIVER_SLOTS;
+				pInfo->senderPid = (uint32_t)GetCurrentProcessId();
+				sender.info.Unlock();
+			}
+		}
+		sender.bCreated = true;
+	}
+	else {
+		sendernames.UpdateSender(sender.name, source.width, source.height, sender.shareHandle, dwFormat);
+	}
+
+	return true;
+}
+
+// Vulkan resources are not released without a device
+void spoutVKSenderPool::ReleaseSender(VkDevice logicaldevice, PoolSender& sender)
+{
+	if (sender.bCreated) {
+		sendernames.ReleaseSenderName(sender.name);
+		sender.frame.CloseAccessMutex();
+		sender.frame.CleanupFrameCount();
+		sender.info.Close();
+		sender.bCreated = false;
+	}
+	if (logicaldevice) {
+		if (sender.image) vkDestroyImage(logicaldevice, sender.image, nullptr);
+		if (sender.memory) vkFreeMemory(logicaldevice, sender.memory, nullptr);
+		sender.image = nullptr;
+		sender.memory = nullptr;
+	}
+	if (sender.texture) {
+		spoutdx.ReleaseDX11Texture(sender.texture);
+		sender.texture = nullptr;
+		sender.shareHandle = nullptr;
+	}
+}
+
+void spoutVKSenderPool::ReleaseSenders(VkDevice logicaldevice)
+{
+	if (logicaldevice)
+		vkDeviceWaitIdle(logicaldevice);
+	for (auto& sender : m_Senders) {
+		if (sender)
+			ReleaseSender(logicaldevice, *sender);
+	}
+	m_Senders.clear();
+}
+
+//
+// Multiple sender receiver
+//
+
+spoutVKMultiReceiver::spoutVKMultiReceiver()
+{
+	m_ReceiverId = spoutVK::NewReceiverId();
+}
+
+spoutVKMultiReceiver::~spoutVKMultiReceiver()
+{
+	// Vulkan resources are released by ReleaseReceivers
+	for (auto& sender : m_Senders) {
+		if (sender)
+			ReleaseSender(nullptr, *sender);
+	}
+	for (auto& sender : m_Removed)
+		ReleaseSender(nullptr, *sender);
+}
+
+void spoutVKMultiReceiver::SetSenders(const char* const* names, uint32_t count)
+{
+	std::vector<std::unique_ptr<MultiSender>> senders;
+	for (uint32_t i = 0; i < count; i++) {
+		std::unique_ptr<MultiSender> sender;
+		const char* name = names ? names[i] : nullptr;
+		// Retain a sender already received
+		if (name && *name) {
+			for (auto& s : m_Senders) {
+				if (s && strcmp(s->name, name) == 0) {
+					sender = std::move(s);
+					break;
+				}
+			}
+		}
+		if (!sender) {
+			sender = std::make_unique<MultiSender>();
+			if (name)
+				strcpy_s(sender->name, 256, name);
+		}
+		senders.push_back(std::move(sender));
+	}
+
+	// Senders no longer in the list might still be in use by the device
+	for (auto& s : m_Senders) {
+		if (s)
+			m_Removed.push_back(std::move(s));
+	}
+	m_Senders = std::move(senders);
+}
+
+uint32_t spoutVKMultiReceiver::GetSenderCount()
+{
+	return (uint32_t)m_Senders.size();
+}
+
+const char* spoutVKMultiReceiver::GetSenderName(uint32_t index)
+{
+	if (index >= m_Senders.size())
+		return nullptr;
+	return m_Senders[index]->name;
+}
+
+bool spoutVKMultiReceiver::IsConnected(uint32_t index)
+{
+	return index < m_Senders.size() && m_Senders[index]->bConnected && m_Senders[index]->image;
+}
+
+uint32_t spoutVKMultiReceiver::GetSenderWidth(uint32_t index)
+{
+	return IsConnected(index) ? m_Senders[index]->width : 0;
+}
+
+uint32_t spoutVKMultiReceiver::GetSenderHeight(uint32_t index)
+{
+	return IsConnected(index) ? m_Senders[index]->height : 0;
+}
+
+VkFormat spoutVKMultiReceiver::GetSenderFormat(uint32_t index)
+{
+	return IsConnected(index) ? spoutVK::GetVulkanFormat(m_Senders[index]->dwFormat) : VK_FORMAT_UNDEFINED;
+}
+
+bool spoutVKMultiReceiver::EnableSynchronization2(VkDevice logicaldevice, bool bEnable)
+{
+	return m_barriers.EnableSynchronization2(logicaldevice, bEnable);
+}
+
+bool spoutVKMultiReceiver::ReceiveLayers(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	VkCommandBuffer commandbuffer, VkImage arrayimage, VkImageLayout layout,
+	VkFormat format, uint32_t width, uint32_t height, uint32_t layers)
+{
+	return ReceiveRegions(physicaldevice, logicaldevice, commandbuffer,
+		arrayimage, layout, format, width, height, 0, layers);
+}
+
+bool spoutVKMultiReceiver::ReceiveAtlas(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	VkCommandBuffer commandbuffer, VkImage atlasimage, VkImageLayout layout,
+	VkFormat format, uint32_t tilewidth, uint32_t tileheight,
+	uint32_t columns, uint32_t rows)
+{
+	if (columns == 0)
+		return false;
+	return ReceiveRegions(physicaldevice, logicaldevice, commandbuffer,
+		atlasimage, layout, format, tilewidth, tileheight, columns, rows);
+}
+
+//
+// 1) Find all the senders in the list,
+//    waiting for the device once if any linked image is re-created or released
+// 2) Link new senders and those with a new size, format or share handle
+// 3) Get access to all the shared textures
+//
+// Returns true if access was gained for any sender.
+// Access is held until EndReceive.
+//
+bool spoutVKMultiReceiver::BeginReceive(VkPhysicalDevice physicaldevice, VkDevice logicaldevice, uint32_t count)
+{
+	if (!spoutVK::CheckVulkanExtensions(physicaldevice)) {
+		SpoutLogError("spoutVKMultiReceiver::BeginReceive - required Vulkan extensions not supported");
+		return false;
+	}
+
+	if (m_vkDevice && m_vkDevice != logicaldevice) {
+		SpoutLogError("spoutVKMultiReceiver::BeginReceive - release receivers before changing device");
+		return false;
+	}
+	m_vkDevice = logicaldevice;
+	m_vkPhysicalDevice = physicaldevice;
+
+	count = (std::min)(count, (uint32_t)m_Senders.size());
+
+	// 1) Find the senders
+	std::vector<bool> bFound(count, false);
+	std::vector<bool> bLink(count, false);
+	for (uint32_t i = 0; i < count; i++) {
+		MultiSender& sender = *m_Senders[i];
+		if (!sender.name[0])
+			continue;
+		unsigned int width = sender.width;
+		unsigned int height = sender.height;
+		HANDLE shareHandle = sender.shareHandle;
+		DWORD dwFormat = sender.dwFormat;
+		bFound[i] = sendernames.FindSender(sender.name, width, height, shareHandle, dwFormat);
+		if (bFound[i]) {
+			if (!sender.image || width != sender.width || height != sender.height
+				|| dwFormat != sender.dwFormat || shareHandle != sender.shareHandle) {
+				bLink[i] = true;
+				sender.width = width;
+				sender.height = height;
+				sender.dwFormat = dwFormat;
+				sender.shareHandle = shareHandle;
+			}
+		}
+	}
+
+	// Linked images replaced or no longer received might still be in use by frames in flight
+	for (auto& sender : m_Removed) {
+		RetireSender(*sender);
+		ReleaseSender(logicaldevice, *sender);
+	}
+	m_Removed.clear();
+
+	// 2) Link the senders
+	for (uint32_t i = 0; i < count; i++) {
+		MultiSender& sender = *m_Senders[i];
+		if (!bFound[i]) {
+			// The sender has closed
+			RetireSender(sender);
+			if (sender.bConnected)
+				ReleaseSender(logicaldevice, sender);
+			continue;
+		}
+
+		if (!sender.bConnected) {
+			sender.frame.CreateAccessMutex(sender.name);
+			sender.frame.EnableFrameCount(sender.name);
+			sender.bConnected = true;
+		}
+		RegisterSender(sender);
+
+		if (bLink[i]) {
+			RetireSender(sender);
+			if (!spoutVK::ImportD3D11Texture(physicaldevice, logicaldevice, sender.shareHandle,
+				sender.width, sender.height, sender.dwFormat, sender.image, sender.memory)) {
+				SpoutLogWarning("spoutVKMultiReceiver::BeginReceive - could not link image for %s", sender.name);
+				continue;
+			}
+			sender.link = ++m_LinkClock;
+		}
+	}
+	ReleaseRetired(logicaldevice, false);
+
+	// 3) Access to the shared textures
+	bool bAccess = false;
+	for (uint32_t i = 0; i < count; i++) {
+		MultiSender& sender = *m_Senders[i];
+		if (sender.bConnected && sender.image && sender.frame.CheckAccess()) {
+			// The sender might have written since the last receive,
+			// so the transition from GENERAL is always recorded
+			sender.state = spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_GENERAL, true);
+			sender.bAccess = true;
+			bAccess = true;
+		}
+	}
+
+	return bAccess;
+}
+
+// Linked images share memory with textures used by other processes
+// in GENERAL layout, so they are returned to it before access is released
+void spoutVKMultiReceiver::EndReceive(VkCommandBuffer commandbuffer)
+{
+	for (auto& sender : m_Senders) {
+		if (sender->bAccess && sender->state.layout != VK_IMAGE_LAYOUT_GENERAL)
+			m_barriers.Transition(sender->image, sender->state,
+				spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_GENERAL));
+	}
+	m_barriers.Flush(commandbuffer);
+
+	for (auto& sender : m_Senders) {
+		if (sender->bAccess) {
+			sender->frame.AllowAccess();
+			sender->bAccess = false;
+		}
+	}
+}
+
+//
+// Copy each sender to a layer of an array image (columns = 0)
+// or a tile of an atlas image, with one barrier before and one after.
+// Senders beyond the layers of an array image or the rows of an atlas
+// are not copied.
+//
+bool spoutVKMultiReceiver::ReceiveRegions(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	VkCommandBuffer commandbuffer, VkImage image, VkImageLayout layout,
+	VkFormat format, uint32_t width, uint32_t height, uint32_t columns, uint32_t layers)
+{
+	if (!image || width == 0 || height == 0 || layers == 0)
+		return false;
+
+	if (!BeginReceive(physicaldevice, logicaldevice, (uint32_t)m_Senders.size()))
+		return false;
+
+	// One barrier for all images. All layers of the destination are transitioned.
+	spoutVKimageState dstState = spoutVKbarriers::GetLayoutState(layout, true);
+	spoutVKimageState transferSrc = spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+	for (auto& sender : m_Senders) {
+		if (sender->bAccess)
+			m_barriers.Transition(sender->image, sender->state, transferSrc);
+	}
+	m_barriers.Transition(image, dstState,
+		spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+	m_barriers.Flush(commandbuffer);
+
+	bool bBlitDst = (GetFormatFeatures(physicaldevice, format) & VK_FORMAT_FEATURE_BLIT_DST_BIT) != 0;
+	for (uint32_t i = 0; i < (uint32_t)m_Senders.size(); i++) {
+		const MultiSender& sender = *m_Senders[i];
+		if (!sender.bAccess)
+			continue;
+
+		uint32_t layer = i;
+		int32_t x = 0;
+		int32_t y = 0;
+		if (columns == 0 && layer >= layers)
+			break;
+		if (columns > 0 && i / columns >= layers)
+			break;
+		if (columns > 0) {
+			layer = 0;
+			x = (int32_t)((i % columns)*width);
+			y = (int32_t)((i / columns)*height);
+		}
+
+		VkFormat srcFormat = spoutVK::GetVulkanFormat(sender.dwFormat);
+		VkFormatFeatureFlags srcFeatures = GetFormatFeatures(physicaldevice, srcFormat);
+		if (bBlitDst && (srcFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT)) {
+			VkImageBlit blitRegion {};
+			blitRegion.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+			blitRegion.srcOffsets[1] = { (int32_t)sender.width, (int32_t)sender.height, 1 };
+			blitRegion.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, layer, 1 };
+			blitRegion.dstOffsets[0] = { x, y, 0 };
+			blitRegion.dstOffsets[1] = { x + (int32_t)width, y + (int32_t)height, 1 };
+			VkFilter filter = VK_FILTER_NEAREST;
+			if ((sender.width != width || sender.height != height)
+				&& (srcFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+				filter = VK_FILTER_LINEAR;
+			vkCmdBlitImage(commandbuffer,
+				sender.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				1, &blitRegion, filter);
+		}
+		else if (sender.width == width && sender.height == height
+			&& spoutVK::GetBytesPerPixel(srcFormat) == spoutVK::GetBytesPerPixel(format)) {
+			VkImageCopy copyRegion {};
+			copyRegion.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+			copyRegion.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, layer, 1 };
+			copyRegion.dstOffset = { x, y, 0 };
+			copyRegion.extent = { width, height, 1 };
+			vkCmdCopyImage(commandbuffer,
+				sender.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				1, &copyRegion);
+		}
+		else if (!m_bCopyWarning) {
+			SpoutLogWarning("spoutVKMultiReceiver::ReceiveRegions - no copy method for %s", sender.name);
+			m_bCopyWarning = true;
+		}
+	}
+
+	// Return the destination to the layout passed in
+	m_barriers.Transition(image, dstState, spoutVKbarriers::GetLayoutState(layout));
+	m_barriers.Flush(commandbuffer);
+
+	EndReceive(commandbuffer);
+
+	return true;
+}
+
+//
+// Composite
+//
+// The senders are sampled by one compute dispatch into a buffer packed
+// for the destination format, which is then copied to the destination.
+// Placements are written to a uniform buffer by the command buffer,
+// so that frames in flight each use their own.
+//
+bool spoutVKMultiReceiver::ReceiveComposite(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	VkCommandBuffer commandbuffer, VkImage image, VkImageLayout layout,
+	VkFormat format, uint32_t width, uint32_t height,
+	const spoutVKplacement* placements)
+{
+	// Destination formats packed by the shader
+	uint32_t dstCode = 0;
+	switch (format) {
+		case VK_FORMAT_R8G8B8A8_UNORM:           dstCode = 0; break;
+		case VK_FORMAT_B8G8R8A8_UNORM:           dstCode = 1; break;
+		case VK_FORMAT_A2B10G10R10_UNORM_PACK32: dstCode = 2; break;
+		case VK_FORMAT_R16G16B16A16_UNORM:       dstCode = 3; break;
+		case VK_FORMAT_R16G16B16A16_SFLOAT:      dstCode = 4; break;
+		case VK_FORMAT_R32G32B32A32_SFLOAT:      dstCode = 5; break;
+		default:
+			SpoutLogWarning("spoutVKMultiReceiver::ReceiveComposite - format %d not supported", format);
+			return false;
+	}
+
+	if (!image || width == 0 || height == 0)
+		return false;
+
+	uint32_t count = (std::min)((uint32_t)m_Senders.size(), (uint32_t)SPOUTVK_COMPOSITE_LAYERS);
+	if (!BeginReceive(physicaldevice, logicaldevice, count))
+		return false;
+
+	if (!CreateComposite(logicaldevice)) {
+		EndReceive(commandbuffer);
+		return false;
+	}
+
+	// Buffer for the packed destination pixels
+	VkDeviceSize bufferSize = (VkDeviceSize)width * height * spoutVK::GetBytesPerPixel(format);
+	if (!m_vkOutput || bufferSize > m_OutputSize) {
+		if (m_vkOutput) {
+			vkDeviceWaitIdle(logicaldevice);
+			vkDestroyBuffer(logicaldevice, m_vkOutput, nullptr);
+			vkFreeMemory(logicaldevice, m_vkOutputMemory, nullptr);
+		}
+		m_vkOutput = nullptr;
+		m_vkOutputMemory = nullptr;
+		m_OutputSize = 0;
+		if (!CreateBuffer(bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			m_vkOutput, m_vkOutputMemory)) {
+			EndReceive(commandbuffer);
+			return false;
+		}
+		m_OutputSize = bufferSize;
+	}
+
+	//
+	// Placements and descriptors
+	//
+	// Every element of the image array must be valid, so senders
+	// without access use the view of another with alpha zero.
+	//
+	struct {
+		float rect[SPOUTVK_COMPOSITE_LAYERS][4];
+		float opacity[SPOUTVK_COMPOSITE_LAYERS][4];
+	} place = {};
+	uint32_t columns = (uint32_t)ceilf(sqrtf((float)count));
+	uint32_t rows = (count + columns - 1) / columns;
+	VkImageView views[SPOUTVK_COMPOSITE_LAYERS] = {};
+	VkSampler samplers[SPOUTVK_COMPOSITE_LAYERS] = {};
+	VkImageView anyView = nullptr;
+	VkSampler anySampler = m_vkSamplerNearest;
+	for (uint32_t i = 0; i < count; i++) {
+		MultiSender& sender = *m_Senders[i];
+		if (placements) {
+			place.rect[i][0] = placements[i].x;
+			place.rect[i][1] = placements[i].y;
+			place.rect[i][2] = placements[i].width;
+			place.rect[i][3] = placements[i].height;
+			place.opacity[i][0] = placements[i].alpha;
+		}
+		else {
+			place.rect[i][0] = (float)((i % columns)*width) / (float)columns;
+			place.rect[i][1] = (float)((i / columns)*height) / (float)rows;
+			place.rect[i][2] = (float)width / (float)columns;
+			place.rect[i][3] = (float)height / (float)rows;
+			place.opacity[i][0] = 1.0f;
+		}
+		if (!sender.bAccess) {
+			place.opacity[i][0] = 0.0f;
+			continue;
+		}
+
+		if (!GetSenderView(logicaldevice, sender)) {
+			place.opacity[i][0] = 0.0f;
+			continue;
+		}
+		views[i] = sender.view;
+		VkFormatFeatureFlags features = GetFormatFeatures(physicaldevice, spoutVK::GetVulkanFormat(sender.dwFormat));
+		samplers[i] = (features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+			? m_vkSamplerLinear : m_vkSamplerNearest;
+		if (!anyView) {
+			anyView = views[i];
+			anySampler = samplers[i];
+		}
+	}
+	if (!anyView) {
+		EndReceive(commandbuffer);
+		return false;
+	}
+	for (uint32_t i = 0; i < SPOUTVK_COMPOSITE_LAYERS; i++) {
+		if (!views[i]) {
+			views[i] = anyView;
+			samplers[i] = anySampler;
+		}
+	}
+
+	// Update the descriptors if the views or buffer have changed.
+	// The set must not be in use by the device while it is updated.
+	if (memcmp(views, m_SetViews, sizeof(views)) != 0
+		|| memcmp(samplers, m_SetSamplers, sizeof(samplers)) != 0
+		|| m_vkOutput != m_SetOutput) {
+		if (m_SetOutput)
+			vkDeviceWaitIdle(logicaldevice);
+		VkDescriptorImageInfo imageInfo[SPOUTVK_COMPOSITE_LAYERS] = {};
+		for (uint32_t i = 0; i < SPOUTVK_COMPOSITE_LAYERS; i++)
+			imageInfo[i] = { samplers[i], views[i], VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		VkDescriptorBufferInfo outputInfo = { m_vkOutput, 0, VK_WHOLE_SIZE };
+		VkDescriptorBufferInfo placementInfo = { m_vkPlacements, 0, VK_WHOLE_SIZE };
+		VkWriteDescriptorSet writes[3] = {};
+		writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[0].dstSet = m_vkSet;
+		writes[0].dstBinding = 0;
+		writes[0].descriptorCount = SPOUTVK_COMPOSITE_LAYERS;
+		writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].pImageInfo = imageInfo;
+		writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[1].dstSet = m_vkSet;
+		writes[1].dstBinding = 1;
+		writes[1].descriptorCount = 1;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[1].pBufferInfo = &outputInfo;
+		writes[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[2].dstSet = m_vkSet;
+		writes[2].dstBinding = 2;
+		writes[2].descriptorCount = 1;
+		writes[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		writes[2].pBufferInfo = &placementInfo;
+		vkUpdateDescriptorSets(logicaldevice, 3, writes, 0, nullptr);
+		memcpy(m_SetViews, views, sizeof(views));
+		memcpy(m_SetSamplers, samplers, sizeof(samplers));
+		m_SetOutput = m_vkOutput;
+	}
+
+	// One barrier for the senders, and for the buffers used by the last frame
+	spoutVKimageState shaderRead = spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	for (uint32_t i = 0; i < count; i++) {
+		MultiSender& sender = *m_Senders[i];
+		if (sender.bAccess && sender.view)
+			m_barriers.Transition(sender.image, sender.state, shaderRead);
+	}
+	m_barriers.Memory(VK_PIPELINE_STAGE_2_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, 0,
+		VK_PIPELINE_STAGE_2_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+		VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_WRITE_BIT);
+	m_barriers.Flush(commandbuffer);
+
+	vkCmdUpdateBuffer(commandbuffer, m_vkPlacements, 0, sizeof(place), &place);
+
+	spoutVKimageState dstState = spoutVKbarriers::GetLayoutState(layout, true);
+	m_barriers.Memory(VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_UNIFORM_READ_BIT);
+	m_barriers.Transition(image, dstState,
+		spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+	m_barriers.Flush(commandbuffer);
 
-	// Enable frame counting so the receiver gets frame number and fps
-	frame.EnableFrameCount(m_SenderName);
+	struct {
+		uint32_t dstSize[2];
+		uint32_t format;
+		uint32_t count;
+	} params = { { width, height }, dstCode, count };
 
-	// Update globals
-	m_Width = width;
-	m_Height = height;
+	vkCmdBindPipeline(commandbuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vkPipeline);
+	vkCmdBindDescriptorSets(commandbuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+		m_vkPipelineLayout, 0, 1, &m_vkSet, 0, nullptr);
+	vkCmdPushConstants(commandbuffer, m_vkPipelineLayout,
+		VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+	vkCmdDispatch(commandbuffer, (width + 15) / 16, (height + 15) / 16, 1);
+
+	// Copy the packed pixels to the destination image
+	m_barriers.Memory(VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+	m_barriers.Flush(commandbuffer);
+
+	VkBufferImageCopy region {};
+	region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	region.imageExtent = { width, height, 1 };
+	vkCmdCopyBufferToImage(commandbuffer, m_vkOutput, image,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+	m_barriers.Transition(image, dstState, spoutVKbarriers::GetLayoutState(layout));
+	m_barriers.Flush(commandbuffer);
+
+	EndReceive(commandbuffer);
 
 	return true;
 }
 
-// o Create a DirectX11 shared texture and share handle.
-// o Create a Vulkan image and link with the DirectX11 memory
-//   using the texture share handle
-// o Create a sender
-// o For a size change, update images and the sender
-bool spoutVK::CheckSender(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
-	std::string sendername, uint32_t width, uint32_t height, DWORD dwFormat)
+// Create the composite pipeline from the embedded shader
+bool spoutVKMultiReceiver::CreateComposite(VkDevice logicaldevice)
 {
-	// Ensure the GPU is not using the resources
-	vkDeviceWaitIdle(logicaldevice);
+	if (m_vkPipeline)
+		return true;
 
-	if (!m_bInitialized) {
-		// Create a D3D11 shared texture with a share handle (m_dxShareHandle)
-		// that will be used to link the texture with a Vulkan Image
-		
-		if (CreateSharedDX11texture(width, height, dwFormat)) {
-			// Create a Vulkan image and link with the D3D11 texture memory
-			if (LinkVulkanImage(physicaldevice, logicaldevice,
-				m_dxShareHandle, width, height, dwFormat)) {
-				// Create a sender using the shared texure handle
-				// which is linked to the Vulkan image
-				CreateSender(sendername.c_str(), width, height, dwFormat);
-				m_bInitialized = true;
-			}
-		}
+	VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	vkCreateSampler(logicaldevice, &samplerInfo, nullptr, &m_vkSamplerLinear);
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	vkCreateSampler(logicaldevice, &samplerInfo, nullptr, &m_vkSamplerNearest);
+
+	VkDescriptorSetLayoutBinding bindings[3] = {};
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[0].descriptorCount = SPOUTVK_COMPOSITE_LAYERS;
+	bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	bindings[1].binding = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[1].descriptorCount = 1;
+	bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	bindings[2].binding = 2;
+	bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	bindings[2].descriptorCount = 1;
+	bindings[2].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	VkDescriptorSetLayoutCreateInfo layoutInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+	layoutInfo.bindingCount = 3;
+	layoutInfo.pBindings = bindings;
+	if (vkCreateDescriptorSetLayout(logicaldevice, &layoutInfo, nullptr, &m_vkSetLayout) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVKMultiReceiver::CreateComposite - could not create descriptor set layout");
+		m_vkSetLayout = nullptr;
+		ReleaseComposite(logicaldevice);
+		return false;
 	}
-	else if (width != m_Width || height != m_Height) {
-		//
-		// For size change, release existing resources
-		// and re-create D3D11 texture and Vulkan image
-		//
-		// Free the sender D3D11 texture
-		ReleaseSharedDX11texture();
-		m_bInitialized = false;
-		// Create a new texture with the new size
-		if (CreateSharedDX11texture(width, height)) {
-			// Recreate the linked Vulkan image with new size
-			if(LinkVulkanImage(physicaldevice, logicaldevice, m_dxShareHandle, width, height)) {
-				// Update the sender information
-				sendernames.UpdateSender(m_SenderName, width, height, m_dxShareHandle, dwFormat);
-				// Update globals
-				m_Width = width;
-				m_Height = height;
-			}
-		}
+
+	VkPushConstantRange pushRange = { VK_SHADER_STAGE_COMPUTE_BIT, 0, 16 };
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &m_vkSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushRange;
+	if (vkCreatePipelineLayout(logicaldevice, &pipelineLayoutInfo, nullptr, &m_vkPipelineLayout) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVKMultiReceiver::CreateComposite - could not create pipeline layout");
+		m_vkPipelineLayout = nullptr;
+		ReleaseComposite(logicaldevice);
+		return false;
+	}
+
+	VkShaderModuleCreateInfo moduleInfo = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+	moduleInfo.codeSize = sizeof(spoutvk_composite_comp);
+	moduleInfo.pCode = spoutvk_composite_comp;
+	VkShaderModule shaderModule = nullptr;
+	if (vkCreateShaderModule(logicaldevice, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVKMultiReceiver::CreateComposite - could not create shader module");
+		ReleaseComposite(logicaldevice);
+		return false;
+	}
+
+	VkComputePipelineCreateInfo pipelineInfo = { VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = shaderModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = m_vkPipelineLayout;
+	VkResult result = vkCreateComputePipelines(logicaldevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_vkPipeline);
+	vkDestroyShaderModule(logicaldevice, shaderModule, nullptr);
+	if (result != VK_SUCCESS) {
+		SpoutLogWarning("spoutVKMultiReceiver::CreateComposite - could not create pipeline");
+		m_vkPipeline = nullptr;
+		ReleaseComposite(logicaldevice);
+		return false;
+	}
+
+	VkDescriptorPoolSize poolSizes[3] = {
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, SPOUTVK_COMPOSITE_LAYERS },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 }
+	};
+	VkDescriptorPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 3;
+	poolInfo.pPoolSizes = poolSizes;
+	if (vkCreateDescriptorPool(logicaldevice, &poolInfo, nullptr, &m_vkPool) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVKMultiReceiver::CreateComposite - could not create descriptor pool");
+		m_vkPool = nullptr;
+		ReleaseComposite(logicaldevice);
+		return false;
+	}
+
+	VkDescriptorSetAllocateInfo setInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+	setInfo.descriptorPool = m_vkPool;
+	setInfo.descriptorSetCount = 1;
+	setInfo.pSetLayouts = &m_vkSetLayout;
+	if (vkAllocateDescriptorSets(logicaldevice, &setInfo, &m_vkSet) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVKMultiReceiver::CreateComposite - could not allocate descriptor set");
+		m_vkSet = nullptr;
+		ReleaseComposite(logicaldevice);
+		return false;
+	}
+
+	// Placements, rectangle and opacity for each layer
+	if (!CreateBuffer(2 * SPOUTVK_COMPOSITE_LAYERS * 4 * sizeof(float),
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		m_vkPlacements, m_vkPlacementsMemory)) {
+		ReleaseComposite(logicaldevice);
+		return false;
 	}
+
+	SpoutLogNotice("spoutVKMultiReceiver::CreateComposite - composite pipeline created");
+
 	return true;
 }
 
-void spoutVK::ReleaseSender()
+void spoutVKMultiReceiver::ReleaseComposite(VkDevice logicaldevice)
 {
-	if(!m_dxShareHandle)
+	if (!logicaldevice)
 		return;
 
-	// Release the sender from the name list
-	if(m_SenderName && m_SenderName[0])
-		sendernames.ReleaseSenderName(m_SenderName);
-	m_SenderName[0] = 0;
-
-	// Release sender resources
-	ReleaseSharedDX11texture();
+	if (m_vkOutput) vkDestroyBuffer(logicaldevice, m_vkOutput, nullptr);
+	if (m_vkOutputMemory) vkFreeMemory(logicaldevice, m_vkOutputMemory, nullptr);
+	if (m_vkPlacements) vkDestroyBuffer(logicaldevice, m_vkPlacements, nullptr);
+	if (m_vkPlacementsMemory) vkFreeMemory(logicaldevice, m_vkPlacementsMemory, nullptr);
+	if (m_vkPool) vkDestroyDescriptorPool(logicaldevice, m_vkPool, nullptr);
+	if (m_vkPipeline) vkDestroyPipeline(logicaldevice, m_vkPipeline, nullptr);
+	if (m_vkPipelineLayout) vkDestroyPipelineLayout(logicaldevice, m_vkPipelineLayout, nullptr);
+	if (m_vkSetLayout) vkDestroyDescriptorSetLayout(logicaldevice, m_vkSetLayout, nullptr);
+	if (m_vkSamplerLinear) vkDestroySampler(logicaldevice, m_vkSamplerLinear, nullptr);
+	if (m_vkSamplerNearest) vkDestroySampler(logicaldevice, m_vkSamplerNearest, nullptr);
 
+	m_vkOutput = nullptr;
+	m_vkOutputMemory = nullptr;
+	m_OutputSize = 0;
+	m_vkPlacements = nullptr;
+	m_vkPlacementsMemory = nullptr;
+	m_vkPool = nullptr;
+	m_vkSet = nullptr;
+	m_vkPipeline = nullptr;
+	m_vkPipelineLayout = nullptr;
+	m_vkSetLayout = nullptr;
+	m_vkSamplerLinear = nullptr;
+	m_vkSamplerNearest = nullptr;
+	memset(m_SetViews, 0, sizeof(m_SetViews));
+	memset(m_SetSamplers, 0, sizeof(m_SetSamplers));
+	m_SetOutput = nullptr;
 }
 
-bool spoutVK::ReceiveImage(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
-	VkCommandBuffer commandbuffer, VkImage vulkanimage, VkImageLayout layout,
-	VkFormat vulkanformat, uint32_t width, uint32_t height)
+//
+// Bindless
+//
+// The linked image of each sender is an element of a partially bound
+// array of combined image samplers, so elements of senders not connected
+// need not be valid. Only the elements whose linked image has changed are
+// written. The binding can be updated while frames are in flight, and the
+// view of a replaced linked image is retired with it.
+// The index table is written to a buffer by the command buffer,
+// so that frames in flight each use their own.
+//
+bool spoutVKMultiReceiver::EnableBindless(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	uint32_t maxSenders)
 {
-	if (!CheckVulkanExtensions(physicaldevice)) {
-		SpoutLogError("spoutVK::ReceiveImage - required Vulkan extensions not supported");
+	if (m_vkDevice && m_vkDevice != logicaldevice) {
+		SpoutLogError("spoutVKMultiReceiver::EnableBindless - release receivers before changing device");
 		return false;
 	}
+	if (m_vkBindlessSet)
+		return true;
 
-	// The receiving image dimensions can be different to the sender.
-	// Fit to destination if the receiving size is specified and the
-	// sender and destination receiver sizes are different.
-	int w = width;
-	int h = height;
-	if (ReceiveSenderTexture(physicaldevice, logicaldevice)) {
-		if (frame.CheckAccess()) { // Get access to the shared texture
-			// Copy from the linked image to the receiving image
-			if(width  == 0) w = GetSenderWidth();
-			if(height == 0) h = GetSenderHeight();
-			CopyVulkanImage(physicaldevice, commandbuffer,
-				m_vkLinkedImage,             // Linked image
-				VK_IMAGE_LAYOUT_GENERAL,     // Linked image layout
-				GetVulkanFormat(m_dwFormat), // Linked image format
-				vulkanimage,                 // Receiving image
-				layout,                      // Receiving image layout
-				vulkanformat,                // Receiving image format
-				GetSenderWidth(), GetSenderHeight(), // Sender dimensions
-				w, h); // Receiving image dimensions
-			frame.AllowAccess();
-			return true;
-		}
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {
+		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT };
+	VkPhysicalDeviceFeatures2 features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+	features.pNext = &indexingFeatures;
+	vkGetPhysicalDeviceFeatures2(physicaldevice, &features);
+	if (!indexingFeatures.descriptorBindingPartiallyBound
+		|| !indexingFeatures.descriptorBindingUpdateUnusedWhilePending
+		|| !indexingFeatures.shaderSampledImageArrayNonUniformIndexing) {
+		SpoutLogWarning("spoutVKMultiReceiver::EnableBindless - descriptor indexing not supported");
+		return false;
 	}
-	return false;
+
+	// Within the device limit and the size of vkCmdUpdateBuffer for the table
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(physicaldevice, &properties);
+	maxSenders = (std::min)(maxSenders, properties.limits.maxPerStageDescriptorSampledImages);
+	maxSenders = (std::min)(maxSenders, (uint32_t)(65536/sizeof(spoutVKbindless)));
+	if (maxSenders == 0)
+		return false;
+
+	m_vkDevice = logicaldevice;
+	m_vkPhysicalDevice = physicaldevice;
+	m_BindlessCount = maxSenders;
+
+	VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	vkCreateSampler(logicaldevice, &samplerInfo, nullptr, &m_vkBindlessLinear);
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	vkCreateSampler(logicaldevice, &samplerInfo, nullptr, &m_vkBindlessNearest);
+
+	VkDescriptorSetLayoutBinding bindings[2] = {};
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[0].descriptorCount = m_BindlessCount;
+	bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+	bindings[1].binding = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[1].descriptorCount = 1;
+	bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+	VkDescriptorBindingFlagsEXT bindingFlags[2] = {
+		VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT, 0 };
+	VkDescriptorSetLayoutBindingFlagsCreateInfoEXT flagsInfo = {
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT };
+	flagsInfo.bindingCount = 2;
+	flagsInfo.pBindingFlags = bindingFlags;
+	VkDescriptorSetLayoutCreateInfo layoutInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+	layoutInfo.pNext = &flagsInfo;
+	layoutInfo.bindingCount = 2;
+	layoutInfo.pBindings = bindings;
+	if (vkCreateDescriptorSetLayout(logicaldevice, &layoutInfo, nullptr, &m_vkBindlessLayout) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVKMultiReceiver::EnableBindless - could not create descriptor set layout");
+		m_vkBindlessLayout = nullptr;
+		ReleaseBindless(logicaldevice);
+		return false;
+	}
+
+	VkDescriptorPoolSize poolSizes[2] = {
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_BindlessCount },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 }
+	};
+	VkDescriptorPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 2;
+	poolInfo.pPoolSizes = poolSizes;
+	if (vkCreateDescriptorPool(logicaldevice, &poolInfo, nullptr, &m_vkBindlessPool) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVKMultiReceiver::EnableBindless - could not create descriptor pool");
+		m_vkBindlessPool = nullptr;
+		ReleaseBindless(logicaldevice);
+		return false;
+	}
+
+	VkDescriptorSetAllocateInfo setInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+	setInfo.descriptorPool = m_vkBindlessPool;
+	setInfo.descriptorSetCount = 1;
+	setInfo.pSetLayouts = &m_vkBindlessLayout;
+	if (vkAllocateDescriptorSets(logicaldevice, &setInfo, &m_vkBindlessSet) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVKMultiReceiver::EnableBindless - could not allocate descriptor set");
+		m_vkBindlessSet = nullptr;
+		ReleaseBindless(logicaldevice);
+		return false;
+	}
+
+	if (!CreateBuffer(m_BindlessCount*sizeof(spoutVKbindless),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		m_vkBindlessTable, m_vkBindlessTableMemory)) {
+		ReleaseBindless(logicaldevice);
+		return false;
+	}
+	VkDescriptorBufferInfo tableInfo = { m_vkBindlessTable, 0, VK_WHOLE_SIZE };
+	VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	write.dstSet = m_vkBindlessSet;
+	write.dstBinding = 1;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write.pBufferInfo = &tableInfo;
+	vkUpdateDescriptorSets(logicaldevice, 1, &write, 0, nullptr);
+
+	m_BindlessLinks.assign(m_BindlessCount, 0);
+	m_BindlessTable.assign(m_BindlessCount, spoutVKbindless{});
+
+	SpoutLogNotice("spoutVKMultiReceiver::EnableBindless - %d senders", m_BindlessCount);
+
+	return true;
 }
 
-HANDLE spoutVK::ReceiveSenderTexture(VkPhysicalDevice physicaldevice, VkDevice device)
+VkDescriptorSetLayout spoutVKMultiReceiver::GetBindlessLayout()
 {
-	// Set the initial width and height to current globals.
-	// New width and height are returned from the sender.
-	unsigned int width  = m_Width;
-	unsigned int height = m_Height;
-	DWORD dwFormat = m_dwFormat;
-
-	//
-	// Find if the sender exists.
-	// Return the sender name, width, height, sharehandle and format.
-	//
-	// If not yet intialized or SelectSender has been opened, the sender
-	// name will be empty and the active sender is returned if that exists.
-	if (sendernames.FindSender(m_SenderName, width, height, m_dxShareHandle, dwFormat)) {
+	return m_vkBindlessLayout;
+}
 
-		// Set up if not initialized yet
-		if (!m_bSpoutInitialized) {
-			// Open a named mutex to control access to the sender's shared texture
-			frame.CreateAccessMutex(m_SenderName);
-			// Enable frame counting to get the sender frame number and fps
-			frame.EnableFrameCount(m_SenderName);
-			m_bSpoutInitialized = true;
-		}
+//
+// 1) Find, link and access the senders
+// 2) Write the descriptors of senders with a new linked image
+// 3) Write the index table
+// 4) Transition the senders for sampling
+//
+// Record outside a render pass, as for EndBindless.
+// Returns false if bindless is not enabled.
+//
+bool spoutVKMultiReceiver::BeginBindless(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+	VkCommandBuffer commandbuffer, VkDescriptorSet& set)
+{
+	if (!m_vkBindlessSet) {
+		SpoutLogWarning("spoutVKMultiReceiver::BeginBindless - bindless not enabled");
+		return false;
+	}
+	if (logicaldevice != m_vkDevice) {
+		SpoutLogError("spoutVKMultiReceiver::BeginBindless - release receivers before changing device");
+		return false;
+	}
 
-		// Check for size or format change
-		if (m_Width != width || m_Height != height || m_dwFormat != dwFormat) {
+	// 1) Senders found and accessed, if any
+	uint32_t count = (std::min)((uint32_t)m_Senders.size(), m_BindlessCount);
+	BeginReceive(physicaldevice, logicaldevice, count);
 
-			// Update globals for subsequent size checks
-			m_Width = width;
-			m_Height = height;
-			m_dwFormat = dwFormat;
-			m_bInitialized = false;
+	// 2) Descriptors
+	std::vector<VkDescriptorImageInfo> imageInfo;
+	std::vector<VkWriteDescriptorSet> writes;
+	imageInfo.reserve(count);
+	for (uint32_t i = 0; i < m_BindlessCount; i++) {
+		MultiSender* sender = (i < count) ? m_Senders[i].get() : nullptr;
+		VkImageView view = (sender && sender->bConnected && sender->image) ? GetSenderView(logicaldevice, *sender) : nullptr;
+		// An element without a view is not sampled and is written again for the next
+		if (!view) {
+			m_BindlessLinks[i] = 0;
+			continue;
+		}
+		if (sender->link == m_BindlessLinks[i])
+			continue;
+		VkFormatFeatureFlags features = GetFormatFeatures(physicaldevice, spoutVK::GetVulkanFormat(sender->dwFormat));
+		VkSampler sampler = (features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+			? m_vkBindlessLinear : m_vkBindlessNearest;
+		imageInfo.push_back({ sampler, view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+		VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+		write.dstSet = m_vkBindlessSet;
+		write.dstBinding = 0;
+		write.dstArrayElement = i;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes.push_back(write);
+		m_BindlessLinks[i] = sender->link;
+	}
+	if (!writes.empty()) {
+		for (size_t i = 0; i < writes.size(); i++)
+			writes[i].pImageInfo = &imageInfo[i];
+		vkUpdateDescriptorSets(logicaldevice, (uint32_t)writes.size(), writes.data(), 0, nullptr);
+	}
 
-			// Create a Vulkan image and link with D3D11 texture memory
-			// using the sender share handle retrieved by FindSender above
-			if (!LinkVulkanImage(physicaldevice, device, m_dxShareHandle, width, height, dwFormat)) {
-				SpoutLogWarning("spoutVK::ReceiveSenderTexture - could not create Vulkan image with received handle 0x%X", PtrToUint(m_dxShareHandle));
-				return nullptr;
-			}
-			m_bInitialized = true;
-			// The application can now access and copy the linked image.
+	// 3) Index table
+	spoutVKimageState shaderRead = spoutVKbarriers::GetLayoutState(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	for (uint32_t i = 0; i < m_BindlessCount; i++) {
+		spoutVKbindless& entry = m_BindlessTable[i];
+		entry = {};
+		if (i < count && m_BindlessLinks[i] && m_Senders[i]->bAccess) {
+			const MultiSender& sender = *m_Senders[i];
+			entry.valid = 1;
+			entry.width = sender.width;
+			entry.height = sender.height;
+			entry.format = (uint32_t)spoutVK::GetVulkanFormat(sender.dwFormat);
 		}
-		return m_dxShareHandle;
 	}
+	m_barriers.Memory(shaderRead.stages, 0, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+	m_barriers.Flush(commandbuffer);
+	vkCmdUpdateBuffer(commandbuffer, m_vkBindlessTable, 0,
+		m_BindlessCount*sizeof(spoutVKbindless), m_BindlessTable.data());
 
-	return nullptr;
+	// 4) One barrier for the table and the senders
+	m_barriers.Memory(VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		shaderRead.stages, VK_ACCESS_2_SHADER_READ_BIT);
+	for (uint32_t i = 0; i < count; i++) {
+		MultiSender& sender = *m_Senders[i];
+		if (m_BindlessTable[i].valid)
+			m_barriers.Transition(sender.image, sender.state, shaderRead);
+	}
+	m_barriers.Flush(commandbuffer);
+
+	set = m_vkBindlessSet;
+	return true;
 }
 
-uint32_t spoutVK::GetSenderWidth()
+void spoutVKMultiReceiver::EndBindless(VkCommandBuffer commandbuffer)
 {
-	return m_Width;
+	EndReceive(commandbuffer);
 }
 
-uint32_t spoutVK::GetSenderHeight()
+const spoutVKbindless* spoutVKMultiReceiver::GetBindlessTable()
 {
-	return m_Height;
+	return m_BindlessTable.empty() ? nullptr : m_BindlessTable.data();
 }
 
-void spoutVK::ReleaseReceiver()
+void spoutVKMultiReceiver::ReleaseBindless(VkDevice logicaldevice)
 {
-	if (!m_bInitialized)
+	if (!logicaldevice)
 		return;
 
-	SpoutLogNotice("spoutVK::ReleaseReceiver (%s)", m_SenderName);
+	if (m_vkBindlessTable) vkDestroyBuffer(logicaldevice, m_vkBindlessTable, nullptr);
+	if (m_vkBindlessTableMemory) vkFreeMemory(logicaldevice, m_vkBindlessTableMemory, nullptr);
+	if (m_vkBindlessPool) vkDestroyDescriptorPool(logicaldevice, m_vkBindlessPool, nullptr);
+	if (m_vkBindlessLayout) vkDestroyDescriptorSetLayout(logicaldevice, m_vkBindlessLayout, nullptr);
+	if (m_vkBindlessLinear) vkDestroySampler(logicaldevice, m_vkBindlessLinear, nullptr);
+	if (m_vkBindlessNearest) vkDestroySampler(logicaldevice, m_vkBindlessNearest, nullptr);
 
-	// Wait 4 frames in case the same sender opens again
-	Sleep(67);
+	m_vkBindlessTable = nullptr;
+	m_vkBindlessTableMemory = nullptr;
+	m_vkBindlessPool = nullptr;
+	m_vkBindlessSet = nullptr;
+	m_vkBindlessLayout = nullptr;
+	m_vkBindlessLinear = nullptr;
+	m_vkBindlessNearest = nullptr;
+	m_BindlessCount = 0;
+	m_BindlessLinks.clear();
+	m_BindlessTable.clear();
+}
 
-	// Sender share handled texture
-	ReleaseSharedDX11texture();
+// View of the linked image of a sender, created when first required
+VkImageView spoutVKMultiReceiver::GetSenderView(VkDevice logicaldevice, MultiSender& sender)
+{
+	if (!sender.view && sender.image) {
+		VkImageViewCreateInfo viewInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+		viewInfo.image = sender.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = spoutVK::GetVulkanFormat(sender.dwFormat);
+		viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		if (vkCreateImageView(logicaldevice, &viewInfo, nullptr, &sender.view) != VK_SUCCESS) {
+			SpoutLogWarning("spoutVKMultiReceiver::GetSenderView - could not create image view for %s", sender.name);
+			sender.view = nullptr;
+		}
+	}
+	return sender.view;
+}
 
-	// Close the named access mutex and frame counting semaphore.
-	frame.CloseAccessMutex();
-	frame.CleanupFrameCount();
+// Device local buffer
+bool spoutVKMultiReceiver::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+	VkBuffer& buffer, VkDeviceMemory& memory)
+{
+	VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+	bufferInfo.size = size;
+	bufferInfo.usage = usage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if (vkCreateBuffer(m_vkDevice, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVKMultiReceiver::CreateBuffer - could not create buffer");
+		buffer = nullptr;
+		return false;
+	}
 
-	// Zero width and height so that they are reset when a sender is found
-	m_Width = 0;
-	m_Height = 0;
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements(m_vkDevice, buffer, &memRequirements);
+	VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+	allocInfo.allocationSize = memRequirements.size;
+	allocInfo.memoryTypeIndex = spoutVK::findMemoryType(m_vkPhysicalDevice,
+		memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	if (allocInfo.memoryTypeIndex == UINT32_MAX
+		|| vkAllocateMemory(m_vkDevice, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+		SpoutLogWarning("spoutVKMultiReceiver::CreateBuffer - could not allocate buffer memory");
+		vkDestroyBuffer(m_vkDevice, buffer, nullptr);
+		buffer = nullptr;
+		memory = nullptr;
+		return false;
+	}
+	vkBindBufferMemory(m_vkDevice, buffer, memory, 0);
 
-	// Clear the name to find the active sender
-	m_SenderName[0] = 0;
-	
-	// Initialize again when a sender is found
-	m_bInitialized = false;
+	return true;
+}
 
-	return;
+// Format features for optimal tiling are queried once for each format
+VkFormatFeatureFlags spoutVKMultiReceiver::GetFormatFeatures(VkPhysicalDevice physicaldevice, VkFormat format)
+{
+	auto it = m_FormatFeatures.find(format);
+	if (it != m_FormatFeatures.end())
+		return it->second;
 
+	VkFormatProperties props{};
+	vkGetPhysicalDeviceFormatProperties(physicaldevice, format, &props);
+	m_FormatFeatures[format] = props.optimalTilingFeatures;
+	return props.optimalTilingFeatures;
 }
 
-std::string spoutVK::SelectSender(HWND hwnd)
+// Vulkan resources are not released without a device
+void spoutVKMultiReceiver::ReleaseSender(VkDevice logicaldevice, MultiSender& sender)
 {
-	std::string senderstr;
-
-	// Create a sender list
-	std::vector<std::string> senderlist;
-	int nSenders = sendernames.GetSenderCount();
-	if (nSenders > 0) {
-		char sendername[256]{};
-		for (int i=0; i<nSenders; i++) {
-			if (sendernames.GetSender(i, sendername))
-				senderlist.push_back(sendername);
-		}
+	if (sender.bConnected) {
+		if (sender.bAccess)
+			sender.frame.AllowAccess();
+		sender.frame.CloseAccessMutex();
+		sender.frame.CleanupFrameCount();
+		sender.bConnected = false;
+		sender.bAccess = false;
 	}
+	spoutVK::UnregisterReceiver(sender.info, m_ReceiverId, sender.receiverSlot, sender.receiverTime);
+	sender.info.Close();
+	if (logicaldevice) {
+		if (sender.view) vkDestroyImageView(logicaldevice, sender.view, nullptr);
+		if (sender.image) vkDestroyImage(logicaldevice, sender.image, nullptr);
+		if (sender.memory) vkFreeMemory(logicaldevice, sender.memory, nullptr);
+		sender.view = nullptr;
+		sender.image = nullptr;
+		sender.memory = nullptr;
+	}
+	sender.width = 0;
+	sender.height = 0;
+	sender.dwFormat = 0;
+	sender.shareHandle = nullptr;
+}
 
-	// Get the active sender index "selected".
-	// The index is passed in to SpoutMessageBox and used as the current combobox item.
-	int selected = 0;
-	char sendername[256]{};
-	if (sendernames.GetActiveSender(sendername))
-		selected = sendernames.GetSenderIndex(sendername);
+void spoutVKMultiReceiver::SetFrameTimeline(VkSemaphore semaphore, uint64_t value)
+{
+	m_vkFrameTimeline = semaphore;
+	m_FrameValue = value;
+}
 
-	// SpoutMessageBox opens either centered on the cursor position
-	// or on the application window if the handle is passed in.
-	if (!hwnd) {
-		POINT pt{};
-		GetCursorPos(&pt);
-		SpoutMessageBoxPosition(pt);
+// Retire the linked image and view of a sender until the frames
+// recorded before have completed
+void spoutVKMultiReceiver::RetireSender(MultiSender& sender)
+{
+	if (!sender.image && !sender.view)
+		return;
+
+	m_Retired.push_back({ sender.image, sender.memory, sender.view, m_vkFrameTimeline, m_FrameValue });
+	sender.view = nullptr;
+	sender.image = nullptr;
+	sender.memory = nullptr;
+}
+
+// Without a frame timeline the device waits
+void spoutVKMultiReceiver::ReleaseRetired(VkDevice logicaldevice, bool bAll)
+{
+	if (!logicaldevice || m_Retired.empty())
+		return;
+
+	bool bWait = bAll;
+	for (const Retired& retired : m_Retired) {
+		if (!retired.timeline)
+			bWait = true;
 	}
+	if (bWait)
+		vkDeviceWaitIdle(logicaldevice);
 
-	// Show the SpoutMessageBox even if the list is empty.
-	// This makes it clear to the user that no senders are running.
-	if (SpoutMessageBox(hwnd, NULL, "Select sender", MB_OKCANCEL, senderlist, selected) == IDOK && !senderlist.empty()) {
-		// Release the receiver
-		ReleaseReceiver();
-		// Set the selected sender as active for the next receive
-		sendernames.SetActiveSender(senderlist[selected].c_str());
-		// Return the selected sender name
-		// Not used in this example. the active sender is detected
-		senderstr = senderlist[selected].c_str();
-	} // endif messagebox query
+	for (auto it = m_Retired.begin(); it != m_Retired.end();) {
+		uint64_t value = 0;
+		if (bWait || (vkGetSemaphoreCounterValue(logicaldevice, it->timeline, &value) == VK_SUCCESS
+			&& value >= it->value)) {
+			if (it->view) vkDestroyImageView(logicaldevice, it->view, nullptr);
+			if (it->image) vkDestroyImage(logicaldevice, it->image, nullptr);
+			if (it->memory) vkFreeMemory(logicaldevice, it->memory, nullptr);
+			it = m_Retired.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+}
 
-	return senderstr;
+// Claim a slot in the receiver table of a SpoutVK sender, refreshed while
+// receiving, so that the sender counts this receiver as it does a spoutVK
+// receiver. Other senders have no information and are tried again
+// at the refresh interval.
+void spoutVKMultiReceiver::RegisterSender(MultiSender& sender)
+{
+	if (sender.receiverTime > 0 && GetTickCount64() - sender.receiverTime < SPOUTVK_RECEIVER_REFRESH)
+		return;
 
+	if (!sender.info.Name()) {
+		std::string name = std::string(sender.name) + "_vkinfo";
+		if (!sender.info.Open(name.c_str())) {
+			sender.receiverTime = GetTickCount64();
+			return;
+		}
+	}
+	spoutVK::RegisterReceiver(sender.info, m_ReceiverId,
+		sender.receiverSlot, sender.receiverTime, sender.name);
 }
 
-void spoutVK::HoldFps(int fps)
+void spoutVKMultiReceiver::ReleaseReceivers(VkDevice logicaldevice)
 {
-	frame.HoldFps(fps);
+	if (logicaldevice)
+		vkDeviceWaitIdle(logicaldevice);
+	for (auto& sender : m_Senders)
+		ReleaseSender(logicaldevice, *sender);
+	for (auto& sender : m_Removed)
+		ReleaseSender(logicaldevice, *sender);
+	m_Senders.clear();
+	m_Removed.clear();
+	ReleaseRetired(logicaldevice, true);
+	ReleaseComposite(logicaldevice);
+	ReleaseBindless(logicaldevice);
+	m_vkDevice = nullptr;
+	m_vkPhysicalDevice = nullptr;
 }
@@ -25,6 +25,148 @@
 #include "SpoutDX\SpoutFrameCount.h"
 #include "SpoutDX\SpoutUtils.h"
 
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <future>
+
+//
+// Layout, pipeline stages and access of the last use of an image.
+// Synchronization2 flag types are used for both barrier paths.
+// Only stage and access bits that have a classic equivalent are used
+// so that they can be passed to vkCmdPipelineBarrier unchanged.
+//
+struct spoutVKimageState {
+	VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	VkPipelineStageFlags2 stages = 0;
+	VkAccessFlags2 access = 0;
+};
+
+//
+// Barrier planner
+//
+// Image transitions are queued against the recorded state of each image
+// and recorded together by Flush with a single vkCmdPipelineBarrier2,
+// or vkCmdPipelineBarrier if synchronization2 is not enabled.
+// Transitions that change neither the layout nor protect a write are skipped.
+//
+class spoutVKbarriers {
+
+public:
+
+	// Use vkCmdPipelineBarrier2 if the synchronization2 feature is enabled for the device
+	bool EnableSynchronization2(VkDevice device, bool bEnable = true);
+	bool IsSynchronization2();
+	// Queue a transition from the current state of an image to a new state
+	void Transition(VkImage image, spoutVKimageState& state, const spoutVKimageState& newstate,
+		uint32_t baseMipLevel = 0, uint32_t levelCount = VK_REMAINING_MIP_LEVELS);
+	// Queue a global memory barrier
+	void Memory(VkPipelineStageFlags2 srcStages, VkAccessFlags2 srcAccess,
+		VkPipelineStageFlags2 dstStages, VkAccessFlags2 dstAccess);
+	// Record all queued barriers
+	void Flush(VkCommandBuffer commandBuffer);
+	// State of an image in a given layout
+	// bPrevious - accesses that may have been made before, rather than those to follow
+	static spoutVKimageState GetLayoutState(VkImageLayout layout, bool bPrevious = false);
+
+private:
+
+	std::vector<VkImageMemoryBarrier2> m_imageBarriers;
+	std::vector<VkMemoryBarrier2> m_memoryBarriers;
+	PFN_vkCmdPipelineBarrier2 m_pfnCmdPipelineBarrier2 = nullptr;
+
+};
+
+//
+// SpoutVK sender information
+//
+// Shared memory "<sender name>_vkinfo" created by a SpoutVK sender
+// in addition to the Spout sender information. Members are only
+// added at the end. "size" is the size of the structure written by
+// the sender, so that a receiver can check for the members it uses.
+// The map is created with SPOUTVK_INFO_MAPSIZE bytes to allow for them.
+//
+#define SPOUTVK_INFO_VERSION 4
+#define SPOUTVK_INFO_MAPSIZE 4096
+
+struct spoutVKinfo {
+	uint32_t size;      // Size of the structure written by the sender
+	uint32_t version;   // SPOUTVK_INFO_VERSION
+	int64_t frame;      // Sender frame number of the dirty rectangle
+	VkRect2D dirtyRect; // Union of the regions changed for the frame
+	// Version 2
+	uint32_t mipLevels;   // Levels of the mip texture, zero if there is none
+	uint32_t mipHandle;   // Share handle of the mip texture
+	VkExtent2D mipExtent; // Size of level 0, half the sender size
+	// Version 3
+	uint32_t receiverSlots; // Slots of the receiver table, zero if there is none
+	// Version 4
+	uint32_t senderPid;     // Process of the sender
+};
+
+//
+// SpoutVK receiver table
+//
+// Follows the sender information in the same shared memory, at
+// SPOUTVK_RECEIVER_OFFSET so that the information can grow.
+// A receiver claims a slot that is free or has not been refreshed
+// within SPOUTVK_RECEIVER_TIMEOUT, and refreshes it while receiving.
+// The sender only writes the information before the table.
+//
+#define SPOUTVK_RECEIVER_OFFSET 2048
+#define SPOUTVK_RECEIVER_SLOTS 64
+#define SPOUTVK_RECEIVER_TIMEOUT 1000 // msec
+#define SPOUTVK_RECEIVER_REFRESH 100  // msec
+
+struct spoutVKreceiver {
+	uint32_t pid;  // Receiving process, zero for a free slot
+	uint32_t id;   // Receiver within the process
+	uint64_t time; // GetTickCount64 when last refreshed
+};
+
+//
+// SpoutVK sender thumbnail
+//
+// Shared memory "<sender name>_vkthumb" with a small RGBA8 image of the
+// sender, updated at an interval by a sender that enables it. The pixels
+// follow the header, with rows of width*4 bytes, so that a sender picker
+// can show it without receiving from the sender.
+//
+#define SPOUTVK_THUMB_WIDTH 160
+#define SPOUTVK_THUMB_HEIGHT 90
+
+struct spoutVKthumb {
+	uint32_t size;   // Size of the header and offset of the pixels
+	uint32_t width;  // Within SPOUTVK_THUMB_WIDTH x SPOUTVK_THUMB_HEIGHT
+	uint32_t height; // with the aspect ratio of the sender
+	int64_t frame;   // Sender frame number of the image
+};
+
+#define SPOUTVK_THUMB_MAPSIZE (sizeof(spoutVKthumb) + SPOUTVK_THUMB_WIDTH*SPOUTVK_THUMB_HEIGHT*4)
+
+//
+// Sender image acquired by a receiver for sampling without a copy
+// (spoutVK::AcquireImage), or by a sender for rendering without a copy
+// (spoutVK::BeginFrame). The image is in the layout given, with a barrier
+// recorded before the stages and access, so that commands recorded after it
+// can sample or render to the image with the view.
+//
+struct spoutVKacquired {
+	VkImage image;
+	VkImageView view;
+	VkSampler sampler;       // Linear, clamp to edge. Null for a sender.
+	VkImageLayout layout;    // SHADER_READ_ONLY_OPTIMAL or COLOR_ATTACHMENT_OPTIMAL
+	VkPipelineStageFlags2 stages; // Stages that can sample after the barrier
+	VkAccessFlags2 access;
+	VkFormat format;
+	uint32_t width;
+	uint32_t height;
+	bool bNewFrame;          // The sender has produced a frame since the last
+};
+
 class spoutVK {
 
 public:
@@ -43,31 +185,148 @@ public:
 		VkImage srcImage, VkImageLayout srcLayout, VkFormat srcFormat,
 		VkImage dstImage, VkImageLayout dstLayout, VkFormat dstFormat,
 		uint32_t srcWidth, uint32_t srcHeight,
-		uint32_t dstWidth, uint32_t dstHeight);
+		uint32_t dstWidth, uint32_t dstHeight,
+		const VkRect2D* rects = nullptr, uint32_t rectCount = 0);
 	void ReleaseVulkanImage(VkDevice logicaldevice);
-	uint32_t findMemoryType(VkPhysicalDevice physicaldevice, uint32_t typeFilter, VkMemoryPropertyFlags properties);
-	bool CheckVulkanExtensions(VkPhysicalDevice physicalDevice);
+	static bool ImportD3D11Texture(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		HANDLE dxShareHandle, uint32_t width, uint32_t height, DWORD D3D11format,
+		VkImage& image, VkDeviceMemory& memory, uint32_t mipLevels = 1);
+	static uint32_t findMemoryType(VkPhysicalDevice physicaldevice, uint32_t typeFilter, VkMemoryPropertyFlags properties);
+	static uint32_t GetBytesPerPixel(VkFormat format);
+	static bool CheckVulkanExtensions(VkPhysicalDevice physicalDevice);
+	// Record barriers with vkCmdPipelineBarrier2 if synchronization2 is enabled for the device
+	bool EnableSynchronization2(VkDevice logicaldevice, bool bEnable = true);
+	// Record copies once to secondary command buffers and execute them for following frames
+	bool EnableCommandCache(VkDevice logicaldevice, uint32_t queueFamilyIndex, bool bEnable = true);
+	// Free the cached command buffers, e.g. when the swapchain is re-created
+	void ClearCommandCache();
+	// Queue for copies submitted by SpoutVK rather than recorded by the application
+	bool SetVulkanQueue(VkDevice logicaldevice, VkQueue queue, uint32_t queueFamilyIndex);
+	// Measure the GPU time of the send and receive copies with timestamp queries
+	// written to command buffers of the queue family
+	bool EnableTimestamps(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		uint32_t queueFamilyIndex, bool bEnable = true);
+	// Milliseconds for the last copy completed, for the copy and for the barriers before and after
+	bool GetCopyTime(double &copytime, double &barriertime);
+	// Copy time (msec) of a percentile (0-100) of recent copies
+	double GetCopyTimePercentile(double percentile);
+	// Label the copies with VK_EXT_debug_utils so that profilers can attribute them
+	bool EnableDebugLabels(VkDevice logicaldevice, bool bEnable = true);
+	// Linked images of previous sizes and formats are retained up to a memory budget
+	// so that a change back does not create and import them again. Zero to disable.
+	void SetLinkedPoolBudget(VkDeviceSize bytes);
+	VkDeviceSize GetLinkedPoolSize();
+	// Create a sender texture and linked image for a size expected later
+	bool PrewarmLinkedImage(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		uint32_t width, uint32_t height, VkFormat format);
+	// Create the texture and linked image for a new sender size on a worker thread.
+	// Frames are scaled to the previous size until they are ready.
+	void EnableAsyncResize(bool bEnable = true);
+	bool IsResizePending();
+	// Frames before the release of an image replaced by a resize is checked.
+	// Without a frame timeline, a fence is then submitted to the queue set by
+	// SetVulkanQueue, so the command buffers of those frames must have been
+	// submitted to it. Without a queue the device waits.
+	void SetRetireFrames(uint32_t frames);
+	// Timeline semaphore that the application signals with the value when the
+	// command buffers recorded after this call have completed. Objects replaced
+	// by SpoutVK are released when it is reached rather than after a fence.
+	void SetFrameTimeline(VkSemaphore semaphore, uint64_t value);
+	// Keep the sender size while the image size is changing, for example
+	// during a window drag, and change it when stable for the interval.
+	// Frames are scaled to the sender size meanwhile. Zero to disable.
+	void SetResizeDebounce(uint32_t msec);
+	uint32_t GetResizeDebounce();
+	// Sizes that changed again before they were used for the sender
+	uint64_t GetRelinksAvoided();
+	// Sender size and format independent of the image sent by SendImage,
+	// which is scaled and converted by the copy. SendPixels is not scaled.
+	// Zero size or VK_FORMAT_UNDEFINED to follow the image.
+	bool SetOutputResolution(uint32_t width, uint32_t height, VkFormat format = VK_FORMAT_UNDEFINED);
+	// Share a second texture of half the sender size with up to this number
+	// of mip levels, generated from each frame by SendImage. Receivers of
+	// smaller sizes copy from the level closest to their size. Zero to disable.
+	void SetSenderMipLevels(uint32_t levels);
+	uint32_t GetSenderMipLevels();
+	// Publish a thumbnail of the frames sent by SendImage at an interval
+	void EnableThumbnail(bool bEnable = true, uint32_t msec = 500);
+	// Skip the copy and new frame in SendImage while no SpoutVK receiver is registered.
+	// Receivers that are not SpoutVK do not register, so this is off by default.
+	void SetSkipWithoutReceivers(bool bSkip = true);
+	// SpoutVK receivers registered with the sender
+	uint32_t GetReceiverCount();
+	// Claim or refresh, and free, a slot in the receiver table of the
+	// information of a sender, for receivers such as spoutVKMultiReceiver
+	// that open the information themselves. The id is from NewReceiverId.
+	static void RegisterReceiver(SpoutSharedMemory& info, uint32_t id,
+		int& slot, uint64_t& time, const char* sendername);
+	static void UnregisterReceiver(SpoutSharedMemory& info, uint32_t id, int& slot, uint64_t& time);
+	static uint32_t NewReceiverId();
 
 	// Sender
 	bool SendImage(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
 		VkCommandBuffer commandbuffer, VkImage vulkanimage, VkImageLayout layout,
-		uint32_t width, uint32_t height, VkFormat format);
+		uint32_t width, uint32_t height, VkFormat format,
+		const VkRect2D* rects = nullptr, uint32_t rectCount = 0);
+	bool SendPixels(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		const void* pixels, uint32_t pitch, uint32_t width, uint32_t height, VkFormat format);
+	// Render to the sender's image as a colour attachment instead of copying with SendImage.
+	// EndFrame is recorded after the rendering commands and publishes the frame.
+	bool BeginFrame(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		VkCommandBuffer commandbuffer, uint32_t width, uint32_t height, VkFormat format,
+		spoutVKacquired& target);
+	bool EndFrame(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		VkCommandBuffer commandbuffer);
 	bool SetSenderName(const char * sendername = nullptr);
 	bool CreateSender(std::string senderName, uint32_t width, uint32_t height, DWORD dwFormat = DXGI_FORMAT_B8G8R8A8_UNORM);
 	bool CheckSender(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
 		std::string sendername, uint32_t width, uint32_t height,
 		DWORD dwFormat = DXGI_FORMAT_B8G8R8A8_UNORM);
 	void ReleaseSender();
-	DWORD GetD3Dformat(VkFormat vulkanFormat);
-	VkFormat GetVulkanFormat(DWORD dwD3Dformat);
+	static DWORD GetD3Dformat(VkFormat vulkanFormat);
+	static VkFormat GetVulkanFormat(DWORD dwD3Dformat);
 
 	// Receiver
+	// Receive from a sender by name rather than the active sender. Null for the active sender.
+	void SetReceiverName(const char* sendername = nullptr);
 	bool ReceiveImage(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
 		VkCommandBuffer commandbuffer, VkImage vulkanimage, VkImageLayout layout,
 		VkFormat vulkanformat, uint32_t width = 0, uint32_t height = 0);
+	// Copy from a sender in the same process and on the same device without the
+	// shared texture. The sender and receiver must both have a frame timeline
+	// (SetFrameTimeline), otherwise the shared texture is used, as it is for
+	// a sender that sends with SendPixels. Default true.
+	void SetLocalFastPath(bool bEnable = true);
+	bool IsLocalReceive();
+	// Timeline semaphore and value that the submission of the receiver's command
+	// buffer must wait for, after ReceiveImage recorded a copy from a local sender.
+	// Not needed if the copy is in the command buffer of the sender's frame.
+	bool GetLocalWait(VkSemaphore &semaphore, uint64_t &value);
+	// Whether the last ReceiveImage copied a new frame. The copy is skipped,
+	// and ReceiveImage returns true, if the receiving image already has the sender's frame.
+	bool IsFrameNew();
+	// Sample the sender's image directly instead of copying it with ReceiveImage.
+	// Access to the image is held until ReleaseImage, which is called after the
+	// commands that sample the image are recorded, with the same command buffer
+	// to return the image to GENERAL layout. The image and view are valid
+	// until the next AcquireImage and change with the sender size.
+	bool AcquireImage(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		VkCommandBuffer commandbuffer, spoutVKacquired& acquired);
+	void ReleaseImage(VkCommandBuffer commandbuffer);
 	HANDLE ReceiveSenderTexture(VkPhysicalDevice physicaldevice, VkDevice logicaldevice);
+	bool ReceiveToMemory(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		const void* &pixels, uint32_t &width, uint32_t &height, uint32_t &pitch, VkFormat &format);
+	void SetReadbackDepth(uint32_t depth = 0);
+	uint32_t GetReadbackDepth();
 	uint32_t GetSenderWidth();
 	uint32_t GetSenderHeight();
+	VkFormat GetSenderFormat();
+	// Region changed by a SpoutVK sender for the frame number returned
+	bool GetDirtyRect(VkRect2D &rect, long &framenumber);
+	// Thumbnail of any SpoutVK sender that publishes one, without receiving from it.
+	// RGBA8 pixels, up to SPOUTVK_THUMB_WIDTH*SPOUTVK_THUMB_HEIGHT*4 bytes.
+	static bool ReadThumbnail(const char* sendername, void* pixels,
+		uint32_t &width, uint32_t &height, long &framenumber);
 	void ReleaseReceiver();
 	std::string SelectSender(HWND hwnd = nullptr);
 	void HoldFps(int fps);
@@ -78,6 +337,356 @@ private:
 	VkDeviceMemory m_vkImageMemory = nullptr;
 	bool m_bBlitSupported = false;
 
+	// Barriers and the state of the linked image while it is used.
+	// It is in GENERAL layout between uses for other processes.
+	spoutVKbarriers m_barriers;
+	spoutVKimageState m_LinkedState;
+	void ResetLinkedState();
+
+	// Devices used for the linked image and the resources created for it
+	VkPhysicalDevice m_vkPhysicalDevice = nullptr;
+	VkDevice m_vkDevice = nullptr;
+	VkImageView m_vkLinkedView = nullptr;
+	uint32_t m_LinkedGeneration = 0; // Incremented for each new linked image
+	HANDLE m_LinkedHandle = nullptr; // Share handle, size and format of the linked image
+	uint32_t m_LinkedWidth = 0;
+	uint32_t m_LinkedHeight = 0;
+	DWORD m_LinkedFormat = 0;
+	void ReleaseLinkedImage(VkDevice logicaldevice);
+	VkImageView GetLinkedView();
+
+	// Linked images retained for a change back to a previous size or format.
+	// The least recently used are released first when over the budget.
+	struct PooledImage {
+		HANDLE shareHandle;
+		uint32_t width;
+		uint32_t height;
+		DWORD dwFormat;
+		ID3D11Texture2D* texture; // Sender texture, null for a receiver
+		VkImage image;
+		VkDeviceMemory memory;
+		VkImageView view;
+		VkDeviceSize size;
+		uint64_t lastUsed;
+	};
+	std::vector<PooledImage> m_LinkedPool;
+	VkDeviceSize m_LinkedPoolBudget = 128*1024*1024;
+	uint64_t m_LinkedPoolClock = 0;
+	bool PoolLinkedImage(VkDevice logicaldevice);
+	void RetireLinkedImage();
+	bool AcquirePooledImage(HANDLE shareHandle, uint32_t width, uint32_t height, DWORD dwFormat);
+	void TrimLinkedPool(VkDevice logicaldevice, VkDeviceSize budget);
+	void ReleaseLinkedPool(VkDevice logicaldevice);
+
+	// Resize on a worker thread
+	struct ResizeJob {
+		uint32_t width;
+		uint32_t height;
+		DWORD dwFormat;
+		ID3D11Texture2D* texture;
+		HANDLE shareHandle;
+		VkImage image;
+		VkDeviceMemory memory;
+	};
+	bool m_bAsyncResize = false;
+	ResizeJob m_ResizeJob {};
+	std::future<bool> m_ResizeResult; // Valid while a resize is in progress or not yet used
+	void StartResize(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		uint32_t width, uint32_t height, DWORD dwFormat);
+	bool SwapResize(VkDevice logicaldevice);
+	void CancelResize(VkDevice logicaldevice);
+
+	// Frame timeline and value of a receiver in this process
+	// that recorded a copy from the linked image
+	struct LocalReader {
+		VkSemaphore timeline;
+		uint64_t value;
+	};
+
+	// Objects replaced while command buffers that use them may be in flight,
+	// released when those command buffers have completed
+	struct Retired {
+		ID3D11Texture2D* texture;
+		VkImage image;
+		VkDeviceMemory memory; // Of the image or buffer
+		VkImageView view;
+		VkBuffer buffer;
+		VkDescriptorSet set;             // From the compute descriptor pool
+		VkCommandBuffer commandBuffer;   // From the command cache pool
+		uint64_t frame;
+		VkSemaphore timeline; // Frame timeline and value when retired
+		uint64_t value;
+		std::vector<LocalReader> readers; // Receivers of the linked image
+	};
+	std::vector<Retired> m_Retired;
+	uint32_t m_RetireFrames = 3;
+	uint64_t m_SenderFrames = 0; // Calls to CheckSender and ReceiveSenderTexture
+	VkSemaphore m_vkFrameTimeline = nullptr;
+	uint64_t m_FrameValue = 0;
+	VkFence m_vkRetireFence = nullptr; // Submitted when there is no timeline
+	bool m_bRetireFencePending = false;
+	uint64_t m_RetireFenceFrame = 0;    // Frames covered by the fence
+	uint64_t m_RetireCompleteFrame = 0; // Frames known to be complete
+	void Retire(const Retired& retired);
+	void ReleaseRetired(VkDevice logicaldevice, bool bAll);
+
+	// Resize debounce
+	uint32_t m_ResizeDebounce = 0; // msec
+	uint32_t m_DebounceWidth = 0;  // Size waiting to be stable
+	uint32_t m_DebounceHeight = 0;
+	DWORD m_DebounceFormat = 0;
+	std::chrono::steady_clock::time_point m_DebounceStart;
+	uint64_t m_RelinksAvoided = 0;
+
+	// Output resolution
+	uint32_t m_OutputWidth = 0;
+	uint32_t m_OutputHeight = 0;
+	VkFormat m_OutputFormat = VK_FORMAT_UNDEFINED;
+
+	// Mip texture of half the sender size.
+	// Created by a sender and imported by a receiver from the sender information.
+	uint32_t m_MipLevels = 0; // Levels requested by the sender
+	ID3D11Texture2D* m_pMipTexture = nullptr; // Sender texture, null for a receiver
+	HANDLE m_MipShareHandle = nullptr;
+	VkImage m_vkMipImage = nullptr;
+	VkDeviceMemory m_vkMipMemory = nullptr;
+	uint32_t m_MipWidth = 0; // Level 0
+	uint32_t m_MipHeight = 0;
+	DWORD m_MipFormat = 0;
+	std::vector<spoutVKimageState> m_MipStates; // State of each level
+	bool m_bMipWarning = false;
+	bool UpdateMipImage(VkPhysicalDevice physicaldevice, VkDevice logicaldevice);
+	void ResetMipStates();
+	void GenerateMips(VkCommandBuffer commandBuffer);
+	bool ReceiveMipLevel(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		VkCommandBuffer commandBuffer, VkImage dstImage, VkImageLayout dstLayout, VkFormat dstFormat,
+		uint32_t dstWidth, uint32_t dstHeight);
+	void RetireMipImage();
+	void ReleaseMipImage(VkDevice logicaldevice);
+
+	// Thumbnail copied to a mapped buffer and written to shared memory
+	// when the event set after the copy shows that it has completed
+	bool m_bThumbnail = false;
+	uint32_t m_ThumbInterval = 500; // msec
+	std::chrono::steady_clock::time_point m_ThumbTime;
+	VkImage m_vkThumbImage = nullptr;
+	VkDeviceMemory m_vkThumbMemory = nullptr;
+	spoutVKimageState m_ThumbState;
+	VkBuffer m_vkThumbBuffer = nullptr;
+	VkDeviceMemory m_vkThumbBufferMemory = nullptr;
+	void* m_pThumbPixels = nullptr;
+	uint32_t m_ThumbWidth = 0;
+	uint32_t m_ThumbHeight = 0;
+	bool m_bThumbPending = false; // Copy in progress
+	VkEvent m_vkThumbEvent = nullptr; // Set when the copy has completed
+	int64_t m_ThumbFrame = 0;
+	SpoutSharedMemory m_Thumbnail;
+	void UpdateThumbnail(VkPhysicalDevice physicaldevice, VkCommandBuffer commandBuffer);
+	void ReleaseThumbnail(VkDevice logicaldevice);
+
+	void PublishFrame(VkPhysicalDevice physicaldevice, VkCommandBuffer commandbuffer, const VkRect2D& dirty);
+
+	// Format capabilities cached for the physical device
+	std::unordered_map<VkFormat, VkFormatFeatureFlags> m_FormatFeatures;
+	VkFormatFeatureFlags GetFormatFeatures(VkPhysicalDevice physicaldevice, VkFormat format);
+
+	// Image and buffer creation
+	bool CreateVulkanImage(uint32_t width, uint32_t height, VkFormat format,
+		VkImageUsageFlags usage, VkImage& image, VkDeviceMemory& memory, VkImageView* view = nullptr);
+	bool CreateVulkanBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+		VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& memory);
+
+	// Compute shader scale and convert if blit is not supported
+	bool ComputeCopy(VkCommandBuffer commandBuffer,
+		VkImage srcImage, spoutVKimageState& srcState, VkFormat srcFormat,
+		uint32_t srcWidth, uint32_t srcHeight,
+		VkImage dstImage, spoutVKimageState& dstState, VkFormat dstFormat,
+		uint32_t dstWidth, uint32_t dstHeight);
+	bool CreateComputePipeline();
+	void ReleaseCompute();
+	VkDescriptorSetLayout m_vkComputeSetLayout = nullptr;
+	VkPipelineLayout m_vkComputePipelineLayout = nullptr;
+	VkPipeline m_vkComputePipeline = nullptr;
+	VkDescriptorPool m_vkComputePool = nullptr;
+	VkDescriptorSet m_vkComputeSet = nullptr;
+	static const uint32_t m_ComputeSets = 8; // Current and retired sets
+	VkSampler m_vkSamplerLinear = nullptr;
+	VkSampler m_vkSamplerNearest = nullptr;
+	// Source copy for images that cannot be sampled
+	VkImage m_vkComputeInput = nullptr;
+	VkDeviceMemory m_vkComputeInputMemory = nullptr;
+	VkImageView m_vkComputeInputView = nullptr;
+	spoutVKimageState m_ComputeInputState;
+	uint32_t m_ComputeInputWidth = 0;
+	uint32_t m_ComputeInputHeight = 0;
+	VkFormat m_ComputeInputFormat = VK_FORMAT_UNDEFINED;
+	// Packed pixels for copy to the destination image
+	VkBuffer m_vkComputeBuffer = nullptr;
+	VkDeviceMemory m_vkComputeBufferMemory = nullptr;
+	VkDeviceSize m_ComputeBufferSize = 0;
+	// Descriptors currently written to the set
+	VkImageView m_ComputeSetView = nullptr;
+	VkSampler m_ComputeSetSampler = nullptr;
+	VkBuffer m_ComputeSetBuffer = nullptr;
+	bool m_bCopyWarning = false;
+
+	// Copy commands recorded in secondary command buffers
+	// for the same images, layouts, formats and sizes
+	struct CopyCommands {
+		VkImage srcImage;
+		VkImageLayout srcLayout;
+		VkFormat srcFormat;
+		VkImage dstImage;
+		VkImageLayout dstLayout;
+		VkFormat dstFormat;
+		uint32_t srcWidth;
+		uint32_t srcHeight;
+		uint32_t dstWidth;
+		uint32_t dstHeight;
+		VkCommandBuffer commandBuffer;
+	};
+	std::vector<CopyCommands> m_CopyCommands;
+	VkCommandPool m_vkCommandPool = nullptr;
+	bool m_bCommandCache = false;
+	void RecordCopy(VkPhysicalDevice physicaldevice, VkCommandBuffer commandBuffer,
+		VkImage srcImage, VkImageLayout srcLayout, VkFormat srcFormat,
+		VkImage dstImage, VkImageLayout dstLayout, VkFormat dstFormat,
+		uint32_t srcWidth, uint32_t srcHeight,
+		uint32_t dstWidth, uint32_t dstHeight,
+		const VkRect2D* rects = nullptr, uint32_t rectCount = 0);
+
+	// Timestamps before and after the barriers and copy of CopyVulkanImage
+	// for send and receive copies. A ring of query slots is read back when
+	// available without waiting.
+	static const uint32_t m_TimestampSlots = 8;
+	static const uint32_t m_TimestampQueries = 4;
+	VkQueryPool m_vkTimestampPool = nullptr;
+	bool m_TimestampPending[m_TimestampSlots] {};
+	uint32_t m_TimestampSlot = 0;           // Next slot
+	uint32_t m_TimestampQuery = UINT32_MAX; // Next query of the copy being recorded
+	double m_TimestampPeriod = 0.0;         // Nanoseconds per tick
+	uint64_t m_TimestampMask = 0;           // Valid bits of the queue family
+	double m_CopyTime = 0.0;                // msec
+	double m_BarrierTime = 0.0;
+	std::vector<double> m_CopyTimes;        // Recent copy times
+	size_t m_CopyTimeIndex = 0;
+	void BeginTimestamps(VkCommandBuffer commandBuffer);
+	void WriteTimestamp(VkCommandBuffer commandBuffer, uint32_t query);
+	void ReadTimestamps();
+	void ReleaseTimestamps(VkDevice logicaldevice);
+
+	// Debug labels
+	PFN_vkCmdBeginDebugUtilsLabelEXT m_pfnCmdBeginDebugUtilsLabel = nullptr;
+	PFN_vkCmdEndDebugUtilsLabelEXT m_pfnCmdEndDebugUtilsLabel = nullptr;
+	void BeginLabel(VkCommandBuffer commandBuffer, const char* name);
+	void EndLabel(VkCommandBuffer commandBuffer);
+
+	// SpoutVK sender information shared memory
+	SpoutSharedMemory m_SenderInfo;
+	bool CreateSenderInfo();
+	bool OpenSenderInfo();
+	bool WriteSenderInfo(const spoutVKinfo& info);
+	bool ReadSenderInfo(spoutVKinfo& info);
+
+	// Receiver table
+	bool m_bSkipWithoutReceivers = false;
+	bool m_bSkipped = false; // The linked image is out of date after skipped frames
+	uint32_t m_ReceiverId = 0; // Unique within the process
+	int m_ReceiverSlot = -1;
+	uint64_t m_ReceiverTime = 0;
+	void RegisterReceiver();
+	void UnregisterReceiver();
+
+	// Sender frame copied to each receiving image
+	struct ReceivedFrame {
+		VkImage image;
+		long frame;
+		uint32_t generation; // Linked image copied from
+		uint32_t width;
+		uint32_t height;
+		VkFormat format;
+	};
+	static const size_t m_MaxReceivedFrames = 8;
+	std::vector<ReceivedFrame> m_ReceivedFrames;
+	bool m_bIsNewFrame = false;
+	bool CheckNewFrame(VkImage image, uint32_t width, uint32_t height, VkFormat format,
+		long senderFrame, uint32_t generation);
+
+	// Same process fast path
+	bool m_bLocalFastPath = true;
+	bool m_bLocalSender = false;  // Registered as a sender of this process
+	bool m_bPixelSender = false;  // Sending with SendPixels, not on the frame timeline
+	bool m_bLocalReceive = false; // Receiving from a sender of this process
+	std::string m_LocalChecked;   // Sender whose process has been checked
+	bool m_bLocalPeer = false;    // The sender is in this process
+	uint32_t m_LocalWidth = 0;    // Sender size and format
+	uint32_t m_LocalHeight = 0;
+	DWORD m_LocalFormat = 0;
+	VkSemaphore m_vkLocalWait = nullptr; // Sender timeline for the copy recorded
+	uint64_t m_LocalWaitValue = 0;
+	std::vector<LocalReader> m_LocalReaders; // Of the linked image of a sender
+	static const uint64_t m_LocalReaderTimeout = 1000000000; // nsec, when released
+	void RegisterLocalSender();
+	void UnregisterLocalSender();
+	void AddLocalReader(VkSemaphore timeline, uint64_t value);
+	bool CompleteLocalReaders(VkDevice logicaldevice, std::vector<LocalReader>& readers, uint64_t timeout = 0);
+	bool ReceiveLocalImage(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		VkCommandBuffer commandbuffer, VkImage vulkanimage, VkImageLayout layout,
+		VkFormat vulkanformat, uint32_t width, uint32_t height);
+
+	// Images imported by receivers, shared by the receivers of this process
+	// linked with the same sender texture on the same device
+	bool AcquireImportedImage(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		HANDLE dxShareHandle, uint32_t width, uint32_t height, DWORD D3D11format);
+	static bool ReleaseImportedImage(VkDevice logicaldevice, VkImage image);
+
+	// Zero copy send and receive. Access to the shared texture
+	// is held from BeginFrame or AcquireImage until released.
+	bool m_bAcquired = false;
+	VkSampler m_vkAcquireSampler = nullptr;
+
+	// Queue and command pool for copies submitted by SpoutVK
+	VkQueue m_vkQueue = nullptr;
+	uint32_t m_QueueFamilyIndex = 0;
+	VkCommandPool m_vkSubmitPool = nullptr;
+
+	// Host memory staging ring
+	// Each slot has a persistently mapped buffer, command buffer and fence
+	enum SlotState { SLOT_FREE, SLOT_PENDING, SLOT_READY, SLOT_INUSE };
+	struct StagingSlot {
+		VkBuffer buffer;
+		VkDeviceMemory memory;
+		VkDeviceSize size;
+		void* mapped;
+		bool bCoherent;
+		VkCommandBuffer commandBuffer;
+		VkFence fence;
+		SlotState state;
+		uint64_t sequence; // Submit order
+		std::chrono::steady_clock::time_point submitTime;
+		uint32_t width;
+		uint32_t height;
+		uint32_t pitch;
+		VkFormat format;
+	};
+	bool CreateStagingSlot(StagingSlot& slot, VkDeviceSize size, bool bReadback);
+	void ReleaseStagingSlot(StagingSlot& slot);
+
+	// Readback ring for ReceiveToMemory
+	std::vector<StagingSlot> m_Readback;
+	uint32_t m_ReadbackDepth = 0; // 0 for adaptive
+	uint64_t m_ReadbackSequence = 0;
+	double m_ReadbackLatency = 0.0; // msec from submit to completion
+	double m_ReadbackInterval = 0.0; // msec between calls
+	std::chrono::steady_clock::time_point m_ReadbackLastCall;
+	void ReleaseReadback();
+
+	// Upload ring for SendPixels
+	std::vector<StagingSlot> m_Upload;
+	uint32_t m_UploadDepth = 3;
+	uint64_t m_UploadSequence = 0;
+	void ReleaseUpload();
+
 	// DirectX 11
 	ID3D11Device * m_pD3D11Device = nullptr;
 	ID3D11DeviceContext * m_pImmediateContext = nullptr;
@@ -98,4 +707,268 @@ private:
 
 };
 
+//
+// Source image for a sender of a spoutVKSenderPool
+//
+struct spoutVKsource {
+	VkImage image = nullptr; // No image to skip the sender
+	VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	VkFormat format = VK_FORMAT_B8G8R8A8_UNORM;
+	uint32_t width = 0;
+	uint32_t height = 0;
+};
+
+//
+// Sender pool
+//
+// Many senders from one Vulkan device.
+// The D3D11 device, sender names, extension check and barriers are shared.
+// The copies for all senders are recorded to one command buffer between
+// one barrier before and one after, and new frames are signalled together.
+//
+class spoutVKSenderPool {
+
+public:
+
+	spoutVKSenderPool();
+	~spoutVKSenderPool();
+
+	// Add a sender and return its index. An existing name is incremented.
+	int AddSender(const char* sendername);
+	// Release a sender. Indices of other senders do not change.
+	void RemoveSender(VkDevice logicaldevice, int index);
+	uint32_t GetSenderCount();
+	const char* GetSenderName(int index);
+	// Copy each source image to the sender with the same index.
+	// Senders are created or updated for the size and format of the source.
+	bool SendImages(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		VkCommandBuffer commandbuffer, const spoutVKsource* sources, uint32_t count);
+	void ReleaseSenders(VkDevice logicaldevice);
+	bool EnableSynchronization2(VkDevice logicaldevice, bool bEnable = true);
+
+private:
+
+	struct PoolSender {
+		char name[256] {};
+		uint32_t width = 0;
+		uint32_t height = 0;
+		DWORD dwFormat = 0;
+		ID3D11Texture2D* texture = nullptr;
+		HANDLE shareHandle = nullptr;
+		VkImage image = nullptr;
+		VkDeviceMemory memory = nullptr;
+		spoutVKimageState state;
+		bool bCreated = false;
+		spoutFrameCount frame;
+		SpoutSharedMemory info;
+	};
+
+	bool UpdateSender(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		PoolSender& sender, const spoutVKsource& source);
+	void ReleaseSender(VkDevice logicaldevice, PoolSender& sender);
+	bool HasSenderName(const char* sendername);
+
+	std::vector<std::unique_ptr<PoolSender>> m_Senders; // Removed senders are null
+	spoutVKbarriers m_barriers;
+	ID3D11Device* m_pD3D11Device = nullptr;
+	spoutSenderNames sendernames;
+	spoutDirectX spoutdx;
+
+};
+
+//
+// Placement of a sender in a composite image.
+// Position and size in destination pixels and alpha from 0 to 1.
+//
+struct spoutVKplacement {
+	float x = 0.0f;
+	float y = 0.0f;
+	float width = 0.0f;
+	float height = 0.0f;
+	float alpha = 1.0f;
+};
+
+#define SPOUTVK_COMPOSITE_LAYERS 8
+
+//
+// Entry of the bindless index table for each sender.
+// Element i of the image array is sender i, and is only valid to sample
+// in the frame if "valid" is not zero. Written to a storage buffer
+// for shaders and available on the host.
+//
+#define SPOUTVK_BINDLESS_SENDERS 64
+
+struct spoutVKbindless {
+	uint32_t valid;  // The sender is connected and accessed for the frame
+	uint32_t width;
+	uint32_t height;
+	uint32_t format; // VkFormat
+};
+
+//
+// Multiple sender receiver
+//
+// Receive a list of senders with one command buffer.
+// The senders are found and linked together, the copies for all are
+// recorded between one barrier before and one after, and access is
+// held for all senders only while the commands are recorded.
+// Each sender can be copied to a layer of a 2D array image or a tile of
+// an atlas image, or the senders composited in one compute dispatch.
+//
+class spoutVKMultiReceiver {
+
+public:
+
+	spoutVKMultiReceiver();
+	~spoutVKMultiReceiver();
+
+	// Senders to receive, in layer or tile order.
+	// Senders with the same name as before remain linked.
+	void SetSenders(const char* const* sendernames, uint32_t count);
+	uint32_t GetSenderCount();
+	const char* GetSenderName(uint32_t index);
+	// Sender found and linked by the last receive
+	bool IsConnected(uint32_t index);
+	uint32_t GetSenderWidth(uint32_t index);
+	uint32_t GetSenderHeight(uint32_t index);
+	VkFormat GetSenderFormat(uint32_t index);
+
+	// Copy each sender to the layer of a 2D array image with the same index,
+	// scaled to the image size. Layers of senders not found are not changed.
+	// Senders with an index of the array layer count or more are not copied.
+	bool ReceiveLayers(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		VkCommandBuffer commandbuffer, VkImage arrayimage, VkImageLayout layout,
+		VkFormat format, uint32_t width, uint32_t height, uint32_t layers);
+	// Copy each sender to a tile of an atlas image, scaled to the tile size.
+	// Tiles are in rows of "columns" from the top left. The atlas image must
+	// hold "rows" of tiles. Senders beyond the last row are not copied.
+	bool ReceiveAtlas(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		VkCommandBuffer commandbuffer, VkImage atlasimage, VkImageLayout layout,
+		VkFormat format, uint32_t tilewidth, uint32_t tileheight,
+		uint32_t columns, uint32_t rows);
+	// Composite the first SPOUTVK_COMPOSITE_LAYERS senders in a single compute dispatch.
+	// Senders are blended in order over transparent black.
+	// Without placements the senders are arranged in a grid.
+	bool ReceiveComposite(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		VkCommandBuffer commandbuffer, VkImage image, VkImageLayout layout,
+		VkFormat format, uint32_t width, uint32_t height,
+		const spoutVKplacement* placements = nullptr);
+	// Bindless array of the senders for sampling by index in one pass without copies.
+	// The device must be created with the descriptor indexing features
+	// descriptorBindingPartiallyBound, descriptorBindingUpdateUnusedWhilePending
+	// and shaderSampledImageArrayNonUniformIndexing.
+	// Binding 0 is an array of combined image samplers, one for each sender,
+	// and binding 1 a storage buffer with a spoutVKbindless entry for each.
+	bool EnableBindless(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		uint32_t maxSenders = SPOUTVK_BINDLESS_SENDERS);
+	VkDescriptorSetLayout GetBindlessLayout();
+	// Find and link the senders, update the descriptors that have changed and
+	// record one barrier for sampling. Access is held until EndBindless, which is
+	// called after the commands that sample the senders are recorded and records
+	// the return of the senders to the layout used by other processes.
+	bool BeginBindless(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		VkCommandBuffer commandbuffer, VkDescriptorSet& set);
+	void EndBindless(VkCommandBuffer commandbuffer);
+	const spoutVKbindless* GetBindlessTable();
+	void ReleaseReceivers(VkDevice logicaldevice);
+	bool EnableSynchronization2(VkDevice logicaldevice, bool bEnable = true);
+	// Timeline semaphore that the application signals with the value when the
+	// command buffers recorded after this call have completed. Linked images
+	// replaced while receiving are released when it is reached, otherwise
+	// the device waits before they are released.
+	void SetFrameTimeline(VkSemaphore semaphore, uint64_t value);
+
+private:
+
+	struct MultiSender {
+		char name[256] {};
+		uint32_t width = 0;
+		uint32_t height = 0;
+		DWORD dwFormat = 0;
+		HANDLE shareHandle = nullptr;
+		VkImage image = nullptr;
+		VkDeviceMemory memory = nullptr;
+		VkImageView view = nullptr;
+		uint32_t link = 0; // Unique for each linked image
+		spoutVKimageState state;
+		bool bConnected = false;
+		bool bAccess = false;
+		spoutFrameCount frame;
+		SpoutSharedMemory info; // SpoutVK sender information
+		int receiverSlot = -1;
+		uint64_t receiverTime = 0;
+	};
+
+	bool BeginReceive(VkPhysicalDevice physicaldevice, VkDevice logicaldevice, uint32_t count);
+	void EndReceive(VkCommandBuffer commandbuffer);
+	// Layers of an array image (columns = 0) or rows of atlas tiles
+	bool ReceiveRegions(VkPhysicalDevice physicaldevice, VkDevice logicaldevice,
+		VkCommandBuffer commandbuffer, VkImage image, VkImageLayout layout,
+		VkFormat format, uint32_t width, uint32_t height, uint32_t columns, uint32_t layers);
+	bool CreateComposite(VkDevice logicaldevice);
+	void ReleaseComposite(VkDevice logicaldevice);
+	bool CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+		VkBuffer& buffer, VkDeviceMemory& memory);
+	VkImageView GetSenderView(VkDevice logicaldevice, MultiSender& sender);
+	void ReleaseSender(VkDevice logicaldevice, MultiSender& sender);
+	void RegisterSender(MultiSender& sender);
+	void RetireSender(MultiSender& sender);
+	void ReleaseRetired(VkDevice logicaldevice, bool bAll);
+	VkFormatFeatureFlags GetFormatFeatures(VkPhysicalDevice physicaldevice, VkFormat format);
+
+	std::vector<std::unique_ptr<MultiSender>> m_Senders;
+	std::vector<std::unique_ptr<MultiSender>> m_Removed; // Released by the next receive
+	std::unordered_map<VkFormat, VkFormatFeatureFlags> m_FormatFeatures;
+	spoutVKbarriers m_barriers;
+	spoutSenderNames sendernames;
+	bool m_bCopyWarning = false;
+	uint32_t m_ReceiverId = 0; // Unique within the process
+
+	// Linked images replaced while frames are in flight
+	struct Retired {
+		VkImage image;
+		VkDeviceMemory memory;
+		VkImageView view;
+		VkSemaphore timeline;
+		uint64_t value;
+	};
+	std::vector<Retired> m_Retired;
+	VkSemaphore m_vkFrameTimeline = nullptr;
+	uint64_t m_FrameValue = 0;
+
+	// Composite
+	VkDevice m_vkDevice = nullptr;
+	VkPhysicalDevice m_vkPhysicalDevice = nullptr;
+	VkSampler m_vkSamplerLinear = nullptr;
+	VkSampler m_vkSamplerNearest = nullptr;
+	VkDescriptorSetLayout m_vkSetLayout = nullptr;
+	VkPipelineLayout m_vkPipelineLayout = nullptr;
+	VkPipeline m_vkPipeline = nullptr;
+	VkDescriptorPool m_vkPool = nullptr;
+	VkDescriptorSet m_vkSet = nullptr;
+	VkBuffer m_vkOutput = nullptr;
+	VkDeviceMemory m_vkOutputMemory = nullptr;
+	VkDeviceSize m_OutputSize = 0;
+	VkBuffer m_vkPlacements = nullptr;
+	VkDeviceMemory m_vkPlacementsMemory = nullptr;
+	VkImageView m_SetViews[SPOUTVK_COMPOSITE_LAYERS] {};
+	VkSampler m_SetSamplers[SPOUTVK_COMPOSITE_LAYERS] {};
+	VkBuffer m_SetOutput = nullptr;
+
+	// Bindless
+	uint32_t m_BindlessCount = 0; // Size of the array
+	VkSampler m_vkBindlessLinear = nullptr;
+	VkSampler m_vkBindlessNearest = nullptr;
+	VkDescriptorSetLayout m_vkBindlessLayout = nullptr;
+	VkDescriptorPool m_vkBindlessPool = nullptr;
+	VkDescriptorSet m_vkBindlessSet = nullptr;
+	VkBuffer m_vkBindlessTable = nullptr;
+	VkDeviceMemory m_vkBindlessTableMemory = nullptr;
+	uint32_t m_LinkClock = 0;
+	std::vector<uint32_t> m_BindlessLinks; // Linked image written to each element
+	std::vector<spoutVKbindless> m_BindlessTable;
+	void ReleaseBindless(VkDevice logicaldevice);
+
+};
+
 #endif
@@ -0,0 +1,858 @@
+#include "SpoutVKconvert.h"
+#include "SpoutDX\SpoutUtils.h"
+
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include <random>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#	define SPOUTVK_X86
+#	include <immintrin.h>
+#	if defined(_MSC_VER)
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#	define SPOUTVK_NEON
+#	include <arm_neon.h>
+#endif
+
+// Instruction sets for a function
+// Not required for Visual Studio, which allows all intrinsics
+#if defined(__GNUC__) || defined(__clang__)
+#	define SPOUTVK_TARGET(t) __attribute__((target(t)))
+#else
+#	define SPOUTVK_TARGET(t)
+#endif
+
+// Source and destination bytes per pixel for each conversion
+static const uint32_t srcBytes[] = { 4, 4, 4, 8, 16, 4 };
+static const uint32_t dstBytes[] = { 4, 4, 4, 16, 8, 3 };
+
+//
+// Scalar versions
+//
+// These are the reference for the SIMD versions,
+// which must produce the same result for all input.
+//
+
+static void rgba_bgra_scalar(const void* src, void* dst, uint32_t count)
+{
+	const uint32_t* s = (const uint32_t*)src;
+	uint32_t* d = (uint32_t*)dst;
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t p = s[i];
+		d[i] = (p & 0xFF00FF00) | ((p >> 16) & 0xFF) | ((p & 0xFF) << 16);
+	}
+}
+
+// Upper 8 bits of each 10 bit channel. 2 bit alpha is replicated to 8 bits.
+static void rgb10a2_rgba8_scalar(const void* src, void* dst, uint32_t count)
+{
+	const uint32_t* s = (const uint32_t*)src;
+	uint32_t* d = (uint32_t*)dst;
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t p = s[i];
+		uint32_t a = p >> 30;
+		d[i] = ((p >> 2) & 0xFF)
+			| (((p >> 12) & 0xFF) << 8)
+			| (((p >> 22) & 0xFF) << 16)
+			| ((a * 0x55) << 24);
+	}
+}
+
+// 8 bit channels replicated to 10 bits. Upper 2 bits of alpha.
+static void rgba8_rgb10a2_scalar(const void* src, void* dst, uint32_t count)
+{
+	const uint32_t* s = (const uint32_t*)src;
+	uint32_t* d = (uint32_t*)dst;
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t p = s[i];
+		uint32_t r = p & 0xFF;
+		uint32_t g = (p >> 8) & 0xFF;
+		uint32_t b = (p >> 16) & 0xFF;
+		d[i] = ((r << 2) | (r >> 6))
+			| (((g << 2) | (g >> 6)) << 10)
+			| (((b << 2) | (b >> 6)) << 20)
+			| ((p >> 30) << 30);
+	}
+}
+
+static uint32_t HalfToFloatBits(uint16_t h)
+{
+	uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+	uint32_t exp = (h >> 10) & 0x1F;
+	uint32_t mant = h & 0x3FF;
+
+	if (exp == 0x1F) // Infinity or NaN, quieted
+		return sign | 0x7F800000 | (mant << 13) | (mant ? 0x400000 : 0);
+
+	if (exp == 0) {
+		if (mant == 0)
+			return sign;
+		// Denormal, normalized for float
+		uint32_t e = 113;
+		while (!(mant & 0x400)) {
+			mant <<= 1;
+			e--;
+		}
+		return sign | (e << 23) | ((mant & 0x3FF) << 13);
+	}
+
+	return sign | ((exp + 112) << 23) | (mant << 13);
+}
+
+// Round to nearest even
+static uint16_t FloatBitsToHalf(uint32_t x)
+{
+	uint32_t sign = (x >> 16) & 0x8000;
+	uint32_t absx = x & 0x7FFFFFFF;
+
+	if (absx > 0x7F800000) // NaN, quieted with the upper bits of the payload
+		return (uint16_t)(sign | 0x7E00 | ((absx >> 13) & 0x3FF));
+
+	if (absx >= 0x477FF000) // 65520 and above round to infinity
+		return (uint16_t)(sign | 0x7C00);
+
+	uint32_t r = 0;
+	uint32_t rem = 0;
+	uint32_t half = 0;
+	if (absx < 0x38800000) {
+		// Half denormal, in units of 2^-24
+		if (absx <= 0x33000000) // 2^-25 and less round to zero
+			return (uint16_t)sign;
+		uint32_t shift = 126 - (absx >> 23);
+		uint32_t mant = (absx & 0x7FFFFF) | 0x800000;
+		r = mant >> shift;
+		rem = mant & ((1u << shift) - 1);
+		half = 1u << (shift - 1);
+	}
+	else {
+		// Exponent re-biased from 127 to 15
+		uint32_t v = absx - 0x38000000;
+		r = v >> 13;
+		rem = v & 0x1FFF;
+		half = 0x1000;
+	}
+	if (rem > half || (rem == half && (r & 1)))
+		r++; // Can carry into the exponent
+
+	return (uint16_t)(sign | r);
+}
+
+static void rgba16f_rgba32f_scalar(const void* src, void* dst, uint32_t count)
+{
+	const uint16_t* s = (const uint16_t*)src;
+	uint32_t* d = (uint32_t*)dst;
+	for (uint32_t i = 0; i < count*4; i++)
+		d[i] = HalfToFloatBits(s[i]);
+}
+
+static void rgba32f_rgba16f_scalar(const void* src, void* dst, uint32_t count)
+{
+	const uint32_t* s = (const uint32_t*)src;
+	uint16_t* d = (uint16_t*)dst;
+	for (uint32_t i = 0; i < count*4; i++)
+		d[i] = FloatBitsToHalf(s[i]);
+}
+
+static void rgba8_rgb8_scalar(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	for (uint32_t i = 0; i < count; i++) {
+		d[0] = s[0];
+		d[1] = s[1];
+		d[2] = s[2];
+		s += 4;
+		d += 3;
+	}
+}
+
+#ifdef SPOUTVK_X86
+
+//
+// SSE2
+//
+// Without SSSE3 byte shuffles the channels are moved with shifts and masks
+// in 32 bit lanes. There is no SSE2 half float conversion and no SSE2
+// version of rgba8_rgb8, so the scalar versions are used.
+//
+
+static void rgba_bgra_sse2(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	const __m128i ag = _mm_set1_epi32(0xFF00FF00);
+	const __m128i lo = _mm_set1_epi32(0x000000FF);
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i p = _mm_loadu_si128((const __m128i*)(s + i*4));
+		__m128i r = _mm_and_si128(_mm_srli_epi32(p, 16), lo);
+		__m128i b = _mm_slli_epi32(_mm_and_si128(p, lo), 16);
+		p = _mm_or_si128(_mm_and_si128(p, ag), _mm_or_si128(r, b));
+		_mm_storeu_si128((__m128i*)(d + i*4), p);
+	}
+	rgba_bgra_scalar(s + i*4, d + i*4, count - i);
+}
+
+static void rgb10a2_rgba8_sse2(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	const __m128i mask = _mm_set1_epi32(0xFF);
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i p = _mm_loadu_si128((const __m128i*)(s + i*4));
+		__m128i r = _mm_and_si128(_mm_srli_epi32(p, 2), mask);
+		__m128i g = _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(p, 12), mask), 8);
+		__m128i b = _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(p, 22), mask), 16);
+		// 2 bit alpha repeated 4 times in the top byte
+		__m128i a = _mm_srli_epi32(p, 30);
+		a = _mm_or_si128(a, _mm_slli_epi32(a, 2));
+		a = _mm_or_si128(a, _mm_slli_epi32(a, 4));
+		a = _mm_slli_epi32(a, 24);
+		p = _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+		_mm_storeu_si128((__m128i*)(d + i*4), p);
+	}
+	rgb10a2_rgba8_scalar(s + i*4, d + i*4, count - i);
+}
+
+static void rgba8_rgb10a2_sse2(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	const __m128i mask = _mm_set1_epi32(0xFF);
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i p = _mm_loadu_si128((const __m128i*)(s + i*4));
+		__m128i r = _mm_and_si128(p, mask);
+		__m128i g = _mm_and_si128(_mm_srli_epi32(p, 8), mask);
+		__m128i b = _mm_and_si128(_mm_srli_epi32(p, 16), mask);
+		r = _mm_or_si128(_mm_slli_epi32(r, 2), _mm_srli_epi32(r, 6));
+		g = _mm_or_si128(_mm_slli_epi32(g, 2), _mm_srli_epi32(g, 6));
+		b = _mm_or_si128(_mm_slli_epi32(b, 2), _mm_srli_epi32(b, 6));
+		__m128i a = _mm_slli_epi32(_mm_srli_epi32(p, 30), 30);
+		p = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 10)),
+			_mm_or_si128(_mm_slli_epi32(b, 20), a));
+		_mm_storeu_si128((__m128i*)(d + i*4), p);
+	}
+	rgba8_rgb10a2_scalar(s + i*4, d + i*4, count - i);
+}
+
+//
+// AVX2
+//
+// Half float conversion uses F16C, which is required for this level.
+//
+
+SPOUTVK_TARGET("avx2")
+static void rgba_bgra_avx2(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	const __m256i swap = _mm256_setr_epi8(
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i p = _mm256_loadu_si256((const __m256i*)(s + i*4));
+		_mm256_storeu_si256((__m256i*)(d + i*4), _mm256_shuffle_epi8(p, swap));
+	}
+	rgba_bgra_scalar(s + i*4, d + i*4, count - i);
+}
+
+SPOUTVK_TARGET("avx2")
+static void rgb10a2_rgba8_avx2(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	const __m256i mask = _mm256_set1_epi32(0xFF);
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i p = _mm256_loadu_si256((const __m256i*)(s + i*4));
+		__m256i r = _mm256_and_si256(_mm256_srli_epi32(p, 2), mask);
+		__m256i g = _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(p, 12), mask), 8);
+		__m256i b = _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(p, 22), mask), 16);
+		__m256i a = _mm256_srli_epi32(p, 30);
+		a = _mm256_or_si256(a, _mm256_slli_epi32(a, 2));
+		a = _mm256_or_si256(a, _mm256_slli_epi32(a, 4));
+		a = _mm256_slli_epi32(a, 24);
+		p = _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, a));
+		_mm256_storeu_si256((__m256i*)(d + i*4), p);
+	}
+	rgb10a2_rgba8_scalar(s + i*4, d + i*4, count - i);
+}
+
+SPOUTVK_TARGET("avx2")
+static void rgba8_rgb10a2_avx2(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	const __m256i mask = _mm256_set1_epi32(0xFF);
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i p = _mm256_loadu_si256((const __m256i*)(s + i*4));
+		__m256i r = _mm256_and_si256(p, mask);
+		__m256i g = _mm256_and_si256(_mm256_srli_epi32(p, 8), mask);
+		__m256i b = _mm256_and_si256(_mm256_srli_epi32(p, 16), mask);
+		r = _mm256_or_si256(_mm256_slli_epi32(r, 2), _mm256_srli_epi32(r, 6));
+		g = _mm256_or_si256(_mm256_slli_epi32(g, 2), _mm256_srli_epi32(g, 6));
+		b = _mm256_or_si256(_mm256_slli_epi32(b, 2), _mm256_srli_epi32(b, 6));
+		__m256i a = _mm256_slli_epi32(_mm256_srli_epi32(p, 30), 30);
+		p = _mm256_or_si256(_mm256_or_si256(r, _mm256_slli_epi32(g, 10)),
+			_mm256_or_si256(_mm256_slli_epi32(b, 20), a));
+		_mm256_storeu_si256((__m256i*)(d + i*4), p);
+	}
+	rgba8_rgb10a2_scalar(s + i*4, d + i*4, count - i);
+}
+
+SPOUTVK_TARGET("avx2,f16c")
+static void rgba16f_rgba32f_avx2(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	uint32_t i = 0;
+	// 2 pixels, 8 channels
+	for (; i + 2 <= count; i += 2) {
+		__m128i h = _mm_loadu_si128((const __m128i*)(s + i*8));
+		_mm256_storeu_ps((float*)(d + i*16), _mm256_cvtph_ps(h));
+	}
+	rgba16f_rgba32f_scalar(s + i*8, d + i*16, count - i);
+}
+
+SPOUTVK_TARGET("avx2,f16c")
+static void rgba32f_rgba16f_avx2(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	uint32_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		__m256 f = _mm256_loadu_ps((const float*)(s + i*16));
+		_mm_storeu_si128((__m128i*)(d + i*8), _mm256_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT));
+	}
+	rgba32f_rgba16f_scalar(s + i*16, d + i*8, count - i);
+}
+
+// 8 pixels to 24 bytes. Each 128 bit lane is packed to 12 bytes
+// and the two lanes are joined by a permute.
+SPOUTVK_TARGET("avx2")
+static void rgba8_rgb8_avx2(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	const __m256i pack = _mm256_setr_epi8(
+		0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+		0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+	const __m256i join = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+	const __m256i store = _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, 0, 0);
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i p = _mm256_loadu_si256((const __m256i*)(s + i*4));
+		p = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(p, pack), join);
+		_mm256_maskstore_epi32((int*)(d + i*3), store, p);
+	}
+	rgba8_rgb8_scalar(s + i*4, d + i*3, count - i);
+}
+
+//
+// AVX-512
+//
+// Requires AVX-512F and BW. The 10 bit conversions use AVX2 because
+// they are limited by memory bandwidth rather than instructions.
+//
+
+SPOUTVK_TARGET("avx512f,avx512bw")
+static void rgba_bgra_avx512(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	const __m512i swap = _mm512_broadcast_i32x4(_mm_setr_epi8(
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15));
+	uint32_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m512i p = _mm512_loadu_si512((const void*)(s + i*4));
+		_mm512_storeu_si512((void*)(d + i*4), _mm512_shuffle_epi8(p, swap));
+	}
+	// Remaining pixels with a mask
+	if (i < count) {
+		__mmask16 m = (__mmask16)((1u << (count - i)) - 1);
+		__m512i p = _mm512_maskz_loadu_epi32(m, (const void*)(s + i*4));
+		_mm512_mask_storeu_epi32((void*)(d + i*4), m, _mm512_shuffle_epi8(p, swap));
+	}
+}
+
+SPOUTVK_TARGET("avx512f")
+static void rgba16f_rgba32f_avx512(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	uint32_t i = 0;
+	// 4 pixels, 16 channels
+	for (; i + 4 <= count; i += 4) {
+		__m256i h = _mm256_loadu_si256((const __m256i*)(s + i*8));
+		_mm512_storeu_ps((void*)(d + i*16), _mm512_cvtph_ps(h));
+	}
+	rgba16f_rgba32f_scalar(s + i*8, d + i*16, count - i);
+}
+
+SPOUTVK_TARGET("avx512f")
+static void rgba32f_rgba16f_avx512(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m512 f = _mm512_loadu_ps((const void*)(s + i*16));
+		_mm256_storeu_si256((__m256i*)(d + i*8), _mm512_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT));
+	}
+	rgba32f_rgba16f_scalar(s + i*16, d + i*8, count - i);
+}
+
+// 16 pixels to 48 bytes
+SPOUTVK_TARGET("avx512f,avx512bw")
+static void rgba8_rgb8_avx512(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	const __m512i pack = _mm512_broadcast_i32x4(_mm_setr_epi8(
+		0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1));
+	const __m512i join = _mm512_setr_epi32(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 3, 7, 11, 15);
+	uint32_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m512i p = _mm512_loadu_si512((const void*)(s + i*4));
+		p = _mm512_permutexvar_epi32(join, _mm512_shuffle_epi8(p, pack));
+		_mm512_mask_storeu_epi32((void*)(d + i*3), 0x0FFF, p);
+	}
+	rgba8_rgb8_scalar(s + i*4, d + i*3, count - i);
+}
+
+#endif // SPOUTVK_X86
+
+#ifdef SPOUTVK_NEON
+
+//
+// NEON
+//
+// Interleaved loads and stores separate the channels.
+//
+
+static void rgba_bgra_neon(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	uint32_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		uint8x16x4_t p = vld4q_u8(s + i*4);
+		uint8x16_t r = p.val[0];
+		p.val[0] = p.val[2];
+		p.val[2] = r;
+		vst4q_u8(d + i*4, p);
+	}
+	rgba_bgra_scalar(s + i*4, d + i*4, count - i);
+}
+
+static void rgb10a2_rgba8_neon(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	const uint32x4_t mask = vdupq_n_u32(0xFF);
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		uint32x4_t p = vld1q_u32((const uint32_t*)(s + i*4));
+		uint32x4_t r = vandq_u32(vshrq_n_u32(p, 2), mask);
+		uint32x4_t g = vshlq_n_u32(vandq_u32(vshrq_n_u32(p, 12), mask), 8);
+		uint32x4_t b = vshlq_n_u32(vandq_u32(vshrq_n_u32(p, 22), mask), 16);
+		uint32x4_t a = vmulq_n_u32(vshrq_n_u32(p, 30), 0x55);
+		p = vorrq_u32(vorrq_u32(r, g), vorrq_u32(b, vshlq_n_u32(a, 24)));
+		vst1q_u32((uint32_t*)(d + i*4), p);
+	}
+	rgb10a2_rgba8_scalar(s + i*4, d + i*4, count - i);
+}
+
+static void rgba8_rgb10a2_neon(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	const uint32x4_t mask = vdupq_n_u32(0xFF);
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		uint32x4_t p = vld1q_u32((const uint32_t*)(s + i*4));
+		uint32x4_t r = vandq_u32(p, mask);
+		uint32x4_t g = vandq_u32(vshrq_n_u32(p, 8), mask);
+		uint32x4_t b = vandq_u32(vshrq_n_u32(p, 16), mask);
+		r = vorrq_u32(vshlq_n_u32(r, 2), vshrq_n_u32(r, 6));
+		g = vorrq_u32(vshlq_n_u32(g, 2), vshrq_n_u32(g, 6));
+		b = vorrq_u32(vshlq_n_u32(b, 2), vshrq_n_u32(b, 6));
+		uint32x4_t a = vshlq_n_u32(vshrq_n_u32(p, 30), 30);
+		p = vorrq_u32(vorrq_u32(r, vshlq_n_u32(g, 10)), vorrq_u32(vshlq_n_u32(b, 20), a));
+		vst1q_u32((uint32_t*)(d + i*4), p);
+	}
+	rgba8_rgb10a2_scalar(s + i*4, d + i*4, count - i);
+}
+
+static void rgba16f_rgba32f_neon(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	uint32_t i = 0;
+	// 1 pixel, 4 channels
+	for (; i < count; i++) {
+		float16x4_t h = vreinterpret_f16_u16(vld1_u16((const uint16_t*)(s + i*8)));
+		vst1q_f32((float*)(d + i*16), vcvt_f32_f16(h));
+	}
+}
+
+static void rgba32f_rgba16f_neon(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	uint32_t i = 0;
+	for (; i < count; i++) {
+		float32x4_t f = vld1q_f32((const float*)(s + i*16));
+		vst1_u16((uint16_t*)(d + i*8), vreinterpret_u16_f16(vcvt_f16_f32(f)));
+	}
+}
+
+static void rgba8_rgb8_neon(const void* src, void* dst, uint32_t count)
+{
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	uint32_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		uint8x16x4_t p = vld4q_u8(s + i*4);
+		uint8x16x3_t rgb = { { p.val[0], p.val[1], p.val[2] } };
+		vst3q_u8(d + i*3, rgb);
+	}
+	rgba8_rgb8_scalar(s + i*4, d + i*3, count - i);
+}
+
+#endif // SPOUTVK_NEON
+
+
+spoutVKconvert::spoutVKconvert()
+{
+	SetSIMDlevel(DetectSIMDlevel());
+}
+
+//
+// CPUID is checked once for the process.
+// AVX2 and AVX-512 also require the operating system
+// to save the extended registers (XGETBV).
+//
+spoutVKconvert::simdLevel spoutVKconvert::DetectSIMDlevel()
+{
+	static simdLevel level = []() {
+#if defined(SPOUTVK_X86)
+		unsigned int r1[4]{}; // eax, ebx, ecx, edx for leaf 1
+		unsigned int r7[4]{}; // leaf 7
+#if defined(_MSC_VER)
+		__cpuid((int*)r1, 1);
+		__cpuidex((int*)r7, 7, 0);
+#else
+		__get_cpuid(1, &r1[0], &r1[1], &r1[2], &r1[3]);
+		__get_cpuid_count(7, 0, &r7[0], &r7[1], &r7[2], &r7[3]);
+#endif
+		bool bSSE2 = (r1[3] & (1u << 26)) != 0;
+		bool bOSXSAVE = (r1[2] & (1u << 27)) != 0;
+		bool bAVX = (r1[2] & (1u << 28)) != 0;
+		bool bF16C = (r1[2] & (1u << 29)) != 0;
+		bool bAVX2 = (r7[1] & (1u << 5)) != 0;
+		bool bAVX512F = (r7[1] & (1u << 16)) != 0;
+		bool bAVX512BW = (r7[1] & (1u << 30)) != 0;
+
+		unsigned long long xcr0 = 0;
+		if (bOSXSAVE) {
+#if defined(_MSC_VER)
+			xcr0 = _xgetbv(0);
+#else
+			unsigned int lo = 0, hi = 0;
+			__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+			xcr0 = ((unsigned long long)hi << 32) | lo;
+#endif
+		}
+		bool bYMM = (xcr0 & 0x06) == 0x06; // SSE and AVX state
+		bool bZMM = (xcr0 & 0xE6) == 0xE6; // and opmask, ZMM state
+
+		if (bAVX && bAVX2 && bF16C && bYMM && bAVX512F && bAVX512BW && bZMM)
+			return SIMD_AVX512;
+		if (bAVX && bAVX2 && bF16C && bYMM)
+			return SIMD_AVX2;
+		if (bSSE2)
+			return SIMD_SSE2;
+		return SIMD_SCALAR;
+#elif defined(SPOUTVK_NEON)
+		return SIMD_NEON; // Always present for ARM64
+#else
+		return SIMD_SCALAR;
+#endif
+	}();
+	return level;
+}
+
+spoutVKconvert::simdLevel spoutVKconvert::GetSIMDlevel()
+{
+	return m_Level;
+}
+
+const char* spoutVKconvert::GetSIMDname(simdLevel level)
+{
+	switch (level) {
+		case SIMD_SSE2:   return "SSE2";
+		case SIMD_AVX2:   return "AVX2";
+		case SIMD_AVX512: return "AVX-512";
+		case SIMD_NEON:   return "NEON";
+		default:          return "scalar";
+	}
+}
+
+bool spoutVKconvert::SetSIMDlevel(simdLevel level)
+{
+	simdLevel detected = DetectSIMDlevel();
+	bool bSupported = (level == SIMD_SCALAR)
+		|| (level == SIMD_NEON && detected == SIMD_NEON)
+		|| (level != SIMD_NEON && detected != SIMD_NEON && level <= detected);
+	if (!bSupported)
+		return false;
+
+	m_Level = level;
+	for (int i = 0; i < CONVERT_COUNT; i++)
+		m_Rows[i] = GetRowFunction((rowConversion)i, level);
+
+	return true;
+}
+
+// The fastest row function up to the level requested
+spoutVKconvert::rowFunction spoutVKconvert::GetRowFunction(rowConversion conversion, simdLevel level)
+{
+#if defined(SPOUTVK_X86)
+	if (level >= SIMD_AVX512 && level != SIMD_NEON) {
+		switch (conversion) {
+			case CONVERT_RGBA_BGRA:       return rgba_bgra_avx512;
+			case CONVERT_RGBA16F_RGBA32F: return rgba16f_rgba32f_avx512;
+			case CONVERT_RGBA32F_RGBA16F: return rgba32f_rgba16f_avx512;
+			case CONVERT_RGBA8_RGB8:      return rgba8_rgb8_avx512;
+			default: break;
+		}
+	}
+	if (level >= SIMD_AVX2 && level != SIMD_NEON) {
+		switch (conversion) {
+			case CONVERT_RGBA_BGRA:       return rgba_bgra_avx2;
+			case CONVERT_RGB10A2_RGBA8:   return rgb10a2_rgba8_avx2;
+			case CONVERT_RGBA8_RGB10A2:   return rgba8_rgb10a2_avx2;
+			case CONVERT_RGBA16F_RGBA32F: return rgba16f_rgba32f_avx2;
+			case CONVERT_RGBA32F_RGBA16F: return rgba32f_rgba16f_avx2;
+			case CONVERT_RGBA8_RGB8:      return rgba8_rgb8_avx2;
+			default: break;
+		}
+	}
+	if (level >= SIMD_SSE2 && level != SIMD_NEON) {
+		switch (conversion) {
+			case CONVERT_RGBA_BGRA:       return rgba_bgra_sse2;
+			case CONVERT_RGB10A2_RGBA8:   return rgb10a2_rgba8_sse2;
+			case CONVERT_RGBA8_RGB10A2:   return rgba8_rgb10a2_sse2;
+			default: break;
+		}
+	}
+#elif defined(SPOUTVK_NEON)
+	if (level == SIMD_NEON) {
+		switch (conversion) {
+			case CONVERT_RGBA_BGRA:       return rgba_bgra_neon;
+			case CONVERT_RGB10A2_RGBA8:   return rgb10a2_rgba8_neon;
+			case CONVERT_RGBA8_RGB10A2:   return rgba8_rgb10a2_neon;
+			case CONVERT_RGBA16F_RGBA32F: return rgba16f_rgba32f_neon;
+			case CONVERT_RGBA32F_RGBA16F: return rgba32f_rgba16f_neon;
+			case CONVERT_RGBA8_RGB8:      return rgba8_rgb8_neon;
+			default: break;
+		}
+	}
+#endif
+
+	switch (conversion) {
+		case CONVERT_RGBA_BGRA:       return rgba_bgra_scalar;
+		case CONVERT_RGB10A2_RGBA8:   return rgb10a2_rgba8_scalar;
+		case CONVERT_RGBA8_RGB10A2:   return rgba8_rgb10a2_scalar;
+		case CONVERT_RGBA16F_RGBA32F: return rgba16f_rgba32f_scalar;
+		case CONVERT_RGBA32F_RGBA16F: return rgba32f_rgba16f_scalar;
+		default:                      return rgba8_rgb8_scalar;
+	}
+}
+
+void spoutVKconvert::ConvertRows(rowConversion conversion, const void* src, void* dst,
+	uint32_t width, uint32_t height, uint32_t srcPitch, uint32_t dstPitch)
+{
+	if (!src || !dst || width == 0 || height == 0)
+		return;
+
+	if (srcPitch == 0) srcPitch = width*srcBytes[conversion];
+	if (dstPitch == 0) dstPitch = width*dstBytes[conversion];
+
+	// Rows with no padding are converted together
+	if (srcPitch == width*srcBytes[conversion] && dstPitch == width*dstBytes[conversion]) {
+		width *= height;
+		height = 1;
+	}
+
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	for (uint32_t y = 0; y < height; y++) {
+		m_Rows[conversion](s, d, width);
+		s += srcPitch;
+		d += dstPitch;
+	}
+}
+
+void spoutVKconvert::rgba_bgra(const void* src, void* dst, uint32_t width, uint32_t height,
+	uint32_t srcPitch, uint32_t dstPitch)
+{
+	ConvertRows(CONVERT_RGBA_BGRA, src, dst, width, height, srcPitch, dstPitch);
+}
+
+void spoutVKconvert::rgb10a2_rgba8(const void* src, void* dst, uint32_t width, uint32_t height,
+	uint32_t srcPitch, uint32_t dstPitch)
+{
+	ConvertRows(CONVERT_RGB10A2_RGBA8, src, dst, width, height, srcPitch, dstPitch);
+}
+
+void spoutVKconvert::rgba8_rgb10a2(const void* src, void* dst, uint32_t width, uint32_t height,
+	uint32_t srcPitch, uint32_t dstPitch)
+{
+	ConvertRows(CONVERT_RGBA8_RGB10A2, src, dst, width, height, srcPitch, dstPitch);
+}
+
+void spoutVKconvert::rgba16f_rgba32f(const void* src, void* dst, uint32_t width, uint32_t height,
+	uint32_t srcPitch, uint32_t dstPitch)
+{
+	ConvertRows(CONVERT_RGBA16F_RGBA32F, src, dst, width, height, srcPitch, dstPitch);
+}
+
+void spoutVKconvert::rgba32f_rgba16f(const void* src, void* dst, uint32_t width, uint32_t height,
+	uint32_t srcPitch, uint32_t dstPitch)
+{
+	ConvertRows(CONVERT_RGBA32F_RGBA16F, src, dst, width, height, srcPitch, dstPitch);
+}
+
+void spoutVKconvert::rgba8_rgb8(const void* src, void* dst, uint32_t width, uint32_t height,
+	uint32_t srcPitch, uint32_t dstPitch)
+{
+	ConvertRows(CONVERT_RGBA8_RGB8, src, dst, width, height, srcPitch, dstPitch);
+}
+
+//
+// Formats returned by spoutVK::GetVulkanFormat, and 3 byte formats for encoders.
+// BGRA8 to and from A2B10G10R10 is not supported because it needs two passes.
+//
+bool spoutVKconvert::Convert(const void* src, VkFormat srcFormat, void* dst, VkFormat dstFormat,
+	uint32_t width, uint32_t height, uint32_t srcPitch, uint32_t dstPitch)
+{
+	rowConversion conversion = CONVERT_COUNT;
+	if ((srcFormat == VK_FORMAT_R8G8B8A8_UNORM && dstFormat == VK_FORMAT_B8G8R8A8_UNORM)
+		|| (srcFormat == VK_FORMAT_B8G8R8A8_UNORM && dstFormat == VK_FORMAT_R8G8B8A8_UNORM))
+		conversion = CONVERT_RGBA_BGRA;
+	else if (srcFormat == VK_FORMAT_A2B10G10R10_UNORM_PACK32 && dstFormat == VK_FORMAT_R8G8B8A8_UNORM)
+		conversion = CONVERT_RGB10A2_RGBA8;
+	else if (srcFormat == VK_FORMAT_R8G8B8A8_UNORM && dstFormat == VK_FORMAT_A2B10G10R10_UNORM_PACK32)
+		conversion = CONVERT_RGBA8_RGB10A2;
+	else if (srcFormat == VK_FORMAT_R16G16B16A16_SFLOAT && dstFormat == VK_FORMAT_R32G32B32A32_SFLOAT)
+		conversion = CONVERT_RGBA16F_RGBA32F;
+	else if (srcFormat == VK_FORMAT_R32G32B32A32_SFLOAT && dstFormat == VK_FORMAT_R16G16B16A16_SFLOAT)
+		conversion = CONVERT_RGBA32F_RGBA16F;
+	else if ((srcFormat == VK_FORMAT_R8G8B8A8_UNORM && dstFormat == VK_FORMAT_R8G8B8_UNORM)
+		|| (srcFormat == VK_FORMAT_B8G8R8A8_UNORM && dstFormat == VK_FORMAT_B8G8R8_UNORM))
+		conversion = CONVERT_RGBA8_RGB8;
+
+	if (conversion == CONVERT_COUNT) {
+		SpoutLogWarning("spoutVKconvert::Convert - no conversion from format %d to %d", srcFormat, dstFormat);
+		return false;
+	}
+
+	ConvertRows(conversion, src, dst, width, height, srcPitch, dstPitch);
+	return true;
+}
+
+//
+// Random source pixels cover all values of 8 and 10 bit channels and all
+// half floats, including denormals, infinity and NaN. Float sources are
+// random bits for special values and random values in the half float range.
+// The width is odd so that the remainder after each SIMD block is checked.
+//
+bool spoutVKconvert::Benchmark(uint32_t width, uint32_t height, int iterations)
+{
+	static const char* names[] = {
+		"rgba_bgra", "rgb10a2_rgba8", "rgba8_rgb10a2",
+		"rgba16f_rgba32f", "rgba32f_rgba16f", "rgba8_rgb8" };
+
+	width |= 1;
+	if (iterations < 1)
+		iterations = 1;
+
+	simdLevel current = m_Level;
+	std::mt19937 rng(1);
+	bool bExact = true;
+
+	for (int c = 0; c < CONVERT_COUNT; c++) {
+		std::vector<uint8_t> src((size_t)width*height*srcBytes[c]);
+		std::vector<uint8_t> ref((size_t)width*height*dstBytes[c]);
+		std::vector<uint8_t> dst(ref.size());
+
+		if (c == CONVERT_RGBA32F_RGBA16F) {
+			std::uniform_real_distribution<float> values(-70000.0f, 70000.0f);
+			std::uniform_real_distribution<float> small(-0.0001f, 0.0001f);
+			float* f = (float*)src.data();
+			for (size_t i = 0; i < src.size()/4; i++) {
+				uint32_t bits = rng();
+				switch (i % 4) {
+					case 0: memcpy(&f[i], &bits, 4); break;
+					case 1: f[i] = small(rng); break; // Denormal halves
+					default: f[i] = values(rng); break;
+				}
+			}
+		}
+		else {
+			for (size_t i = 0; i < src.size(); i++)
+				src[i] = (uint8_t)rng();
+		}
+
+		// The scalar version is first for reference
+		double reference = 0.0;
+		rowFunction tested = nullptr;
+		for (int level = SIMD_SCALAR; level <= SIMD_NEON; level++) {
+			if (!SetSIMDlevel((simdLevel)level))
+				continue;
+			// Skip a level that has no version of its own
+			if (m_Rows[c] == tested)
+				continue;
+			tested = m_Rows[c];
+
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < iterations; i++)
+				ConvertRows((rowConversion)c, src.data(), dst.data(), width, height, 0, 0);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			double gbps = (double)(src.size() + dst.size())*iterations/seconds/1.0e9;
+
+			if (level == SIMD_SCALAR) {
+				ref = dst;
+				reference = gbps;
+				SpoutLogNotice("spoutVKconvert::Benchmark - %-16s %-8s %6.2f GB/s",
+					names[c], GetSIMDname((simdLevel)level), gbps);
+			}
+			else {
+				bool bMatch = (memcmp(ref.data(), dst.data(), ref.size()) == 0);
+				if (!bMatch)
+					bExact = false;
+				SpoutLogNotice("spoutVKconvert::Benchmark - %-16s %-8s %6.2f GB/s  x%.1f  %s",
+					names[c], GetSIMDname((simdLevel)level), gbps,
+					reference > 0.0 ? gbps/reference : 0.0, bMatch ? "exact" : "MISMATCH");
+			}
+		}
+	}
+
+	SetSIMDlevel(current);
+
+	if (!bExact)
+		SpoutLogError("spoutVKconvert::Benchmark - SIMD conversion differs from scalar");
+
+	return bExact;
+}
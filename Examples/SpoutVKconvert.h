@@ -0,0 +1,102 @@
+//
+// SpoutVKconvert.h
+//
+// Pixel format conversion for pixels in host memory,
+// for example received by ReceiveToMemory or sent by SendPixels.
+//
+// Each conversion has a scalar version and SSE2, AVX2, AVX-512 or NEON
+// versions where the instructions can be used. The fastest supported by
+// the CPU is selected once, when the first object is created.
+//
+// Conversions :
+//
+//	rgba_bgra       - RGBA8 <> BGRA8 swap red and blue
+//	rgb10a2_rgba8   - A2B10G10R10 to RGBA8, upper 8 bits of each 10 bit channel
+//	rgba8_rgb10a2   - RGBA8 to A2B10G10R10, 8 bit channels replicated to 10 bits
+//	rgba16f_rgba32f - RGBA16F to RGBA32F
+//	rgba32f_rgba16f - RGBA32F to RGBA16F, rounded to nearest even
+//	rgba8_rgb8      - RGBA8 to RGB8 (or BGRA8 to BGR8), alpha removed
+//
+// NaN values remain NaN after float conversion, quieted as by F16C.
+//
+// Source and destination pitch are the row size in bytes.
+// Zero for rows with no padding.
+//
+
+#pragma once
+#ifndef __spoutVKconvert__
+#define __spoutVKconvert__
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+
+class spoutVKconvert {
+
+public:
+
+	spoutVKconvert();
+
+	enum simdLevel {
+		SIMD_SCALAR,
+		SIMD_SSE2,
+		SIMD_AVX2,
+		SIMD_AVX512,
+		SIMD_NEON
+	};
+
+	// Level selected for this CPU
+	simdLevel GetSIMDlevel();
+	const char* GetSIMDname(simdLevel level);
+	// Use a lower level, for example to compare with the scalar versions.
+	// Returns false if the level is not supported by the CPU.
+	bool SetSIMDlevel(simdLevel level);
+
+	void rgba_bgra(const void* src, void* dst, uint32_t width, uint32_t height,
+		uint32_t srcPitch = 0, uint32_t dstPitch = 0);
+	void rgb10a2_rgba8(const void* src, void* dst, uint32_t width, uint32_t height,
+		uint32_t srcPitch = 0, uint32_t dstPitch = 0);
+	void rgba8_rgb10a2(const void* src, void* dst, uint32_t width, uint32_t height,
+		uint32_t srcPitch = 0, uint32_t dstPitch = 0);
+	void rgba16f_rgba32f(const void* src, void* dst, uint32_t width, uint32_t height,
+		uint32_t srcPitch = 0, uint32_t dstPitch = 0);
+	void rgba32f_rgba16f(const void* src, void* dst, uint32_t width, uint32_t height,
+		uint32_t srcPitch = 0, uint32_t dstPitch = 0);
+	void rgba8_rgb8(const void* src, void* dst, uint32_t width, uint32_t height,
+		uint32_t srcPitch = 0, uint32_t dstPitch = 0);
+
+	// Convert between formats using the conversions above.
+	// Returns false if there is no conversion for the formats.
+	bool Convert(const void* src, VkFormat srcFormat, void* dst, VkFormat dstFormat,
+		uint32_t width, uint32_t height, uint32_t srcPitch = 0, uint32_t dstPitch = 0);
+
+	// Compare each conversion for the levels supported with the
+	// scalar version and log throughput in GB/s (source and destination).
+	// Returns false if any result is not bit exact.
+	bool Benchmark(uint32_t width = 1920, uint32_t height = 1080, int iterations = 20);
+
+private:
+
+	// Convert a row of pixels
+	typedef void (*rowFunction)(const void* src, void* dst, uint32_t count);
+
+	enum rowConversion {
+		CONVERT_RGBA_BGRA,
+		CONVERT_RGB10A2_RGBA8,
+		CONVERT_RGBA8_RGB10A2,
+		CONVERT_RGBA16F_RGBA32F,
+		CONVERT_RGBA32F_RGBA16F,
+		CONVERT_RGBA8_RGB8,
+		CONVERT_COUNT
+	};
+
+	void ConvertRows(rowConversion conversion, const void* src, void* dst,
+		uint32_t width, uint32_t height, uint32_t srcPitch, uint32_t dstPitch);
+	static rowFunction GetRowFunction(rowConversion conversion, simdLevel level);
+	static simdLevel DetectSIMDlevel();
+
+	simdLevel m_Level = SIMD_SCALAR;
+	rowFunction m_Rows[CONVERT_COUNT] {};
+
+};
+
+#endif
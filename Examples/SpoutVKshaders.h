@@ -0,0 +1,506 @@
+//
+// SpoutVKshaders.h
+//
+// SPIR-V compute shaders used by SpoutVK.
+//
+// The shaders are embedded so that SpoutVK does not depend on shader files.
+// The GLSL source of each shader is shown with it and the SPIR-V can be
+// regenerated with :
+//
+//    glslangValidator -V --vn <name> -o <name>.h <name>.comp
+//
+
+#pragma once
+#ifndef __spoutVKshaders__
+#define __spoutVKshaders__
+
+#include <stdint.h>
+
+//
+// Scale and convert
+//
+// Resample a source image into a buffer of packed pixels for copy to a destination image.
+// Bilinear sampling at the centre of each destination pixel, or a box filter of
+// taps x taps bilinear samples within the pixel footprint for large downscales.
+// The buffer is packed for the destination format, including channel swizzle.
+//
+//	#version 450
+//	layout(local_size_x = 16, local_size_y = 16) in;
+//	layout(binding = 0) uniform sampler2D srcImage;
+//	layout(std430, binding = 1) buffer Pixels { uint data[]; } dst;
+//	layout(push_constant) uniform Params {
+//		vec2 srcOrigin; // source region origin (normalized)
+//		vec2 srcScale;  // source region size (normalized)
+//		uvec2 dstSize;  // destination size (pixels)
+//		uint format;    // 0 RGBA8, 1 BGRA8, 2 A2B10G10R10, 3 RGBA16, 4 RGBA16F, 5 RGBA32F
+//		uint taps;      // box filter taps per axis, 1 for bilinear
+//	} p;
+//
+//	void main()
+//	{
+//		uvec2 pos = gl_GlobalInvocationID.xy;
+//		if (!all(lessThan(pos, p.dstSize)))
+//			return;
+//		uint taps = max(p.taps, 1u);
+//		vec2 texel = p.srcScale / vec2(p.dstSize);
+//		vec2 step = texel / float(taps);
+//		vec2 base = p.srcOrigin + vec2(pos) * texel + step * 0.5;
+//		uint count = taps * taps;
+//		vec4 sum = vec4(0.0);
+//		for (uint k = 0u; k < count; k++)
+//			sum += textureLod(srcImage, base + vec2(uvec2(k % taps, k / taps)) * step, 0.0);
+//		vec4 c = sum / float(count);
+//		uint index = pos.y * p.dstSize.x + pos.x;
+//		switch (p.format) {
+//			case 0u: dst.data[index] = packUnorm4x8(c); break;
+//			case 1u: dst.data[index] = packUnorm4x8(c.bgra); break;
+//			case 2u: {
+//				uvec4 u = uvec4(round(clamp(c, 0.0, 1.0) * vec4(1023.0, 1023.0, 1023.0, 3.0)));
+//				dst.data[index] = u.r | (u.g << 10) | (u.b << 20) | (u.a << 30);
+//				break;
+//			}
+//			case 3u:
+//				dst.data[index * 2u] = packUnorm2x16(c.rg);
+//				dst.data[index * 2u + 1u] = packUnorm2x16(c.ba);
+//				break;
+//			case 4u:
+//				dst.data[index * 2u] = packHalf2x16(c.rg);
+//				dst.data[index * 2u + 1u] = packHalf2x16(c.ba);
+//				break;
+//			default: {
+//				uvec4 u = floatBitsToUint(c);
+//				dst.data[index * 4u] = u.r;
+//				dst.data[index * 4u + 1u] = u.g;
+//				dst.data[index * 4u + 2u] = u.b;
+//				dst.data[index * 4u + 3u] = u.a;
+//				break;
+//			}
+//		}
+//	}
+//
+static const uint32_t spoutvk_scale_comp[] = {
+	0x07230203, 0x00010000, 0x00000000, 0x000000a3, 0x00000000, 0x00020011, 0x00000001, 0x0006000b,
+	0x00000001, 0x4c534c47, 0x6474732e, 0x3035342e, 0x00000000, 0x0003000e, 0x00000000, 0x00000001,
+	0x0006000f, 0x00000005, 0x00000002, 0x6e69616d, 0x00000000, 0x00000003, 0x00060010, 0x00000002,
+	0x00000011, 0x00000010, 0x00000010, 0x00000001, 0x00040047, 0x00000003, 0x0000000b, 0x0000001c,
+	0x00040047, 0x00000004, 0x00000022, 0x00000000, 0x00040047, 0x00000004, 0x00000021, 0x00000000,
+	0x00040047, 0x00000005, 0x00000006, 0x00000004, 0x00050048, 0x00000006, 0x00000000, 0x00000023,
+	0x00000000, 0x00030047, 0x00000006, 0x00000003, 0x00040047, 0x00000007, 0x00000022, 0x00000000,
+	0x00040047, 0x00000007, 0x00000021, 0x00000001, 0x00050048, 0x00000008, 0x00000000, 0x00000023,
+	0x00000000, 0x00050048, 0x00000008, 0x00000001, 0x00000023, 0x00000008, 0x00050048, 0x00000008,
+	0x00000002, 0x00000023, 0x00000010, 0x00050048, 0x00000008, 0x00000003, 0x00000023, 0x00000018,
+	0x00050048, 0x00000008, 0x00000004, 0x00000023, 0x0000001c, 0x00030047, 0x00000008, 0x00000002,
+	0x00020013, 0x00000009, 0x00030021, 0x0000000a, 0x00000009, 0x00020014, 0x0000000b, 0x00040017,
+	0x0000000c, 0x0000000b, 0x00000002, 0x00040015, 0x0000000d, 0x00000020, 0x00000000, 0x00030016,
+	0x0000000e, 0x00000020, 0x00040017, 0x0000000f, 0x0000000e, 0x00000002, 0x00040017, 0x00000010,
+	0x0000000e, 0x00000004, 0x00040017, 0x00000011, 0x0000000d, 0x00000002, 0x00040017, 0x00000012,
+	0x0000000d, 0x00000003, 0x00040017, 0x00000013, 0x0000000d, 0x00000004, 0x00090019, 0x00000014,
+	0x0000000e, 0x00000001, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000000, 0x0003001b,
+	0x00000015, 0x00000014, 0x00040020, 0x00000016, 0x00000000, 0x00000015, 0x0004003b, 0x00000016,
+	0x00000004, 0x00000000, 0x0003001d, 0x00000005, 0x0000000d, 0x0003001e, 0x00000006, 0x00000005,
+	0x00040020, 0x00000017, 0x00000002, 0x00000006, 0x0004003b, 0x00000017, 0x00000007, 0x00000002,
+	0x00040020, 0x00000018, 0x00000002, 0x0000000d, 0x0007001e, 0x00000008, 0x0000000f, 0x0000000f,
+	0x00000011, 0x0000000d, 0x0000000d, 0x00040020, 0x00000019, 0x00000009, 0x00000008, 0x0004003b,
+	0x00000019, 0x0000001a, 0x00000009, 0x00040020, 0x0000001b, 0x00000009, 0x0000000f, 0x00040020,
+	0x0000001c, 0x00000009, 0x00000011, 0x00040020, 0x0000001d, 0x00000009, 0x0000000d, 0x00040020,
+	0x0000001e, 0x00000001, 0x00000012, 0x0004003b, 0x0000001e, 0x00000003, 0x00000001, 0x00040020,
+	0x0000001f, 0x00000007, 0x0000000d, 0x00040020, 0x00000020, 0x00000007, 0x00000010, 0x0004002b,
+	0x0000000d, 0x00000021, 0x00000000, 0x0004002b, 0x0000000d, 0x00000022, 0x00000001, 0x0004002b,
+	0x0000000d, 0x00000023, 0x00000002, 0x0004002b, 0x0000000d, 0x00000024, 0x00000003, 0x0004002b,
+	0x0000000d, 0x00000025, 0x00000004, 0x0004002b, 0x0000000d, 0x00000026, 0x0000000a, 0x0004002b,
+	0x0000000d, 0x00000027, 0x00000014, 0x0004002b, 0x0000000d, 0x00000028, 0x0000001e, 0x0004002b,
+	0x0000000e, 0x00000029, 0x00000000, 0x0004002b, 0x0000000e, 0x0000002a, 0x3f000000, 0x0004002b,
+	0x0000000e, 0x0000002b, 0x3f800000, 0x0004002b, 0x0000000e, 0x0000002c, 0x40400000, 0x0004002b,
+	0x0000000e, 0x0000002d, 0x447fc000, 0x0007002c, 0x00000010, 0x0000002e, 0x00000029, 0x00000029,
+	0x00000029, 0x00000029, 0x0007002c, 0x00000010, 0x0000002f, 0x0000002b, 0x0000002b, 0x0000002b,
+	0x0000002b, 0x0007002c, 0x00000010, 0x00000030, 0x0000002d, 0x0000002d, 0x0000002d, 0x0000002c,
+	0x00050036, 0x00000009, 0x00000002, 0x00000000, 0x0000000a, 0x000200f8, 0x00000031, 0x0004003b,
+	0x0000001f, 0x00000032, 0x00000007, 0x0004003b, 0x00000020, 0x00000033, 0x00000007, 0x0004003d,
+	0x00000012, 0x00000034, 0x00000003, 0x0007004f, 0x00000011, 0x00000035, 0x00000034, 0x00000034,
+	0x00000000, 0x00000001, 0x00050041, 0x0000001c, 0x00000036, 0x0000001a, 0x00000023, 0x0004003d,
+	0x00000011, 0x00000037, 0x00000036, 0x000500b0, 0x0000000c, 0x00000038, 0x00000035, 0x00000037,
+	0x0004009b, 0x0000000b, 0x00000039, 0x00000038, 0x000300f7, 0x0000003a, 0x00000000, 0x000400fa,
+	0x00000039, 0x0000003a, 0x0000003b, 0x000200f8, 0x0000003b, 0x000100fd, 0x000200f8, 0x0000003a,
+	0x00050041, 0x0000001b, 0x0000003c, 0x0000001a, 0x00000021, 0x0004003d, 0x0000000f, 0x0000003d,
+	0x0000003c, 0x00050041, 0x0000001b, 0x0000003e, 0x0000001a, 0x00000022, 0x0004003d, 0x0000000f,
+	0x0000003f, 0x0000003e, 0x00050041, 0x0000001d, 0x00000040, 0x0000001a, 0x00000025, 0x0004003d,
+	0x0000000d, 0x00000041, 0x00000040, 0x0007000c, 0x0000000d, 0x00000042, 0x00000001, 0x00000029,
+	0x00000041, 0x00000022, 0x00040070, 0x0000000e, 0x00000043, 0x00000042, 0x00050088, 0x0000000e,
+	0x00000044, 0x0000002b, 0x00000043, 0x00040070, 0x0000000f, 0x00000045, 0x00000037, 0x00050088,
+	0x0000000f, 0x00000046, 0x0000003f, 0x00000045, 0x0005008e, 0x0000000f, 0x00000047, 0x00000046,
+	0x00000044, 0x00040070, 0x0000000f, 0x00000048, 0x00000035, 0x00050085, 0x0000000f, 0x00000049,
+	0x00000048, 0x00000046, 0x00050081, 0x0000000f, 0x0000004a, 0x0000003d, 0x00000049, 0x0005008e,
+	0x0000000f, 0x0000004b, 0x00000047, 0x0000002a, 0x00050081, 0x0000000f, 0x0000004c, 0x0000004a,
+	0x0000004b, 0x00050084, 0x0000000d, 0x0000004d, 0x00000042, 0x00000042, 0x0003003e, 0x00000032,
+	0x00000021, 0x0003003e, 0x00000033, 0x0000002e, 0x000200f9, 0x0000004e, 0x000200f8, 0x0000004e,
+	0x000400f6, 0x0000004f, 0x00000050, 0x00000000, 0x000200f9, 0x00000051, 0x000200f8, 0x00000051,
+	0x0004003d, 0x0000000d, 0x00000052, 0x00000032, 0x000500b0, 0x0000000b, 0x00000053, 0x00000052,
+	0x0000004d, 0x000400fa, 0x00000053, 0x00000054, 0x0000004f, 0x000200f8, 0x00000054, 0x00050089,
+	0x0000000d, 0x00000055, 0x00000052, 0x00000042, 0x00050086, 0x0000000d, 0x00000056, 0x00000052,
+	0x00000042, 0x00050050, 0x00000011, 0x00000057, 0x00000055, 0x00000056, 0x00040070, 0x0000000f,
+	0x00000058, 0x00000057, 0x00050085, 0x0000000f, 0x00000059, 0x00000058, 0x00000047, 0x00050081,
+	0x0000000f, 0x0000005a, 0x0000004c, 0x00000059, 0x0004003d, 0x00000015, 0x0000005b, 0x00000004,
+	0x00070058, 0x00000010, 0x0000005c, 0x0000005b, 0x0000005a, 0x00000002, 0x00000029, 0x0004003d,
+	0x00000010, 0x0000005d, 0x00000033, 0x00050081, 0x00000010, 0x0000005e, 0x0000005d, 0x0000005c,
+	0x0003003e, 0x00000033, 0x0000005e, 0x000200f9, 0x00000050, 0x000200f8, 0x00000050, 0x00050080,
+	0x0000000d, 0x0000005f, 0x00000052, 0x00000022, 0x0003003e, 0x00000032, 0x0000005f, 0x000200f9,
+	0x0000004e, 0x000200f8, 0x0000004f, 0x0004003d, 0x00000010, 0x00000060, 0x00000033, 0x00040070,
+	0x0000000e, 0x00000061, 0x0000004d, 0x00050088, 0x0000000e, 0x00000062, 0x0000002b, 0x00000061,
+	0x0005008e, 0x00000010, 0x00000063, 0x00000060, 0x00000062, 0x00050051, 0x0000000d, 0x00000064,
+	0x00000035, 0x00000000, 0x00050051, 0x0000000d, 0x00000065, 0x00000035, 0x00000001, 0x00050051,
+	0x0000000d, 0x00000066, 0x00000037, 0x00000000, 0x00050084, 0x0000000d, 0x00000067, 0x00000065,
+	0x00000066, 0x00050080, 0x0000000d, 0x00000068, 0x00000067, 0x00000064, 0x00050041, 0x0000001d,
+	0x00000069, 0x0000001a, 0x00000024, 0x0004003d, 0x0000000d, 0x0000006a, 0x00000069, 0x000300f7,
+	0x0000006b, 0x00000000, 0x000d00fb, 0x0000006a, 0x0000006c, 0x00000000, 0x0000006d, 0x00000001,
+	0x0000006e, 0x00000002, 0x0000006f, 0x00000003, 0x00000070, 0x00000004, 0x00000071, 0x000200f8,
+	0x0000006d, 0x0006000c, 0x0000000d, 0x00000072, 0x00000001, 0x00000037, 0x00000063, 0x00060041,
+	0x00000018, 0x00000073, 0x00000007, 0x00000021, 0x00000068, 0x0003003e, 0x00000073, 0x00000072,
+	0x000200f9, 0x0000006b, 0x000200f8, 0x0000006e, 0x0009004f, 0x00000010, 0x00000074, 0x00000063,
+	0x00000063, 0x00000002, 0x00000001, 0x00000000, 0x00000003, 0x0006000c, 0x0000000d, 0x00000075,
+	0x00000001, 0x00000037, 0x00000074, 0x00060041, 0x00000018, 0x00000076, 0x00000007, 0x00000021,
+	0x00000068, 0x0003003e, 0x00000076, 0x00000075, 0x000200f9, 0x0000006b, 0x000200f8, 0x0000006f,
+	0x0008000c, 0x00000010, 0x00000077, 0x00000001, 0x0000002b, 0x00000063, 0x0000002e, 0x0000002f,
+	0x00050085, 0x00000010, 0x00000078, 0x00000077, 0x00000030, 0x0006000c, 0x00000010, 0x00000079,
+	0x00000001, 0x00000001, 0x00000078, 0x0004006d, 0x00000013, 0x0000007a, 0x00000079, 0x00050051,
+	0x0000000d, 0x0000007b, 0x0000007a, 0x00000000, 0x00050051, 0x0000000d, 0x0000007c, 0x0000007a,
+	0x00000001, 0x00050051, 0x0000000d, 0x0000007d, 0x0000007a, 0x00000002, 0x00050051, 0x0000000d,
+	0x0000007e, 0x0000007a, 0x00000003, 0x000500c4, 0x0000000d, 0x0000007f, 0x0000007c, 0x00000026,
+	0x000500c4, 0x0000000d, 0x00000080, 0x0000007d, 0x00000027, 0x000500c4, 0x0000000d, 0x00000081,
+	0x0000007e, 0x00000028, 0x000500c5, 0x0000000d, 0x00000082, 0x0000007b, 0x0000007f, 0x000500c5,
+	0x0000000d, 0x00000083, 0x00000082, 0x00000080, 0x000500c5, 0x0000000d, 0x00000084, 0x00000083,
+	0x00000081, 0x00060041, 0x00000018, 0x00000085, 0x00000007, 0x00000021, 0x00000068, 0x0003003e,
+	0x00000085, 0x00000084, 0x000200f9, 0x0000006b, 0x000200f8, 0x00000070, 0x0007004f, 0x0000000f,
+	0x00000086, 0x00000063, 0x00000063, 0x00000000, 0x00000001, 0x0007004f, 0x0000000f, 0x00000087,
+	0x00000063, 0x00000063, 0x00000002, 0x00000003, 0x0006000c, 0x0000000d, 0x00000088, 0x00000001,
+	0x00000039, 0x00000086, 0x0006000c, 0x0000000d, 0x00000089, 0x00000001, 0x00000039, 0x00000087,
+	0x00050084, 0x0000000d, 0x0000008a, 0x00000068, 0x00000023, 0x00050080, 0x0000000d, 0x0000008b,
+	0x0000008a, 0x00000022, 0x00060041, 0x00000018, 0x0000008c, 0x00000007, 0x00000021, 0x0000008a,
+	0x0003003e, 0x0000008c, 0x00000088, 0x00060041, 0x00000018, 0x0000008d, 0x00000007, 0x00000021,
+	0x0000008b, 0x0003003e, 0x0000008d, 0x00000089, 0x000200f9, 0x0000006b, 0x000200f8, 0x00000071,
+	0x0007004f, 0x0000000f, 0x0000008e, 0x00000063, 0x00000063, 0x00000000, 0x00000001, 0x0007004f,
+	0x0000000f, 0x0000008f, 0x00000063, 0x00000063, 0x00000002, 0x00000003, 0x0006000c, 0x0000000d,
+	0x00000090, 0x00000001, 0x0000003a, 0x0000008e, 0x0006000c, 0x0000000d, 0x00000091, 0x00000001,
+	0x0000003a, 0x0000008f, 0x00050084, 0x0000000d, 0x00000092, 0x00000068, 0x00000023, 0x00050080,
+	0x0000000d, 0x00000093, 0x00000092, 0x00000022, 0x00060041, 0x00000018, 0x00000094, 0x00000007,
+	0x00000021, 0x00000092, 0x0003003e, 0x00000094, 0x00000090, 0x00060041, 0x00000018, 0x00000095,
+	0x00000007, 0x00000021, 0x00000093, 0x0003003e, 0x00000095, 0x00000091, 0x000200f9, 0x0000006b,
+	0x000200f8, 0x0000006c, 0x0004007c, 0x00000013, 0x00000096, 0x00000063, 0x00050084, 0x0000000d,
+	0x00000097, 0x00000068, 0x00000025, 0x00050080, 0x0000000d, 0x00000098, 0x00000097, 0x00000022,
+	0x00050080, 0x0000000d, 0x00000099, 0x00000097, 0x00000023, 0x00050080, 0x0000000d, 0x0000009a,
+	0x00000097, 0x00000024, 0x00050051, 0x0000000d, 0x0000009b, 0x00000096, 0x00000000, 0x00050051,
+	0x0000000d, 0x0000009c, 0x00000096, 0x00000001, 0x00050051, 0x0000000d, 0x0000009d, 0x00000096,
+	0x00000002, 0x00050051, 0x0000000d, 0x0000009e, 0x00000096, 0x00000003, 0x00060041, 0x00000018,
+	0x0000009f, 0x00000007, 0x00000021, 0x00000097, 0x0003003e, 0x0000009f, 0x0000009b, 0x00060041,
+	0x00000018, 0x000000a0, 0x00000007, 0x00000021, 0x00000098, 0x0003003e, 0x000000a0, 0x0000009c,
+	0x00060041, 0x00000018, 0x000000a1, 0x00000007, 0x00000021, 0x00000099, 0x0003003e, 0x000000a1,
+	0x0000009d, 0x00060041, 0x00000018, 0x000000a2, 0x00000007, 0x00000021, 0x0000009a, 0x0003003e,
+	0x000000a2, 0x0000009e, 0x000200f9, 0x0000006b, 0x000200f8, 0x0000006b, 0x000100fd, 0x00010038,
+};
+
+//
+// Composite
+//
+// Blend up to 8 images into a buffer of packed pixels for copy to a destination image.
+// Each image is placed at a rectangle in destination pixels and blended in order
+// over transparent black with its alpha multiplied by the placement alpha.
+// The images are indexed with constants so that dynamic indexing is not required.
+// The buffer is packed as for the scale and convert shader.
+//
+//	#version 450
+//	layout(local_size_x = 16, local_size_y = 16) in;
+//	layout(binding = 0) uniform sampler2D layers[8];
+//	layout(std430, binding = 1) buffer Pixels { uint data[]; } dst;
+//	layout(std140, binding = 2) uniform Placements {
+//		vec4 rect[8];    // x, y, width, height (pixels)
+//		vec4 opacity[8]; // alpha in x
+//	} place;
+//	layout(push_constant) uniform Params {
+//		uvec2 dstSize; // destination size (pixels)
+//		uint format;   // as for the scale and convert shader
+//		uint count;    // number of images
+//	} p;
+//
+//	void main()
+//	{
+//		uvec2 pos = gl_GlobalInvocationID.xy;
+//		if (!all(lessThan(pos, p.dstSize)))
+//			return;
+//		vec2 centre = vec2(pos) + 0.5;
+//		vec4 c = vec4(0.0);
+//		// Unrolled for i = 0 to 7
+//		if (i < p.count) {
+//			vec2 uv = (centre - place.rect[i].xy) / place.rect[i].zw;
+//			if (all(greaterThanEqual(uv, vec2(0.0))) && all(lessThan(uv, vec2(1.0)))) {
+//				vec4 s = textureLod(layers[i], uv, 0.0);
+//				c = mix(c, vec4(s.rgb, 1.0), s.a * place.opacity[i].x);
+//			}
+//		}
+//		uint index = pos.y * p.dstSize.x + pos.x;
+//		switch (p.format) {
+//			// Packed as for the scale and convert shader
+//		}
+//	}
+//
+static const uint32_t spoutvk_composite_comp[] = {
+	0x07230203, 0x00010000, 0x00000000, 0x0000016c, 0x00000000, 0x00020011, 0x00000001, 0x0006000b,
+	0x00000001, 0x4c534c47, 0x6474732e, 0x3035342e, 0x00000000, 0x0003000e, 0x00000000, 0x00000001,
+	0x0006000f, 0x00000005, 0x00000002, 0x6e69616d, 0x00000000, 0x00000003, 0x00060010, 0x00000002,
+	0x00000011, 0x00000010, 0x00000010, 0x00000001, 0x00040047, 0x00000003, 0x0000000b, 0x0000001c,
+	0x00040047, 0x00000004, 0x00000022, 0x00000000, 0x00040047, 0x00000004, 0x00000021, 0x00000000,
+	0x00040047, 0x00000005, 0x00000006, 0x00000004, 0x00050048, 0x00000006, 0x00000000, 0x00000023,
+	0x00000000, 0x00030047, 0x00000006, 0x00000003, 0x00040047, 0x00000007, 0x00000022, 0x00000000,
+	0x00040047, 0x00000007, 0x00000021, 0x00000001, 0x00040047, 0x00000008, 0x00000006, 0x00000010,
+	0x00050048, 0x00000009, 0x00000000, 0x00000023, 0x00000000, 0x00050048, 0x00000009, 0x00000001,
+	0x00000023, 0x00000080, 0x00030047, 0x00000009, 0x00000002, 0x00040047, 0x0000000a, 0x00000022,
+	0x00000000, 0x00040047, 0x0000000a, 0x00000021, 0x00000002, 0x00050048, 0x0000000b, 0x00000000,
+	0x00000023, 0x00000000, 0x00050048, 0x0000000b, 0x00000001, 0x00000023, 0x00000008, 0x00050048,
+	0x0000000b, 0x00000002, 0x00000023, 0x0000000c, 0x00030047, 0x0000000b, 0x00000002, 0x00020013,
+	0x0000000c, 0x00030021, 0x0000000d, 0x0000000c, 0x00020014, 0x0000000e, 0x00040017, 0x0000000f,
+	0x0000000e, 0x00000002, 0x00040015, 0x00000010, 0x00000020, 0x00000000, 0x00030016, 0x00000011,
+	0x00000020, 0x00040017, 0x00000012, 0x00000011, 0x00000002, 0x00040017, 0x00000013, 0x00000011,
+	0x00000004, 0x00040017, 0x00000014, 0x00000010, 0x00000002, 0x00040017, 0x00000015, 0x00000010,
+	0x00000003, 0x00040017, 0x00000016, 0x00000010, 0x00000004, 0x0004002b, 0x00000010, 0x00000017,
+	0x00000000, 0x0004002b, 0x00000010, 0x00000018, 0x00000001, 0x0004002b, 0x00000010, 0x00000019,
+	0x00000002, 0x0004002b, 0x00000010, 0x0000001a, 0x00000003, 0x0004002b, 0x00000010, 0x0000001b,
+	0x00000004, 0x0004002b, 0x00000010, 0x0000001c, 0x00000005, 0x0004002b, 0x00000010, 0x0000001d,
+	0x00000006, 0x0004002b, 0x00000010, 0x0000001e, 0x00000007, 0x0004002b, 0x00000010, 0x0000001f,
+	0x00000008, 0x0004002b, 0x00000010, 0x00000020, 0x0000000a, 0x0004002b, 0x00000010, 0x00000021,
+	0x00000014, 0x0004002b, 0x00000010, 0x00000022, 0x0000001e, 0x00090019, 0x00000023, 0x00000011,
+	0x00000001, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000000, 0x0003001b, 0x00000024,
+	0x00000023, 0x0004001c, 0x00000025, 0x00000024, 0x0000001f, 0x00040020, 0x00000026, 0x00000000,
+	0x00000024, 0x00040020, 0x00000027, 0x00000000, 0x00000025, 0x0004003b, 0x00000027, 0x00000004,
+	0x00000000, 0x0003001d, 0x00000005, 0x00000010, 0x0003001e, 0x00000006, 0x00000005, 0x00040020,
+	0x00000028, 0x00000002, 0x00000006, 0x0004003b, 0x00000028, 0x00000007, 0x00000002, 0x00040020,
+	0x00000029, 0x00000002, 0x00000010, 0x0004001c, 0x00000008, 0x00000013, 0x0000001f, 0x0004001e,
+	0x00000009, 0x00000008, 0x00000008, 0x00040020, 0x0000002a, 0x00000002, 0x00000009, 0x0004003b,
+	0x0000002a, 0x0000000a, 0x00000002, 0x00040020, 0x0000002b, 0x00000002, 0x00000013, 0x0005001e,
+	0x0000000b, 0x00000014, 0x00000010, 0x00000010, 0x00040020, 0x0000002c, 0x00000009, 0x0000000b,
+	0x0004003b, 0x0000002c, 0x0000002d, 0x00000009, 0x00040020, 0x0000002e, 0x00000009, 0x00000014,
+	0x00040020, 0x0000002f, 0x00000009, 0x00000010, 0x00040020, 0x00000030, 0x00000001, 0x00000015,
+	0x0004003b, 0x00000030, 0x00000003, 0x00000001, 0x00040020, 0x00000031, 0x00000007, 0x00000013,
+	0x0004002b, 0x00000011, 0x00000032, 0x00000000, 0x0004002b, 0x00000011, 0x00000033, 0x3f000000,
+	0x0004002b, 0x00000011, 0x00000034, 0x3f800000, 0x0004002b, 0x00000011, 0x00000035, 0x40400000,
+	0x0004002b, 0x00000011, 0x00000036, 0x447fc000, 0x0005002c, 0x00000012, 0x00000037, 0x00000032,
+	0x00000032, 0x0005002c, 0x00000012, 0x00000038, 0x00000034, 0x00000034, 0x0005002c, 0x00000012,
+	0x00000039, 0x00000033, 0x00000033, 0x0007002c, 0x00000013, 0x0000003a, 0x00000032, 0x00000032,
+	0x00000032, 0x00000032, 0x0007002c, 0x00000013, 0x0000003b, 0x00000034, 0x00000034, 0x00000034,
+	0x00000034, 0x0007002c, 0x00000013, 0x0000003c, 0x00000036, 0x00000036, 0x00000036, 0x00000035,
+	0x00050036, 0x0000000c, 0x00000002, 0x00000000, 0x0000000d, 0x000200f8, 0x0000003d, 0x0004003b,
+	0x00000031, 0x0000003e, 0x00000007, 0x0004003d, 0x00000015, 0x0000003f, 0x00000003, 0x0007004f,
+	0x00000014, 0x00000040, 0x0000003f, 0x0000003f, 0x00000000, 0x00000001, 0x00050041, 0x0000002e,
+	0x00000041, 0x0000002d, 0x00000017, 0x0004003d, 0x00000014, 0x00000042, 0x00000041, 0x000500b0,
+	0x0000000f, 0x00000043, 0x00000040, 0x00000042, 0x0004009b, 0x0000000e, 0x00000044, 0x00000043,
+	0x000300f7, 0x00000045, 0x00000000, 0x000400fa, 0x00000044, 0x00000045, 0x00000046, 0x000200f8,
+	0x00000046, 0x000100fd, 0x000200f8, 0x00000045, 0x00050041, 0x0000002f, 0x00000047, 0x0000002d,
+	0x00000019, 0x0004003d, 0x00000010, 0x00000048, 0x00000047, 0x00040070, 0x00000012, 0x00000049,
+	0x00000040, 0x00050081, 0x00000012, 0x0000004a, 0x00000049, 0x00000039, 0x0003003e, 0x0000003e,
+	0x0000003a, 0x000200f9, 0x0000004b, 0x000200f8, 0x0000004b, 0x000500b0, 0x0000000e, 0x0000004c,
+	0x00000017, 0x00000048, 0x000300f7, 0x0000004d, 0x00000000, 0x000400fa, 0x0000004c, 0x0000004e,
+	0x0000004d, 0x000200f8, 0x0000004e, 0x00060041, 0x0000002b, 0x0000004f, 0x0000000a, 0x00000017,
+	0x00000017, 0x0004003d, 0x00000013, 0x00000050, 0x0000004f, 0x0007004f, 0x00000012, 0x00000051,
+	0x00000050, 0x00000050, 0x00000000, 0x00000001, 0x0007004f, 0x00000012, 0x00000052, 0x00000050,
+	0x00000050, 0x00000002, 0x00000003, 0x00050083, 0x00000012, 0x00000053, 0x0000004a, 0x00000051,
+	0x00050088, 0x00000012, 0x00000054, 0x00000053, 0x00000052, 0x000500be, 0x0000000f, 0x00000055,
+	0x00000054, 0x00000037, 0x000500b8, 0x0000000f, 0x00000056, 0x00000054, 0x00000038, 0x000500a7,
+	0x0000000f, 0x00000057, 0x00000055, 0x00000056, 0x0004009b, 0x0000000e, 0x00000058, 0x00000057,
+	0x000300f7, 0x00000059, 0x00000000, 0x000400fa, 0x00000058, 0x0000005a, 0x00000059, 0x000200f8,
+	0x0000005a, 0x00050041, 0x00000026, 0x0000005b, 0x00000004, 0x00000017, 0x0004003d, 0x00000024,
+	0x0000005c, 0x0000005b, 0x00070058, 0x00000013, 0x0000005d, 0x0000005c, 0x00000054, 0x00000002,
+	0x00000032, 0x00060041, 0x0000002b, 0x0000005e, 0x0000000a, 0x00000018, 0x00000017, 0x0004003d,
+	0x00000013, 0x0000005f, 0x0000005e, 0x00050051, 0x00000011, 0x00000060, 0x0000005f, 0x00000000,
+	0x00050051, 0x00000011, 0x00000061, 0x0000005d, 0x00000003, 0x00050085, 0x00000011, 0x00000062,
+	0x00000061, 0x00000060, 0x00070050, 0x00000013, 0x00000063, 0x00000062, 0x00000062, 0x00000062,
+	0x00000062, 0x00060052, 0x00000013, 0x00000064, 0x00000034, 0x0000005d, 0x00000003, 0x0004003d,
+	0x00000013, 0x00000065, 0x0000003e, 0x0008000c, 0x00000013, 0x00000066, 0x00000001, 0x0000002e,
+	0x00000065, 0x00000064, 0x00000063, 0x0003003e, 0x0000003e, 0x00000066, 0x000200f9, 0x00000059,
+	0x000200f8, 0x00000059, 0x000200f9, 0x0000004d, 0x000200f8, 0x0000004d, 0x000200f9, 0x00000067,
+	0x000200f8, 0x00000067, 0x000500b0, 0x0000000e, 0x00000068, 0x00000018, 0x00000048, 0x000300f7,
+	0x00000069, 0x00000000, 0x000400fa, 0x00000068, 0x0000006a, 0x00000069, 0x000200f8, 0x0000006a,
+	0x00060041, 0x0000002b, 0x0000006b, 0x0000000a, 0x00000017, 0x00000018, 0x0004003d, 0x00000013,
+	0x0000006c, 0x0000006b, 0x0007004f, 0x00000012, 0x0000006d, 0x0000006c, 0x0000006c, 0x00000000,
+	0x00000001, 0x0007004f, 0x00000012, 0x0000006e, 0x0000006c, 0x0000006c, 0x00000002, 0x00000003,
+	0x00050083, 0x00000012, 0x0000006f, 0x0000004a, 0x0000006d, 0x00050088, 0x00000012, 0x00000070,
+	0x0000006f, 0x0000006e, 0x000500be, 0x0000000f, 0x00000071, 0x00000070, 0x00000037, 0x000500b8,
+	0x0000000f, 0x00000072, 0x00000070, 0x00000038, 0x000500a7, 0x0000000f, 0x00000073, 0x00000071,
+	0x00000072, 0x0004009b, 0x0000000e, 0x00000074, 0x00000073, 0x000300f7, 0x00000075, 0x00000000,
+	0x000400fa, 0x00000074, 0x00000076, 0x00000075, 0x000200f8, 0x00000076, 0x00050041, 0x00000026,
+	0x00000077, 0x00000004, 0x00000018, 0x0004003d, 0x00000024, 0x00000078, 0x00000077, 0x00070058,
+	0x00000013, 0x00000079, 0x00000078, 0x00000070, 0x00000002, 0x00000032, 0x00060041, 0x0000002b,
+	0x0000007a, 0x0000000a, 0x00000018, 0x00000018, 0x0004003d, 0x00000013, 0x0000007b, 0x0000007a,
+	0x00050051, 0x00000011, 0x0000007c, 0x0000007b, 0x00000000, 0x00050051, 0x00000011, 0x0000007d,
+	0x00000079, 0x00000003, 0x00050085, 0x00000011, 0x0000007e, 0x0000007d, 0x0000007c, 0x00070050,
+	0x00000013, 0x0000007f, 0x0000007e, 0x0000007e, 0x0000007e, 0x0000007e, 0x00060052, 0x00000013,
+	0x00000080, 0x00000034, 0x00000079, 0x00000003, 0x0004003d, 0x00000013, 0x00000081, 0x0000003e,
+	0x0008000c, 0x00000013, 0x00000082, 0x00000001, 0x0000002e, 0x00000081, 0x00000080, 0x0000007f,
+	0x0003003e, 0x0000003e, 0x00000082, 0x000200f9, 0x00000075, 0x000200f8, 0x00000075, 0x000200f9,
+	0x00000069, 0x000200f8, 0x00000069, 0x000200f9, 0x00000083, 0x000200f8, 0x00000083, 0x000500b0,
+	0x0000000e, 0x00000084, 0x00000019, 0x00000048, 0x000300f7, 0x00000085, 0x00000000, 0x000400fa,
+	0x00000084, 0x00000086, 0x00000085, 0x000200f8, 0x00000086, 0x00060041, 0x0000002b, 0x00000087,
+	0x0000000a, 0x00000017, 0x00000019, 0x0004003d, 0x00000013, 0x00000088, 0x00000087, 0x0007004f,
+	0x00000012, 0x00000089, 0x00000088, 0x00000088, 0x00000000, 0x00000001, 0x0007004f, 0x00000012,
+	0x0000008a, 0x00000088, 0x00000088, 0x00000002, 0x00000003, 0x00050083, 0x00000012, 0x0000008b,
+	0x0000004a, 0x00000089, 0x00050088, 0x00000012, 0x0000008c, 0x0000008b, 0x0000008a, 0x000500be,
+	0x0000000f, 0x0000008d, 0x0000008c, 0x00000037, 0x000500b8, 0x0000000f, 0x0000008e, 0x0000008c,
+	0x00000038, 0x000500a7, 0x0000000f, 0x0000008f, 0x0000008d, 0x0000008e, 0x0004009b, 0x0000000e,
+	0x00000090, 0x0000008f, 0x000300f7, 0x00000091, 0x00000000, 0x000400fa, 0x00000090, 0x00000092,
+	0x00000091, 0x000200f8, 0x00000092, 0x00050041, 0x00000026, 0x00000093, 0x00000004, 0x00000019,
+	0x0004003d, 0x00000024, 0x00000094, 0x00000093, 0x00070058, 0x00000013, 0x00000095, 0x00000094,
+	0x0000008c, 0x00000002, 0x00000032, 0x00060041, 0x0000002b, 0x00000096, 0x0000000a, 0x00000018,
+	0x00000019, 0x0004003d, 0x00000013, 0x00000097, 0x00000096, 0x00050051, 0x00000011, 0x00000098,
+	0x00000097, 0x00000000, 0x00050051, 0x00000011, 0x00000099, 0x00000095, 0x00000003, 0x00050085,
+	0x00000011, 0x0000009a, 0x00000099, 0x00000098, 0x00070050, 0x00000013, 0x0000009b, 0x0000009a,
+	0x0000009a, 0x0000009a, 0x0000009a, 0x00060052, 0x00000013, 0x0000009c, 0x00000034, 0x00000095,
+	0x00000003, 0x0004003d, 0x00000013, 0x0000009d, 0x0000003e, 0x0008000c, 0x00000013, 0x0000009e,
+	0x00000001, 0x0000002e, 0x0000009d, 0x0000009c, 0x0000009b, 0x0003003e, 0x0000003e, 0x0000009e,
+	0x000200f9, 0x00000091, 0x000200f8, 0x00000091, 0x000200f9, 0x00000085, 0x000200f8, 0x00000085,
+	0x000200f9, 0x0000009f, 0x000200f8, 0x0000009f, 0x000500b0, 0x0000000e, 0x000000a0, 0x0000001a,
+	0x00000048, 0x000300f7, 0x000000a1, 0x00000000, 0x000400fa, 0x000000a0, 0x000000a2, 0x000000a1,
+	0x000200f8, 0x000000a2, 0x00060041, 0x0000002b, 0x000000a3, 0x0000000a, 0x00000017, 0x0000001a,
+	0x0004003d, 0x00000013, 0x000000a4, 0x000000a3, 0x0007004f, 0x00000012, 0x000000a5, 0x000000a4,
+	0x000000a4, 0x00000000, 0x00000001, 0x0007004f, 0x00000012, 0x000000a6, 0x000000a4, 0x000000a4,
+	0x00000002, 0x00000003, 0x00050083, 0x00000012, 0x000000a7, 0x0000004a, 0x000000a5, 0x00050088,
+	0x00000012, 0x000000a8, 0x000000a7, 0x000000a6, 0x000500be, 0x0000000f, 0x000000a9, 0x000000a8,
+	0x00000037, 0x000500b8, 0x0000000f, 0x000000aa, 0x000000a8, 0x00000038, 0x000500a7, 0x0000000f,
+	0x000000ab, 0x000000a9, 0x000000aa, 0x0004009b, 0x0000000e, 0x000000ac, 0x000000ab, 0x000300f7,
+	0x000000ad, 0x00000000, 0x000400fa, 0x000000ac, 0x000000ae, 0x000000ad, 0x000200f8, 0x000000ae,
+	0x00050041, 0x00000026, 0x000000af, 0x00000004, 0x0000001a, 0x0004003d, 0x00000024, 0x000000b0,
+	0x000000af, 0x00070058, 0x00000013, 0x000000b1, 0x000000b0, 0x000000a8, 0x00000002, 0x00000032,
+	0x00060041, 0x0000002b, 0x000000b2, 0x0000000a, 0x00000018, 0x0000001a, 0x0004003d, 0x00000013,
+	0x000000b3, 0x000000b2, 0x00050051, 0x00000011, 0x000000b4, 0x000000b3, 0x00000000, 0x00050051,
+	0x00000011, 0x000000b5, 0x000000b1, 0x00000003, 0x00050085, 0x00000011, 0x000000b6, 0x000000b5,
+	0x000000b4, 0x00070050, 0x00000013, 0x000000b7, 0x000000b6, 0x000000b6, 0x000000b6, 0x000000b6,
+	0x00060052, 0x00000013, 0x000000b8, 0x00000034, 0x000000b1, 0x00000003, 0x0004003d, 0x00000013,
+	0x000000b9, 0x0000003e, 0x0008000c, 0x00000013, 0x000000ba, 0x00000001, 0x0000002e, 0x000000b9,
+	0x000000b8, 0x000000b7, 0x0003003e, 0x0000003e, 0x000000ba, 0x000200f9, 0x000000ad, 0x000200f8,
+	0x000000ad, 0x000200f9, 0x000000a1, 0x000200f8, 0x000000a1, 0x000200f9, 0x000000bb, 0x000200f8,
+	0x000000bb, 0x000500b0, 0x0000000e, 0x000000bc, 0x0000001b, 0x00000048, 0x000300f7, 0x000000bd,
+	0x00000000, 0x000400fa, 0x000000bc, 0x000000be, 0x000000bd, 0x000200f8, 0x000000be, 0x00060041,
+	0x0000002b, 0x000000bf, 0x0000000a, 0x00000017, 0x0000001b, 0x0004003d, 0x00000013, 0x000000c0,
+	0x000000bf, 0x0007004f, 0x00000012, 0x000000c1, 0x000000c0, 0x000000c0, 0x00000000, 0x00000001,
+	0x0007004f, 0x00000012, 0x000000c2, 0x000000c0, 0x000000c0, 0x00000002, 0x00000003, 0x00050083,
+	0x00000012, 0x000000c3, 0x0000004a, 0x000000c1, 0x00050088, 0x00000012, 0x000000c4, 0x000000c3,
+	0x000000c2, 0x000500be, 0x0000000f, 0x000000c5, 0x000000c4, 0x00000037, 0x000500b8, 0x0000000f,
+	0x000000c6, 0x000000c4, 0x00000038, 0x000500a7, 0x0000000f, 0x000000c7, 0x000000c5, 0x000000c6,
+	0x0004009b, 0x0000000e, 0x000000c8, 0x000000c7, 0x000300f7, 0x000000c9, 0x00000000, 0x000400fa,
+	0x000000c8, 0x000000ca, 0x000000c9, 0x000200f8, 0x000000ca, 0x00050041, 0x00000026, 0x000000cb,
+	0x00000004, 0x0000001b, 0x0004003d, 0x00000024, 0x000000cc, 0x000000cb, 0x00070058, 0x00000013,
+	0x000000cd, 0x000000cc, 0x000000c4, 0x00000002, 0x00000032, 0x00060041, 0x0000002b, 0x000000ce,
+	0x0000000a, 0x00000018, 0x0000001b, 0x0004003d, 0x00000013, 0x000000cf, 0x000000ce, 0x00050051,
+	0x00000011, 0x000000d0, 0x000000cf, 0x00000000, 0x00050051, 0x00000011, 0x000000d1, 0x000000cd,
+	0x00000003, 0x00050085, 0x00000011, 0x000000d2, 0x000000d1, 0x000000d0, 0x00070050, 0x00000013,
+	0x000000d3, 0x000000d2, 0x000000d2, 0x000000d2, 0x000000d2, 0x00060052, 0x00000013, 0x000000d4,
+	0x00000034, 0x000000cd, 0x00000003, 0x0004003d, 0x00000013, 0x000000d5, 0x0000003e, 0x0008000c,
+	0x00000013, 0x000000d6, 0x00000001, 0x0000002e, 0x000000d5, 0x000000d4, 0x000000d3, 0x0003003e,
+	0x0000003e, 0x000000d6, 0x000200f9, 0x000000c9, 0x000200f8, 0x000000c9, 0x000200f9, 0x000000bd,
+	0x000200f8, 0x000000bd, 0x000200f9, 0x000000d7, 0x000200f8, 0x000000d7, 0x000500b0, 0x0000000e,
+	0x000000d8, 0x0000001c, 0x00000048, 0x000300f7, 0x000000d9, 0x00000000, 0x000400fa, 0x000000d8,
+	0x000000da, 0x000000d9, 0x000200f8, 0x000000da, 0x00060041, 0x0000002b, 0x000000db, 0x0000000a,
+	0x00000017, 0x0000001c, 0x0004003d, 0x00000013, 0x000000dc, 0x000000db, 0x0007004f, 0x00000012,
+	0x000000dd, 0x000000dc, 0x000000dc, 0x00000000, 0x00000001, 0x0007004f, 0x00000012, 0x000000de,
+	0x000000dc, 0x000000dc, 0x00000002, 0x00000003, 0x00050083, 0x00000012, 0x000000df, 0x0000004a,
+	0x000000dd, 0x00050088, 0x00000012, 0x000000e0, 0x000000df, 0x000000de, 0x000500be, 0x0000000f,
+	0x000000e1, 0x000000e0, 0x00000037, 0x000500b8, 0x0000000f, 0x000000e2, 0x000000e0, 0x00000038,
+	0x000500a7, 0x0000000f, 0x000000e3, 0x000000e1, 0x000000e2, 0x0004009b, 0x0000000e, 0x000000e4,
+	0x000000e3, 0x000300f7, 0x000000e5, 0x00000000, 0x000400fa, 0x000000e4, 0x000000e6, 0x000000e5,
+	0x000200f8, 0x000000e6, 0x00050041, 0x00000026, 0x000000e7, 0x00000004, 0x0000001c, 0x0004003d,
+	0x00000024, 0x000000e8, 0x000000e7, 0x00070058, 0x00000013, 0x000000e9, 0x000000e8, 0x000000e0,
+	0x00000002, 0x00000032, 0x00060041, 0x0000002b, 0x000000ea, 0x0000000a, 0x00000018, 0x0000001c,
+	0x0004003d, 0x00000013, 0x000000eb, 0x000000ea, 0x00050051, 0x00000011, 0x000000ec, 0x000000eb,
+	0x00000000, 0x00050051, 0x00000011, 0x000000ed, 0x000000e9, 0x00000003, 0x00050085, 0x00000011,
+	0x000000ee, 0x000000ed, 0x000000ec, 0x00070050, 0x00000013, 0x000000ef, 0x000000ee, 0x000000ee,
+	0x000000ee, 0x000000ee, 0x00060052, 0x00000013, 0x000000f0, 0x00000034, 0x000000e9, 0x00000003,
+	0x0004003d, 0x00000013, 0x000000f1, 0x0000003e, 0x0008000c, 0x00000013, 0x000000f2, 0x00000001,
+	0x0000002e, 0x000000f1, 0x000000f0, 0x000000ef, 0x0003003e, 0x0000003e, 0x000000f2, 0x000200f9,
+	0x000000e5, 0x000200f8, 0x000000e5, 0x000200f9, 0x000000d9, 0x000200f8, 0x000000d9, 0x000200f9,
+	0x000000f3, 0x000200f8, 0x000000f3, 0x000500b0, 0x0000000e, 0x000000f4, 0x0000001d, 0x00000048,
+	0x000300f7, 0x000000f5, 0x00000000, 0x000400fa, 0x000000f4, 0x000000f6, 0x000000f5, 0x000200f8,
+	0x000000f6, 0x00060041, 0x0000002b, 0x000000f7, 0x0000000a, 0x00000017, 0x0000001d, 0x0004003d,
+	0x00000013, 0x000000f8, 0x000000f7, 0x0007004f, 0x00000012, 0x000000f9, 0x000000f8, 0x000000f8,
+	0x00000000, 0x00000001, 0x0007004f, 0x00000012, 0x000000fa, 0x000000f8, 0x000000f8, 0x00000002,
+	0x00000003, 0x00050083, 0x00000012, 0x000000fb, 0x0000004a, 0x000000f9, 0x00050088, 0x00000012,
+	0x000000fc, 0x000000fb, 0x000000fa, 0x000500be, 0x0000000f, 0x000000fd, 0x000000fc, 0x00000037,
+	0x000500b8, 0x0000000f, 0x000000fe, 0x000000fc, 0x00000038, 0x000500a7, 0x0000000f, 0x000000ff,
+	0x000000fd, 0x000000fe, 0x0004009b, 0x0000000e, 0x00000100, 0x000000ff, 0x000300f7, 0x00000101,
+	0x00000000, 0x000400fa, 0x00000100, 0x00000102, 0x00000101, 0x000200f8, 0x00000102, 0x00050041,
+	0x00000026, 0x00000103, 0x00000004, 0x0000001d, 0x0004003d, 0x00000024, 0x00000104, 0x00000103,
+	0x00070058, 0x00000013, 0x00000105, 0x00000104, 0x000000fc, 0x00000002, 0x00000032, 0x00060041,
+	0x0000002b, 0x00000106, 0x0000000a, 0x00000018, 0x0000001d, 0x0004003d, 0x00000013, 0x00000107,
+	0x00000106, 0x00050051, 0x00000011, 0x00000108, 0x00000107, 0x00000000, 0x00050051, 0x00000011,
+	0x00000109, 0x00000105, 0x00000003, 0x00050085, 0x00000011, 0x0000010a, 0x00000109, 0x00000108,
+	0x00070050, 0x00000013, 0x0000010b, 0x0000010a, 0x0000010a, 0x0000010a, 0x0000010a, 0x00060052,
+	0x00000013, 0x0000010c, 0x00000034, 0x00000105, 0x00000003, 0x0004003d, 0x00000013, 0x0000010d,
+	0x0000003e, 0x0008000c, 0x00000013, 0x0000010e, 0x00000001, 0x0000002e, 0x0000010d, 0x0000010c,
+	0x0000010b, 0x0003003e, 0x0000003e, 0x0000010e, 0x000200f9, 0x00000101, 0x000200f8, 0x00000101,
+	0x000200f9, 0x000000f5, 0x000200f8, 0x000000f5, 0x000200f9, 0x0000010f, 0x000200f8, 0x0000010f,
+	0x000500b0, 0x0000000e, 0x00000110, 0x0000001e, 0x00000048, 0x000300f7, 0x00000111, 0x00000000,
+	0x000400fa, 0x00000110, 0x00000112, 0x00000111, 0x000200f8, 0x00000112, 0x00060041, 0x0000002b,
+	0x00000113, 0x0000000a, 0x00000017, 0x0000001e, 0x0004003d, 0x00000013, 0x00000114, 0x00000113,
+	0x0007004f, 0x00000012, 0x00000115, 0x00000114, 0x00000114, 0x00000000, 0x00000001, 0x0007004f,
+	0x00000012, 0x00000116, 0x00000114, 0x00000114, 0x00000002, 0x00000003, 0x00050083, 0x00000012,
+	0x00000117, 0x0000004a, 0x00000115, 0x00050088, 0x00000012, 0x00000118, 0x00000117, 0x00000116,
+	0x000500be, 0x0000000f, 0x00000119, 0x00000118, 0x00000037, 0x000500b8, 0x0000000f, 0x0000011a,
+	0x00000118, 0x00000038, 0x000500a7, 0x0000000f, 0x0000011b, 0x00000119, 0x0000011a, 0x0004009b,
+	0x0000000e, 0x0000011c, 0x0000011b, 0x000300f7, 0x0000011d, 0x00000000, 0x000400fa, 0x0000011c,
+	0x0000011e, 0x0000011d, 0x000200f8, 0x0000011e, 0x00050041, 0x00000026, 0x0000011f, 0x00000004,
+	0x0000001e, 0x0004003d, 0x00000024, 0x00000120, 0x0000011f, 0x00070058, 0x00000013, 0x00000121,
+	0x00000120, 0x00000118, 0x00000002, 0x00000032, 0x00060041, 0x0000002b, 0x00000122, 0x0000000a,
+	0x00000018, 0x0000001e, 0x0004003d, 0x00000013, 0x00000123, 0x00000122, 0x00050051, 0x00000011,
+	0x00000124, 0x00000123, 0x00000000, 0x00050051, 0x00000011, 0x00000125, 0x00000121, 0x00000003,
+	0x00050085, 0x00000011, 0x00000126, 0x00000125, 0x00000124, 0x00070050, 0x00000013, 0x00000127,
+	0x00000126, 0x00000126, 0x00000126, 0x00000126, 0x00060052, 0x00000013, 0x00000128, 0x00000034,
+	0x00000121, 0x00000003, 0x0004003d, 0x00000013, 0x00000129, 0x0000003e, 0x0008000c, 0x00000013,
+	0x0000012a, 0x00000001, 0x0000002e, 0x00000129, 0x00000128, 0x00000127, 0x0003003e, 0x0000003e,
+	0x0000012a, 0x000200f9, 0x0000011d, 0x000200f8, 0x0000011d, 0x000200f9, 0x00000111, 0x000200f8,
+	0x00000111, 0x000200f9, 0x0000012b, 0x000200f8, 0x0000012b, 0x0004003d, 0x00000013, 0x0000012c,
+	0x0000003e, 0x00050051, 0x00000010, 0x0000012d, 0x00000040, 0x00000000, 0x00050051, 0x00000010,
+	0x0000012e, 0x00000040, 0x00000001, 0x00050051, 0x00000010, 0x0000012f, 0x00000042, 0x00000000,
+	0x00050084, 0x00000010, 0x00000130, 0x0000012e, 0x0000012f, 0x00050080, 0x00000010, 0x00000131,
+	0x00000130, 0x0000012d, 0x00050041, 0x0000002f, 0x00000132, 0x0000002d, 0x00000018, 0x0004003d,
+	0x00000010, 0x00000133, 0x00000132, 0x000300f7, 0x00000134, 0x00000000, 0x000d00fb, 0x00000133,
+	0x00000135, 0x00000000, 0x00000136, 0x00000001, 0x00000137, 0x00000002, 0x00000138, 0x00000003,
+	0x00000139, 0x00000004, 0x0000013a, 0x000200f8, 0x00000136, 0x0006000c, 0x00000010, 0x0000013b,
+	0x00000001, 0x00000037, 0x0000012c, 0x00060041, 0x00000029, 0x0000013c, 0x00000007, 0x00000017,
+	0x00000131, 0x0003003e, 0x0000013c, 0x0000013b, 0x000200f9, 0x00000134, 0x000200f8, 0x00000137,
+	0x0009004f, 0x00000013, 0x0000013d, 0x0000012c, 0x0000012c, 0x00000002, 0x00000001, 0x00000000,
+	0x00000003, 0x0006000c, 0x00000010, 0x0000013e, 0x00000001, 0x00000037, 0x0000013d, 0x00060041,
+	0x00000029, 0x0000013f, 0x00000007, 0x00000017, 0x00000131, 0x0003003e, 0x0000013f, 0x0000013e,
+	0x000200f9, 0x00000134, 0x000200f8, 0x00000138, 0x0008000c, 0x00000013, 0x00000140, 0x00000001,
+	0x0000002b, 0x0000012c, 0x0000003a, 0x0000003b, 0x00050085, 0x00000013, 0x00000141, 0x00000140,
+	0x0000003c, 0x0006000c, 0x00000013, 0x00000142, 0x00000001, 0x00000001, 0x00000141, 0x0004006d,
+	0x00000016, 0x00000143, 0x00000142, 0x00050051, 0x00000010, 0x00000144, 0x00000143, 0x00000000,
+	0x00050051, 0x00000010, 0x00000145, 0x00000143, 0x00000001, 0x00050051, 0x00000010, 0x00000146,
+	0x00000143, 0x00000002, 0x00050051, 0x00000010, 0x00000147, 0x00000143, 0x00000003, 0x000500c4,
+	0x00000010, 0x00000148, 0x00000145, 0x00000020, 0x000500c4, 0x00000010, 0x00000149, 0x00000146,
+	0x00000021, 0x000500c4, 0x00000010, 0x0000014a, 0x00000147, 0x00000022, 0x000500c5, 0x00000010,
+	0x0000014b, 0x00000144, 0x00000148, 0x000500c5, 0x00000010, 0x0000014c, 0x0000014b, 0x00000149,
+	0x000500c5, 0x00000010, 0x0000014d, 0x0000014c, 0x0000014a, 0x00060041, 0x00000029, 0x0000014e,
+	0x00000007, 0x00000017, 0x00000131, 0x0003003e, 0x0000014e, 0x0000014d, 0x000200f9, 0x00000134,
+	0x000200f8, 0x00000139, 0x0007004f, 0x00000012, 0x0000014f, 0x0000012c, 0x0000012c, 0x00000000,
+	0x00000001, 0x0007004f, 0x00000012, 0x00000150, 0x0000012c, 0x0000012c, 0x00000002, 0x00000003,
+	0x0006000c, 0x00000010, 0x00000151, 0x00000001, 0x00000039, 0x0000014f, 0x0006000c, 0x00000010,
+	0x00000152, 0x00000001, 0x00000039, 0x00000150, 0x00050084, 0x00000010, 0x00000153, 0x00000131,
+	0x00000019, 0x00050080, 0x00000010, 0x00000154, 0x00000153, 0x00000018, 0x00060041, 0x00000029,
+	0x00000155, 0x00000007, 0x00000017, 0x00000153, 0x0003003e, 0x00000155, 0x00000151, 0x00060041,
+	0x00000029, 0x00000156, 0x00000007, 0x00000017, 0x00000154, 0x0003003e, 0x00000156, 0x00000152,
+	0x000200f9, 0x00000134, 0x000200f8, 0x0000013a, 0x0007004f, 0x00000012, 0x00000157, 0x0000012c,
+	0x0000012c, 0x00000000, 0x00000001, 0x0007004f, 0x00000012, 0x00000158, 0x0000012c, 0x0000012c,
+	0x00000002, 0x00000003, 0x0006000c, 0x00000010, 0x00000159, 0x00000001, 0x0000003a, 0x00000157,
+	0x0006000c, 0x00000010, 0x0000015a, 0x00000001, 0x0000003a, 0x00000158, 0x00050084, 0x00000010,
+	0x0000015b, 0x00000131, 0x00000019, 0x00050080, 0x00000010, 0x0000015c, 0x0000015b, 0x00000018,
+	0x00060041, 0x00000029, 0x0000015d, 0x00000007, 0x00000017, 0x0000015b, 0x0003003e, 0x0000015d,
+	0x00000159, 0x00060041, 0x00000029, 0x0000015e, 0x00000007, 0x00000017, 0x0000015c, 0x0003003e,
+	0x0000015e, 0x0000015a, 0x000200f9, 0x00000134, 0x000200f8, 0x00000135, 0x0004007c, 0x00000016,
+	0x0000015f, 0x0000012c, 0x00050084, 0x00000010, 0x00000160, 0x00000131, 0x0000001b, 0x00050080,
+	0x00000010, 0x00000161, 0x00000160, 0x00000018, 0x00050080, 0x00000010, 0x00000162, 0x00000160,
+	0x00000019, 0x00050080, 0x00000010, 0x00000163, 0x00000160, 0x0000001a, 0x00050051, 0x00000010,
+	0x00000164, 0x0000015f, 0x00000000, 0x00050051, 0x00000010, 0x00000165, 0x0000015f, 0x00000001,
+	0x00050051, 0x00000010, 0x00000166, 0x0000015f, 0x00000002, 0x00050051, 0x00000010, 0x00000167,
+	0x0000015f, 0x00000003, 0x00060041, 0x00000029, 0x00000168, 0x00000007, 0x00000017, 0x00000160,
+	0x0003003e, 0x00000168, 0x00000164, 0x00060041, 0x00000029, 0x00000169, 0x00000007, 0x00000017,
+	0x00000161, 0x0003003e, 0x00000169, 0x00000165, 0x00060041, 0x00000029, 0x0000016a, 0x00000007,
+	0x00000017, 0x00000162, 0x0003003e, 0x0000016a, 0x00000166, 0x00060041, 0x00000029, 0x0000016b,
+	0x00000007, 0x00000017, 0x00000163, 0x0003003e, 0x0000016b, 0x00000167, 0x000200f9, 0x00000134,
+	0x000200f8, 0x00000134, 0x000100fd, 0x00010038,
+};
+
+#endif
@@ -0,0 +1,617 @@
+//
+// SpoutVKbench
+//
+// Headless sender to receiver throughput benchmark for spoutVK.
+//
+// For each sender size, format and number of receivers, the benchmark
+// starts itself as a sender process and as each receiver process,
+// waits for them to finish and reports their results as a JSON array.
+//
+//	SpoutVKbench [options]
+//
+//	--sizes 720p,1080p,1440p,4k,8k               Sender sizes
+//	--formats bgra8,rgb10a2,rgba16f,rgba32f      Sender formats
+//	--receivers 1,2,4                            Receiver process counts
+//	--seconds 5                                  Measured time for each configuration
+//	--device -1                                  Vulkan device index, -1 for the first discrete GPU
+//	--out results.json                           Write the results to a file as well as the console
+//	--local 1                                    Also measure senders and receivers in this process
+//	--convert 1                                  Benchmark the pixel format conversions instead
+//
+// The sender clears an image and sends it with SendImage for every frame,
+// without a frame rate limit. A receiver receives each new frame with
+// ReceiveImage to an image of the sender size and waits for the copy.
+//
+// Results for each configuration :
+//
+//	sender   fps       - frames sent per second
+//	         cpu_ms    - process CPU time per frame
+//	receiver fps       - new frames received per second
+//	         cpu_ms    - process CPU time per frame received
+//	         latency_ms - percentiles of the time from the submit of the
+//	                     newest frame sent to the completion of the copy
+//	                     that received it
+//
+// The sender publishes the number and time of each frame submitted in
+// shared memory "<sender name>_benchtime" for the receivers.
+//
+// With "--local 1", each configuration is also run with the sender and
+// receivers in this process on one device, sending and receiving in the
+// same command buffer. "local" uses the same process fast path and
+// "local_shared" the shared texture, for comparison with each other and
+// with the separate processes.
+//
+// With "--convert 1", the SIMD pixel format conversions of spoutVKconvert
+// are compared with the scalar versions for an image of --width x --height
+// and their throughput is logged. No Vulkan device is created. The exit
+// code is 1 if any conversion is not bit exact.
+//
+
+#include "SpoutVKheadless.h"
+#include "..\SpoutVKconvert.h"
+#include <string>
+#include <vector>
+#include <thread>
+
+struct benchTime {
+	int64_t frame; // Frames submitted
+	int64_t time;  // steady_clock nanoseconds of the submit
+};
+
+struct benchOptions {
+	std::string role;
+	std::string name = "SpoutVKbench";
+	std::string result;
+	std::string out;
+	uint32_t width = 1920;
+	uint32_t height = 1080;
+	VkFormat format = VK_FORMAT_B8G8R8A8_UNORM;
+	std::vector<std::string> sizes = { "720p", "1080p", "1440p", "4k", "8k" };
+	std::vector<std::string> formats = { "bgra8", "rgb10a2", "rgba16f", "rgba32f" };
+	std::vector<int> receivers = { 1, 2, 4 };
+	double seconds = 5.0;
+	int device = -1;
+	bool bLocal = false;
+	bool bConvert = false;
+};
+
+static const struct { const char* name; VkFormat format; } benchFormats[] = {
+	{ "bgra8",   VK_FORMAT_B8G8R8A8_UNORM },
+	{ "rgb10a2", VK_FORMAT_A2B10G10R10_UNORM_PACK32 },
+	{ "rgba16f", VK_FORMAT_R16G16B16A16_SFLOAT },
+	{ "rgba32f", VK_FORMAT_R32G32B32A32_SFLOAT }
+};
+
+static const struct { const char* name; uint32_t width; uint32_t height; } benchSizes[] = {
+	{ "720p",  1280, 720 },
+	{ "1080p", 1920, 1080 },
+	{ "1440p", 2560, 1440 },
+	{ "4k",    3840, 2160 },
+	{ "8k",    7680, 4320 }
+};
+
+static VkFormat GetFormat(const std::string& name)
+{
+	for (const auto& f : benchFormats) {
+		if (name == f.name)
+			return f.format;
+	}
+	return VK_FORMAT_UNDEFINED;
+}
+
+static const char* GetFormatName(VkFormat format)
+{
+	for (const auto& f : benchFormats) {
+		if (format == f.format)
+			return f.name;
+	}
+	return "unknown";
+}
+
+static std::vector<std::string> Split(const std::string& list)
+{
+	std::vector<std::string> items;
+	size_t start = 0;
+	while (start <= list.size()) {
+		size_t end = list.find(',', start);
+		if (end == std::string::npos)
+			end = list.size();
+		if (end > start)
+			items.push_back(list.substr(start, end - start));
+		start = end + 1;
+	}
+	return items;
+}
+
+// User and kernel time of the process
+static double ProcessCpuMs()
+{
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+		return 0.0;
+	ULARGE_INTEGER k, u;
+	k.LowPart = kernel.dwLowDateTime;
+	k.HighPart = kernel.dwHighDateTime;
+	u.LowPart = user.dwLowDateTime;
+	u.HighPart = user.dwHighDateTime;
+	return (double)(k.QuadPart + u.QuadPart)/10000.0;
+}
+
+static bool WriteText(const std::string& path, const std::string& text)
+{
+	FILE* file = nullptr;
+	if (fopen_s(&file, path.c_str(), "wb") != 0 || !file)
+		return false;
+	fwrite(text.data(), 1, text.size(), file);
+	fclose(file);
+	return true;
+}
+
+static std::string ReadText(const std::string& path)
+{
+	std::string text;
+	FILE* file = nullptr;
+	if (fopen_s(&file, path.c_str(), "rb") != 0 || !file)
+		return text;
+	char buffer[4096];
+	size_t count = 0;
+	while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		text.append(buffer, count);
+	fclose(file);
+	return text;
+}
+
+//
+// Sender process
+//
+// Runs for two seconds longer than the receivers so that they measure
+// while it is sending. The first second is not measured.
+//
+static int RunSender(const benchOptions& opt)
+{
+	if (opt.format == VK_FORMAT_UNDEFINED || opt.width == 0 || opt.height == 0)
+		return 1;
+
+	spoutVKheadless vk;
+	if (!vk.Create(opt.device))
+		return 1;
+
+	VkImage image = nullptr;
+	VkDeviceMemory memory = nullptr;
+	if (!vk.CreateImage(opt.width, opt.height, opt.format,
+		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, image, memory)) {
+		SpoutLogError("SpoutVKbench - could not create %ux%u %s image", opt.width, opt.height, GetFormatName(opt.format));
+		return 1;
+	}
+
+	SpoutSharedMemory timeMap;
+	if (timeMap.Create((opt.name + "_benchtime").c_str(), sizeof(benchTime)) == SPOUT_CREATE_FAILED)
+		return 1;
+
+	spoutVK sender;
+	sender.SetSenderName(opt.name.c_str());
+
+	int64_t frames = 0;
+	int64_t measuredFrames = 0;
+	double cpuStart = 0.0;
+	auto start = std::chrono::steady_clock::now();
+	auto measureStart = start;
+	bool bMeasuring = false;
+	for (;;) {
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (elapsed >= opt.seconds + 3.0)
+			break;
+		if (!bMeasuring && elapsed >= 1.0) {
+			bMeasuring = true;
+			measureStart = std::chrono::steady_clock::now();
+			cpuStart = ProcessCpuMs();
+		}
+
+		VkCommandBuffer commandBuffer = vk.Begin();
+		if (frames == 0)
+			vk.Transition(commandBuffer, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+		VkClearColorValue color = { { (float)(frames % 256)/255.0f, 0.5f, 0.5f, 1.0f } };
+		VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, &color, 1, &range);
+		sender.SendImage(vk.physicalDevice, vk.device, commandBuffer,
+			image, VK_IMAGE_LAYOUT_GENERAL, opt.width, opt.height, opt.format);
+		if (!vk.Submit())
+			break;
+		frames++;
+		if (bMeasuring)
+			measuredFrames++;
+
+		char* pBuffer = timeMap.Lock();
+		if (pBuffer) {
+			benchTime* pTime = (benchTime*)pBuffer;
+			pTime->frame = frames;
+			pTime->time = NowNs();
+			timeMap.Unlock();
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - measureStart).count();
+	double cpu = ProcessCpuMs() - cpuStart;
+
+	vkDeviceWaitIdle(vk.device);
+	sender.ReleaseSender();
+	sender.ReleaseVulkanImage(vk.device);
+	vkDestroyImage(vk.device, image, nullptr);
+	vkFreeMemory(vk.device, memory, nullptr);
+
+	char json[512]{};
+	sprintf_s(json, 512, "{ \"fps\": %.2f, \"cpu_ms\": %.4f, \"frames\": %lld }",
+		measuredFrames > 0 ? measuredFrames/seconds : 0.0,
+		measuredFrames > 0 ? cpu/measuredFrames : 0.0,
+		(long long)measuredFrames);
+	return WriteText(opt.result, json) ? 0 : 1;
+}
+
+//
+// Receiver process
+//
+// Connects to the sender by name and receives each new frame
+// published in the time map, waiting for the copy to complete.
+//
+static int RunReceiver(const benchOptions& opt)
+{
+	spoutVKheadless vk;
+	if (!vk.Create(opt.device))
+		return 1;
+
+	spoutVK receiver;
+	receiver.SetReceiverName(opt.name.c_str());
+
+	// Wait for the sender
+	SpoutSharedMemory timeMap;
+	auto start = std::chrono::steady_clock::now();
+	while (!receiver.ReceiveSenderTexture(vk.physicalDevice, vk.device) || !timeMap.Open((opt.name + "_benchtime").c_str())) {
+		if (std::chrono::steady_clock::now() - start > std::chrono::seconds(10)) {
+			SpoutLogError("SpoutVKbench - sender %s not found", opt.name.c_str());
+			return 1;
+		}
+		Sleep(10);
+	}
+
+	uint32_t width = receiver.GetSenderWidth();
+	uint32_t height = receiver.GetSenderHeight();
+	VkFormat format = receiver.GetSenderFormat();
+	VkImage image = nullptr;
+	VkDeviceMemory memory = nullptr;
+	if (!vk.CreateImage(width, height, format,
+		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, image, memory))
+		return 1;
+	VkCommandBuffer commandBuffer = vk.Begin();
+	vk.Transition(commandBuffer, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+	vk.Submit(true);
+
+	std::vector<double> latencies;
+	int64_t lastFrame = 0;
+	int64_t received = 0;
+	double cpuStart = ProcessCpuMs();
+	start = std::chrono::steady_clock::now();
+	while (std::chrono::steady_clock::now() - start < std::chrono::duration<double>(opt.seconds)) {
+		benchTime sent{};
+		char* pBuffer = timeMap.Lock();
+		if (pBuffer) {
+			sent = *(benchTime*)pBuffer;
+			timeMap.Unlock();
+		}
+		if (sent.frame == lastFrame) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		commandBuffer = vk.Begin();
+		bool bReceived = receiver.ReceiveImage(vk.physicalDevice, vk.device, commandBuffer,
+			image, VK_IMAGE_LAYOUT_GENERAL, format, width, height);
+		vk.Submit(true);
+		if (!bReceived || !receiver.IsFrameNew())
+			continue;
+
+		latencies.push_back((double)(NowNs() - sent.time)/1000000.0);
+		lastFrame = sent.frame;
+		received++;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	double cpu = ProcessCpuMs() - cpuStart;
+
+	vkDeviceWaitIdle(vk.device);
+	receiver.ReleaseReceiver();
+	receiver.ReleaseVulkanImage(vk.device);
+	vkDestroyImage(vk.device, image, nullptr);
+	vkFreeMemory(vk.device, memory, nullptr);
+
+	char json[512]{};
+	sprintf_s(json, 512, "{ \"fps\": %.2f, \"cpu_ms\": %.4f, \"frames\": %lld, "
+		"\"latency_ms\": { \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f } }",
+		received/seconds, received > 0 ? cpu/received : 0.0, (long long)received,
+		Percentile(latencies, 50.0), Percentile(latencies, 90.0),
+		Percentile(latencies, 99.0), Percentile(latencies, 100.0));
+	return WriteText(opt.result, json) ? 0 : 1;
+}
+
+//
+// Sender and receivers in this process
+//
+// Each frame is sent and received by every receiver in one command buffer,
+// which is waited on. The first second is not measured.
+//
+// The fast path needs the frame timeline of the sender and receivers.
+// The receivers' copies follow the sender's in the same command buffer,
+// so they are ordered by barriers and do not wait for the timeline.
+//
+static std::string RunLocal(const benchOptions& opt, uint32_t width, uint32_t height,
+	VkFormat format, int receivers, bool bFastPath)
+{
+	spoutVKheadless vk;
+	if (!vk.Create(opt.device))
+		return "null";
+
+	VkImage image = nullptr;
+	VkDeviceMemory memory = nullptr;
+	std::vector<VkImage> images(receivers);
+	std::vector<VkDeviceMemory> memories(receivers);
+	bool bCreated = vk.CreateImage(width, height, format,
+		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, image, memory);
+	for (int i = 0; i < receivers && bCreated; i++) {
+		bCreated = vk.CreateImage(width, height, format,
+			VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, images[i], memories[i]);
+	}
+
+	std::string name = opt.name + "_local";
+	spoutVK sender;
+	sender.SetSenderName(name.c_str());
+	std::vector<std::unique_ptr<spoutVK>> receiverList;
+	for (int i = 0; i < receivers; i++) {
+		receiverList.push_back(std::make_unique<spoutVK>());
+		receiverList.back()->SetReceiverName(name.c_str());
+		receiverList.back()->SetLocalFastPath(bFastPath);
+	}
+
+	int64_t frames = 0;
+	int64_t measuredFrames = 0;
+	int64_t localFrames = 0;
+	double cpuStart = 0.0;
+	std::vector<double> latencies;
+	auto start = std::chrono::steady_clock::now();
+	auto measureStart = start;
+	bool bMeasuring = false;
+	while (bCreated) {
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (elapsed >= opt.seconds + 1.0)
+			break;
+		if (!bMeasuring && elapsed >= 1.0) {
+			bMeasuring = true;
+			measureStart = std::chrono::steady_clock::now();
+			cpuStart = ProcessCpuMs();
+		}
+
+		int64_t frameStart = NowNs();
+		VkCommandBuffer commandBuffer = vk.Begin();
+		if (vk.timeline) {
+			sender.SetFrameTimeline(vk.timeline, vk.timelineValue);
+			for (auto& receiver : receiverList)
+				receiver->SetFrameTimeline(vk.timeline, vk.timelineValue);
+		}
+		if (frames == 0) {
+			vk.Transition(commandBuffer, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+			for (VkImage receiveImage : images)
+				vk.Transition(commandBuffer, receiveImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+		}
+		VkClearColorValue color = { { (float)(frames % 256)/255.0f, 0.5f, 0.5f, 1.0f } };
+		VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, &color, 1, &range);
+		sender.SendImage(vk.physicalDevice, vk.device, commandBuffer,
+			image, VK_IMAGE_LAYOUT_GENERAL, width, height, format);
+		bool bLocal = true;
+		for (int i = 0; i < receivers; i++) {
+			receiverList[i]->ReceiveImage(vk.physicalDevice, vk.device, commandBuffer,
+				images[i], VK_IMAGE_LAYOUT_GENERAL, format, width, height);
+			bLocal = bLocal && receiverList[i]->IsLocalReceive();
+		}
+		if (!vk.Submit(true))
+			break;
+		frames++;
+		if (bMeasuring) {
+			measuredFrames++;
+			if (bLocal)
+				localFrames++;
+			latencies.push_back((double)(NowNs() - frameStart)/1000000.0);
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - measureStart).count();
+	double cpu = ProcessCpuMs() - cpuStart;
+
+	vkDeviceWaitIdle(vk.device);
+	for (auto& receiver : receiverList) {
+		receiver->ReleaseReceiver();
+		receiver->ReleaseVulkanImage(vk.device);
+	}
+	sender.ReleaseSender();
+	sender.ReleaseVulkanImage(vk.device);
+	for (int i = 0; i < receivers; i++) {
+		if (images[i]) vkDestroyImage(vk.device, images[i], nullptr);
+		if (memories[i]) vkFreeMemory(vk.device, memories[i], nullptr);
+	}
+	if (image) vkDestroyImage(vk.device, image, nullptr);
+	if (memory) vkFreeMemory(vk.device, memory, nullptr);
+	if (measuredFrames == 0)
+		return "null";
+
+	char json[512]{};
+	sprintf_s(json, 512, "{ \"fps\": %.2f, \"cpu_ms\": %.4f, \"frames\": %lld, \"local_frames\": %lld, "
+		"\"frame_ms\": { \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f } }",
+		measuredFrames/seconds, cpu/measuredFrames, (long long)measuredFrames, (long long)localFrames,
+		Percentile(latencies, 50.0), Percentile(latencies, 90.0),
+		Percentile(latencies, 99.0), Percentile(latencies, 100.0));
+	return json;
+}
+
+static HANDLE StartProcess(const std::string& commandline)
+{
+	STARTUPINFOA si = { sizeof(STARTUPINFOA) };
+	PROCESS_INFORMATION pi{};
+	std::vector<char> cmd(commandline.begin(), commandline.end());
+	cmd.push_back(0);
+	if (!CreateProcessA(nullptr, cmd.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &si, &pi)) {
+		SpoutLogError("SpoutVKbench - could not start %s", commandline.c_str());
+		return nullptr;
+	}
+	CloseHandle(pi.hThread);
+	return pi.hProcess;
+}
+
+// Compare the SIMD pixel conversions with the scalar versions
+static int RunConvert(const benchOptions& opt)
+{
+	// The results are logged
+	EnableSpoutLog();
+	SetSpoutLogLevel(SPOUT_LOG_NOTICE);
+
+	spoutVKconvert convert;
+	bool bExact = convert.Benchmark(opt.width, opt.height);
+	printf("%s\n", bExact ? "All conversions are exact" : "Conversion mismatch");
+	return bExact ? 0 : 1;
+}
+
+//
+// Run the sender and receiver processes for each configuration
+//
+static int RunBenchmark(const benchOptions& opt)
+{
+	char exePath[MAX_PATH]{};
+	GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+	char tempPath[MAX_PATH]{};
+	GetTempPathA(MAX_PATH, tempPath);
+	std::string tempBase = std::string(tempPath) + "SpoutVKbench_" + std::to_string(GetCurrentProcessId());
+
+	std::string results = "[\n";
+	bool bFirst = true;
+	for (const std::string& sizeName : opt.sizes) {
+		uint32_t width = 0, height = 0;
+		for (const auto& s : benchSizes) {
+			if (sizeName == s.name) {
+				width = s.width;
+				height = s.height;
+			}
+		}
+		if (width == 0) {
+			printf("Unknown size %s\n", sizeName.c_str());
+			continue;
+		}
+		for (const std::string& formatName : opt.formats) {
+			if (GetFormat(formatName) == VK_FORMAT_UNDEFINED) {
+				printf("Unknown format %s\n", formatName.c_str());
+				continue;
+			}
+			for (int receivers : opt.receivers) {
+				fprintf(stderr, "%s %s %d receivers\n", sizeName.c_str(), formatName.c_str(), receivers);
+
+				std::string common = " --name " + opt.name
+					+ " --seconds " + std::to_string(opt.seconds)
+					+ " --device " + std::to_string(opt.device);
+				std::vector<HANDLE> processes;
+				std::string senderResult = tempBase + "_sender.json";
+				DeleteFileA(senderResult.c_str());
+				HANDLE hSender = StartProcess("\"" + std::string(exePath) + "\" --role sender"
+					+ common + " --width " + std::to_string(width) + " --height " + std::to_string(height)
+					+ " --format " + formatName + " --result \"" + senderResult + "\"");
+				if (!hSender)
+					return 1;
+				processes.push_back(hSender);
+
+				// Receivers start when the sender has been created
+				Sleep(500);
+				std::vector<std::string> receiverResults;
+				for (int i = 0; i < receivers; i++) {
+					receiverResults.push_back(tempBase + "_receiver" + std::to_string(i) + ".json");
+					DeleteFileA(receiverResults.back().c_str());
+					HANDLE hReceiver = StartProcess("\"" + std::string(exePath) + "\" --role receiver"
+						+ common + " --result \"" + receiverResults.back() + "\"");
+					if (hReceiver)
+						processes.push_back(hReceiver);
+				}
+
+				DWORD timeout = (DWORD)((opt.seconds + 30.0)*1000.0);
+				WaitForMultipleObjects((DWORD)processes.size(), processes.data(), TRUE, timeout);
+				for (HANDLE process : processes) {
+					TerminateProcess(process, 1); // If timed out
+					CloseHandle(process);
+				}
+
+				std::string senderJson = ReadText(senderResult);
+				std::string receiverJson;
+				for (const std::string& path : receiverResults) {
+					std::string json = ReadText(path);
+					if (json.empty())
+						json = "null";
+					receiverJson += (receiverJson.empty() ? "" : ", ") + json;
+					DeleteFileA(path.c_str());
+				}
+				DeleteFileA(senderResult.c_str());
+
+				char config[256]{};
+				sprintf_s(config, 256, "  { \"width\": %u, \"height\": %u, \"format\": \"%s\", \"receivers\": %d,\n",
+					width, height, formatName.c_str(), receivers);
+				results += bFirst ? "" : ",\n";
+				results += std::string(config)
+					+ "    \"sender\": " + (senderJson.empty() ? "null" : senderJson) + ",\n"
+					+ "    \"receiver\": [ " + receiverJson + " ]";
+				if (opt.bLocal) {
+					VkFormat format = GetFormat(formatName);
+					results += ",\n    \"local\": " + RunLocal(opt, width, height, format, receivers, true)
+						+ ",\n    \"local_shared\": " + RunLocal(opt, width, height, format, receivers, false);
+				}
+				results += " }";
+				bFirst = false;
+			}
+		}
+	}
+	results += "\n]\n";
+
+	printf("%s", results.c_str());
+	if (!opt.out.empty() && !WriteText(opt.out, results)) {
+		printf("Could not write %s\n", opt.out.c_str());
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	benchOptions opt;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string arg = argv[i];
+		std::string value = argv[i + 1];
+		if (arg == "--role")           opt.role = value;
+		else if (arg == "--name")      opt.name = value;
+		else if (arg == "--result")    opt.result = value;
+		else if (arg == "--out")       opt.out = value;
+		else if (arg == "--width")     opt.width = (uint32_t)atoi(value.c_str());
+		else if (arg == "--height")    opt.height = (uint32_t)atoi(value.c_str());
+		else if (arg == "--format")    opt.format = GetFormat(value);
+		else if (arg == "--sizes")     opt.sizes = Split(value);
+		else if (arg == "--formats")   opt.formats = Split(value);
+		else if (arg == "--seconds")   opt.seconds = atof(value.c_str());
+		else if (arg == "--device")    opt.device = atoi(value.c_str());
+		else if (arg == "--local")     opt.bLocal = atoi(value.c_str()) != 0;
+		else if (arg == "--convert")   opt.bConvert = atoi(value.c_str()) != 0;
+		else if (arg == "--receivers") {
+			opt.receivers.clear();
+			for (const std::string& count : Split(value))
+				opt.receivers.push_back(std::max(atoi(count.c_str()), 1));
+		}
+		else {
+			printf("Unknown option %s\n", arg.c_str());
+			return 1;
+		}
+	}
+
+	if (opt.bConvert)
+		return RunConvert(opt);
+	if (opt.role == "sender")
+		return RunSender(opt);
+	if (opt.role == "receiver")
+		return RunReceiver(opt);
+	return RunBenchmark(opt);
+}
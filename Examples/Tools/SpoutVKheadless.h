@@ -0,0 +1,359 @@
+//
+// SpoutVKheadless.h
+//
+// Vulkan instance, device and queue without a window
+// for the SpoutVK benchmark and latency tools.
+//
+// The instance and device extensions required by spoutVK are enabled.
+// Command buffers are recorded and submitted in a ring of frames,
+// each with a fence that is waited on before the frame is recorded again.
+// If timeline semaphores are supported, each submit also signals the
+// timeline with the frame value, for spoutVK::SetFrameTimeline.
+//
+// The memory of a sender texture is imported from D3D11, so the device must
+// be on the same adapter as the D3D11 device created by spoutVK. Software
+// devices such as lavapipe do not support the import.
+//
+// NowNs and Percentile are shared by the tools for timing.
+//
+
+#pragma once
+#ifndef __spoutVKheadless__
+#define __spoutVKheadless__
+
+#include "..\SpoutVK.h"
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+
+class spoutVKheadless {
+
+public:
+
+	VkInstance instance = nullptr;
+	VkPhysicalDevice physicalDevice = nullptr;
+	VkDevice device = nullptr;
+	VkQueue queue = nullptr;
+	uint32_t queueFamilyIndex = 0;
+	VkPhysicalDeviceProperties properties{};
+	VkSemaphore timeline = nullptr; // Null if not supported
+	uint64_t timelineValue = 1;     // Signalled by the submit of the frame being recorded
+
+	~spoutVKheadless() {
+		Release();
+	}
+
+	// Device index of vkEnumeratePhysicalDevices, or -1 for the first discrete GPU
+	bool Create(int deviceIndex = -1, uint32_t frames = 2)
+	{
+		const char* instanceExtensions[] = {
+			"VK_KHR_surface",
+			"VK_KHR_win32_surface",
+			"VK_KHR_get_physical_device_properties2"
+		};
+		VkApplicationInfo appInfo = { VK_STRUCTURE_TYPE_APPLICATION_INFO };
+		appInfo.pApplicationName = "SpoutVK";
+		appInfo.apiVersion = VK_API_VERSION_1_2;
+		VkInstanceCreateInfo instanceInfo = { VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+		instanceInfo.pApplicationInfo = &appInfo;
+		instanceInfo.enabledExtensionCount = 3;
+		instanceInfo.ppEnabledExtensionNames = instanceExtensions;
+		if (vkCreateInstance(&instanceInfo, nullptr, &instance) != VK_SUCCESS) {
+			SpoutLogError("spoutVKheadless::Create - could not create instance");
+			instance = nullptr;
+			return false;
+		}
+
+		uint32_t count = 0;
+		vkEnumeratePhysicalDevices(instance, &count, nullptr);
+		std::vector<VkPhysicalDevice> devices(count);
+		vkEnumeratePhysicalDevices(instance, &count, devices.data());
+		if (deviceIndex >= 0 && (uint32_t)deviceIndex < count) {
+			physicalDevice = devices[deviceIndex];
+		}
+		else {
+			for (VkPhysicalDevice candidate : devices) {
+				VkPhysicalDeviceProperties props{};
+				vkGetPhysicalDeviceProperties(candidate, &props);
+				if (!physicalDevice || props.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
+					physicalDevice = candidate;
+					if (props.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+						break;
+				}
+			}
+		}
+		if (!physicalDevice) {
+			SpoutLogError("spoutVKheadless::Create - no Vulkan device");
+			Release();
+			return false;
+		}
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+		// Graphics queue, which also supports transfer and compute
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, nullptr);
+		std::vector<VkQueueFamilyProperties> families(count);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, families.data());
+		queueFamilyIndex = UINT32_MAX;
+		for (uint32_t i = 0; i < count; i++) {
+			if (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+				queueFamilyIndex = i;
+				break;
+			}
+		}
+		if (queueFamilyIndex == UINT32_MAX) {
+			SpoutLogError("spoutVKheadless::Create - no graphics queue");
+			Release();
+			return false;
+		}
+
+		const char* deviceExtensions[] = {
+			"VK_KHR_external_memory",
+			"VK_KHR_external_memory_win32",
+			"VK_KHR_dedicated_allocation",
+			"VK_KHR_get_memory_requirements2"
+		};
+		float priority = 1.0f;
+		VkDeviceQueueCreateInfo queueInfo = { VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
+		queueInfo.queueFamilyIndex = queueFamilyIndex;
+		queueInfo.queueCount = 1;
+		queueInfo.pQueuePriorities = &priority;
+		VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES };
+		VkPhysicalDeviceFeatures2 features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+		features.pNext = &timelineFeatures;
+		if (properties.apiVersion >= VK_API_VERSION_1_2)
+			vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+		VkDeviceCreateInfo deviceInfo = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+		if (timelineFeatures.timelineSemaphore)
+			deviceInfo.pNext = &timelineFeatures;
+		deviceInfo.queueCreateInfoCount = 1;
+		deviceInfo.pQueueCreateInfos = &queueInfo;
+		deviceInfo.enabledExtensionCount = 4;
+		deviceInfo.ppEnabledExtensionNames = deviceExtensions;
+		if (vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device) != VK_SUCCESS) {
+			SpoutLogError("spoutVKheadless::Create - could not create device");
+			device = nullptr;
+			Release();
+			return false;
+		}
+		vkGetDeviceQueue(device, queueFamilyIndex, 0, &queue);
+
+		VkCommandPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = queueFamilyIndex;
+		if (vkCreateCommandPool(device, &poolInfo, nullptr, &m_commandPool) != VK_SUCCESS) {
+			SpoutLogError("spoutVKheadless::Create - could not create command pool");
+			m_commandPool = nullptr;
+			Release();
+			return false;
+		}
+
+		m_commandBuffers.resize(frames);
+		VkCommandBufferAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+		allocInfo.commandPool = m_commandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = frames;
+		vkAllocateCommandBuffers(device, &allocInfo, m_commandBuffers.data());
+
+		m_fences.resize(frames);
+		VkFenceCreateInfo fenceInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+		for (VkFence& fence : m_fences)
+			vkCreateFence(device, &fenceInfo, nullptr, &fence);
+		m_frame = 0;
+
+		if (timelineFeatures.timelineSemaphore) {
+			VkSemaphoreTypeCreateInfo typeInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO };
+			typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+			VkSemaphoreCreateInfo semaphoreInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+			semaphoreInfo.pNext = &typeInfo;
+			if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &timeline) != VK_SUCCESS)
+				timeline = nullptr;
+		}
+		timelineValue = 1;
+
+		SpoutLogNotice("spoutVKheadless::Create - %s", properties.deviceName);
+
+		return true;
+	}
+
+	void Release()
+	{
+		if (device) {
+			vkDeviceWaitIdle(device);
+			for (VkFence fence : m_fences)
+				vkDestroyFence(device, fence, nullptr);
+			if (timeline)
+				vkDestroySemaphore(device, timeline, nullptr);
+			if (m_commandPool)
+				vkDestroyCommandPool(device, m_commandPool, nullptr);
+			vkDestroyDevice(device, nullptr);
+		}
+		if (instance)
+			vkDestroyInstance(instance, nullptr);
+		m_fences.clear();
+		m_commandBuffers.clear();
+		m_commandPool = nullptr;
+		timeline = nullptr;
+		device = nullptr;
+		instance = nullptr;
+		physicalDevice = nullptr;
+		queue = nullptr;
+	}
+
+	// Index of the frame in the ring, for resources used by each frame
+	uint32_t GetFrameIndex()
+	{
+		return m_frame;
+	}
+
+	// Wait for the previous submit of the next frame and begin its command buffer
+	VkCommandBuffer Begin()
+	{
+		vkWaitForFences(device, 1, &m_fences[m_frame], VK_TRUE, UINT64_MAX);
+		vkResetFences(device, 1, &m_fences[m_frame]);
+		VkCommandBuffer commandBuffer = m_commandBuffers[m_frame];
+		vkResetCommandBuffer(commandBuffer, 0);
+		VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+		return commandBuffer;
+	}
+
+	// End and submit the command buffer of the frame.
+	// Wait for completion if bWait is true.
+	bool Submit(bool bWait = false)
+	{
+		VkCommandBuffer commandBuffer = m_commandBuffers[m_frame];
+		vkEndCommandBuffer(commandBuffer);
+		VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		VkTimelineSemaphoreSubmitInfo timelineInfo = { VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO };
+		if (timeline) {
+			timelineInfo.signalSemaphoreValueCount = 1;
+			timelineInfo.pSignalSemaphoreValues = &timelineValue;
+			submitInfo.pNext = &timelineInfo;
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = &timeline;
+		}
+		if (vkQueueSubmit(queue, 1, &submitInfo, m_fences[m_frame]) != VK_SUCCESS)
+			return false;
+		timelineValue++;
+		if (bWait)
+			vkWaitForFences(device, 1, &m_fences[m_frame], VK_TRUE, UINT64_MAX);
+		m_frame = (m_frame + 1) % (uint32_t)m_fences.size();
+		return true;
+	}
+
+	bool CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage,
+		VkImage& image, VkDeviceMemory& memory)
+	{
+		VkImageCreateInfo imageInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = format;
+		imageInfo.extent = { width, height, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = usage;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+			image = nullptr;
+			return false;
+		}
+		VkMemoryRequirements requirements{};
+		vkGetImageMemoryRequirements(device, image, &requirements);
+		VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+		allocInfo.allocationSize = requirements.size;
+		allocInfo.memoryTypeIndex = spoutVK::findMemoryType(physicalDevice,
+			requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		if (allocInfo.memoryTypeIndex == UINT32_MAX
+			|| vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+			vkDestroyImage(device, image, nullptr);
+			image = nullptr;
+			memory = nullptr;
+			return false;
+		}
+		vkBindImageMemory(device, image, memory, 0);
+		return true;
+	}
+
+	// Host visible and coherent buffer, mapped
+	bool CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+		VkBuffer& buffer, VkDeviceMemory& memory, void*& mapped)
+	{
+		VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+		bufferInfo.size = size;
+		bufferInfo.usage = usage;
+		if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+			buffer = nullptr;
+			return false;
+		}
+		VkMemoryRequirements requirements{};
+		vkGetBufferMemoryRequirements(device, buffer, &requirements);
+		VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+		allocInfo.allocationSize = requirements.size;
+		allocInfo.memoryTypeIndex = spoutVK::findMemoryType(physicalDevice, requirements.memoryTypeBits,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		if (allocInfo.memoryTypeIndex == UINT32_MAX
+			|| vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS
+			|| vkBindBufferMemory(device, buffer, memory, 0) != VK_SUCCESS
+			|| vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+			if (memory) vkFreeMemory(device, memory, nullptr);
+			vkDestroyBuffer(device, buffer, nullptr);
+			buffer = nullptr;
+			memory = nullptr;
+			mapped = nullptr;
+			return false;
+		}
+		return true;
+	}
+
+	// Transition an image with all previous work complete,
+	// for images that are set up once
+	void Transition(VkCommandBuffer commandBuffer, VkImage image,
+		VkImageLayout oldLayout, VkImageLayout newLayout)
+	{
+		VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+		barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+private:
+
+	VkCommandPool m_commandPool = nullptr;
+	std::vector<VkCommandBuffer> m_commandBuffers;
+	std::vector<VkFence> m_fences;
+	uint32_t m_frame = 0;
+
+};
+
+// Steady clock time in nanoseconds
+inline int64_t NowNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Nearest rank percentile of the values
+inline double Percentile(std::vector<double> values, double percentile)
+{
+	if (values.empty())
+		return 0.0;
+	std::sort(values.begin(), values.end());
+	size_t index = (size_t)std::ceil(percentile/100.0*values.size());
+	return values[index > 0 ? index - 1 : 0];
+}
+
+#endif
@@ -0,0 +1,349 @@
+//
+// SpoutVKlatency
+//
+// End to end latency probe for spoutVK.
+//
+// The sender writes a frame id and the time of sending into a block of
+// pixels at the top left of the image passed to SendImage. The receiver
+// receives the image with ReceiveImage, copies the block back to host
+// memory and decodes it. The time from sending to decoding is the latency
+// of the pixels themselves, and the ids show frames that were skipped,
+// received more than once or received out of order.
+//
+//	SpoutVKlatency [options]
+//
+//	--width 1920 --height 1080   Sender size
+//	--fps 60                     Sender and receiver frame rate
+//	--seconds 10                 Time measured
+//	--device -1                  Vulkan device index, -1 for the first discrete GPU
+//	--maxlatency 0               Exit with 1 if the 99th percentile latency (msec)
+//	                             is greater. Zero for no limit.
+//	--out results.json           Write the results to a file as well as the console
+//
+// Without "--role", the probe starts itself as a sender process
+// and receives from it, so it can run headless for regression tests.
+// "--role sender" or "--role receiver" runs one side only.
+//
+// Each bit of the 64 bit id and 64 bit time is a cell of 8x8 black or white
+// pixels, 16 cells wide and 8 high, so that the block survives conversion
+// between formats. The time is steady_clock nanoseconds, which is the same
+// for all processes.
+//
+
+#include "SpoutVKheadless.h"
+#include <string>
+#include <vector>
+
+#define PROBE_CELL 8
+#define PROBE_COLUMNS 16
+#define PROBE_ROWS 8
+#define PROBE_WIDTH (PROBE_CELL*PROBE_COLUMNS)
+#define PROBE_HEIGHT (PROBE_CELL*PROBE_ROWS)
+
+struct probeOptions {
+	std::string role;
+	std::string name = "SpoutVKlatency";
+	std::string out;
+	uint32_t width = 1920;
+	uint32_t height = 1080;
+	int fps = 60;
+	double seconds = 10.0;
+	int device = -1;
+	double maxLatency = 0.0;
+};
+
+// Write the id and time into 8 bit pixels with rows of PROBE_WIDTH
+static void EncodeProbe(uint8_t* pixels, uint64_t id, uint64_t time)
+{
+	for (uint32_t y = 0; y < PROBE_HEIGHT; y++) {
+		for (uint32_t x = 0; x < PROBE_WIDTH; x++) {
+			uint32_t bit = (y/PROBE_CELL)*PROBE_COLUMNS + x/PROBE_CELL;
+			uint64_t value = (bit < 64) ? (id >> bit) : (time >> (bit - 64));
+			uint8_t level = (value & 1) ? 255 : 0;
+			uint8_t* pixel = pixels + ((size_t)y*PROBE_WIDTH + x)*4;
+			pixel[0] = pixel[1] = pixel[2] = level;
+			pixel[3] = 255;
+		}
+	}
+}
+
+// Read the centre of each cell. The green channel is in the same place
+// for RGBA and BGRA. Returns false if a cell is neither black nor white.
+static bool DecodeProbe(const uint8_t* pixels, uint64_t& id, uint64_t& time)
+{
+	id = 0;
+	time = 0;
+	for (uint32_t bit = 0; bit < PROBE_COLUMNS*PROBE_ROWS; bit++) {
+		uint32_t x = (bit % PROBE_COLUMNS)*PROBE_CELL + PROBE_CELL/2;
+		uint32_t y = (bit / PROBE_COLUMNS)*PROBE_CELL + PROBE_CELL/2;
+		uint8_t level = pixels[((size_t)y*PROBE_WIDTH + x)*4 + 1];
+		if (level > 64 && level < 192)
+			return false;
+		if (level >= 192) {
+			if (bit < 64)
+				id |= (uint64_t)1 << bit;
+			else
+				time |= (uint64_t)1 << (bit - 64);
+		}
+	}
+	return true;
+}
+
+//
+// Sender
+//
+// The image is cleared and the probe block is copied to it
+// from a mapped buffer for each frame of the ring.
+//
+static int RunSender(const probeOptions& opt, double seconds)
+{
+	spoutVKheadless vk;
+	if (!vk.Create(opt.device))
+		return 1;
+
+	const uint32_t frames = 2;
+	VkImage image = nullptr;
+	VkDeviceMemory memory = nullptr;
+	VkBuffer buffers[frames] {};
+	VkDeviceMemory bufferMemory[frames] {};
+	void* mapped[frames] {};
+	if (!vk.CreateImage(opt.width, opt.height, VK_FORMAT_B8G8R8A8_UNORM,
+		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, image, memory))
+		return 1;
+	for (uint32_t i = 0; i < frames; i++) {
+		if (!vk.CreateBuffer(PROBE_WIDTH*PROBE_HEIGHT*4, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			buffers[i], bufferMemory[i], mapped[i]))
+			return 1;
+	}
+
+	spoutVK sender;
+	sender.SetSenderName(opt.name.c_str());
+
+	uint64_t id = 0;
+	auto start = std::chrono::steady_clock::now();
+	while (std::chrono::steady_clock::now() - start < std::chrono::duration<double>(seconds)) {
+		uint32_t index = vk.GetFrameIndex();
+		VkCommandBuffer commandBuffer = vk.Begin();
+		if (id == 0)
+			vk.Transition(commandBuffer, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+		VkClearColorValue color = { { 0.5f, 0.5f, 0.5f, 1.0f } };
+		VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, &color, 1, &range);
+
+		VkMemoryBarrier barrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		id++;
+		EncodeProbe((uint8_t*)mapped[index], id, (uint64_t)NowNs());
+		VkBufferImageCopy region{};
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageExtent = { PROBE_WIDTH, PROBE_HEIGHT, 1 };
+		vkCmdCopyBufferToImage(commandBuffer, buffers[index], image, VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+
+		sender.SendImage(vk.physicalDevice, vk.device, commandBuffer,
+			image, VK_IMAGE_LAYOUT_GENERAL, opt.width, opt.height, VK_FORMAT_B8G8R8A8_UNORM);
+		if (!vk.Submit())
+			break;
+		if (opt.fps > 0)
+			sender.HoldFps(opt.fps);
+	}
+
+	vkDeviceWaitIdle(vk.device);
+	sender.ReleaseSender();
+	sender.ReleaseVulkanImage(vk.device);
+	for (uint32_t i = 0; i < frames; i++) {
+		vkDestroyBuffer(vk.device, buffers[i], nullptr);
+		vkFreeMemory(vk.device, bufferMemory[i], nullptr);
+	}
+	vkDestroyImage(vk.device, image, nullptr);
+	vkFreeMemory(vk.device, memory, nullptr);
+
+	return 0;
+}
+
+//
+// Receiver
+//
+// Each frame is received to an RGBA8 image of the sender size and the
+// probe block is copied to a mapped buffer. The copy is waited on so
+// that the latency includes the receive but not a later frame.
+//
+static int RunReceiver(const probeOptions& opt)
+{
+	spoutVKheadless vk;
+	if (!vk.Create(opt.device))
+		return 1;
+
+	spoutVK receiver;
+	receiver.SetReceiverName(opt.name.c_str());
+
+	auto start = std::chrono::steady_clock::now();
+	while (!receiver.ReceiveSenderTexture(vk.physicalDevice, vk.device)) {
+		if (std::chrono::steady_clock::now() - start > std::chrono::seconds(10)) {
+			SpoutLogError("SpoutVKlatency - sender %s not found", opt.name.c_str());
+			return 1;
+		}
+		Sleep(10);
+	}
+
+	uint32_t width = receiver.GetSenderWidth();
+	uint32_t height = receiver.GetSenderHeight();
+	if (width < PROBE_WIDTH || height < PROBE_HEIGHT)
+		return 1;
+
+	VkImage image = nullptr;
+	VkDeviceMemory memory = nullptr;
+	VkBuffer buffer = nullptr;
+	VkDeviceMemory bufferMemory = nullptr;
+	void* mapped = nullptr;
+	if (!vk.CreateImage(width, height, VK_FORMAT_R8G8B8A8_UNORM,
+		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, image, memory)
+		|| !vk.CreateBuffer(PROBE_WIDTH*PROBE_HEIGHT*4, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			buffer, bufferMemory, mapped))
+		return 1;
+	VkCommandBuffer commandBuffer = vk.Begin();
+	vk.Transition(commandBuffer, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+	vk.Submit(true);
+
+	std::vector<double> latencies;
+	uint64_t lastId = 0;
+	uint64_t received = 0, duplicated = 0, skipped = 0, outoforder = 0, invalid = 0;
+	start = std::chrono::steady_clock::now();
+	while (std::chrono::steady_clock::now() - start < std::chrono::duration<double>(opt.seconds)) {
+		commandBuffer = vk.Begin();
+		bool bReceived = receiver.ReceiveImage(vk.physicalDevice, vk.device, commandBuffer,
+			image, VK_IMAGE_LAYOUT_GENERAL, VK_FORMAT_R8G8B8A8_UNORM, width, height)
+			&& receiver.IsFrameNew();
+		if (bReceived) {
+			VkMemoryBarrier barrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0, 1, &barrier, 0, nullptr, 0, nullptr);
+			VkBufferImageCopy region{};
+			region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+			region.imageExtent = { PROBE_WIDTH, PROBE_HEIGHT, 1 };
+			vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, buffer, 1, &region);
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+				0, 1, &barrier, 0, nullptr, 0, nullptr);
+		}
+		vk.Submit(true);
+
+		uint64_t id = 0, time = 0;
+		if (bReceived) {
+			int64_t now = NowNs();
+			if (!DecodeProbe((const uint8_t*)mapped, id, time) || id == 0 || (int64_t)time > now) {
+				invalid++;
+			}
+			else {
+				received++;
+				if (id == lastId) {
+					duplicated++;
+				}
+				else if (id < lastId) {
+					outoforder++;
+				}
+				else {
+					if (lastId > 0)
+						skipped += id - lastId - 1;
+					latencies.push_back((double)(now - (int64_t)time)/1000000.0);
+					lastId = id;
+				}
+			}
+		}
+		if (opt.fps > 0)
+			receiver.HoldFps(opt.fps);
+	}
+
+	vkDeviceWaitIdle(vk.device);
+	receiver.ReleaseReceiver();
+	receiver.ReleaseVulkanImage(vk.device);
+	vkDestroyBuffer(vk.device, buffer, nullptr);
+	vkFreeMemory(vk.device, bufferMemory, nullptr);
+	vkDestroyImage(vk.device, image, nullptr);
+	vkFreeMemory(vk.device, memory, nullptr);
+
+	double p99 = Percentile(latencies, 99.0);
+	char json[1024]{};
+	sprintf_s(json, 1024, "{ \"width\": %u, \"height\": %u, \"fps\": %d,\n"
+		"  \"received\": %llu, \"new\": %llu, \"duplicated\": %llu, \"skipped\": %llu, \"outoforder\": %llu, \"invalid\": %llu,\n"
+		"  \"latency_ms\": { \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f } }\n",
+		width, height, opt.fps,
+		(unsigned long long)received, (unsigned long long)latencies.size(),
+		(unsigned long long)duplicated, (unsigned long long)skipped,
+		(unsigned long long)outoforder, (unsigned long long)invalid,
+		Percentile(latencies, 50.0), Percentile(latencies, 90.0), p99, Percentile(latencies, 100.0));
+	printf("%s", json);
+
+	if (!opt.out.empty()) {
+		FILE* file = nullptr;
+		if (fopen_s(&file, opt.out.c_str(), "wb") == 0 && file) {
+			fputs(json, file);
+			fclose(file);
+		}
+	}
+
+	if (latencies.empty() || outoforder > 0)
+		return 1;
+	if (opt.maxLatency > 0.0 && p99 > opt.maxLatency)
+		return 1;
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	probeOptions opt;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string arg = argv[i];
+		std::string value = argv[i + 1];
+		if (arg == "--role")            opt.role = value;
+		else if (arg == "--name")       opt.name = value;
+		else if (arg == "--out")        opt.out = value;
+		else if (arg == "--width")      opt.width = std::max((uint32_t)atoi(value.c_str()), (uint32_t)PROBE_WIDTH);
+		else if (arg == "--height")     opt.height = std::max((uint32_t)atoi(value.c_str()), (uint32_t)PROBE_HEIGHT);
+		else if (arg == "--fps")        opt.fps = atoi(value.c_str());
+		else if (arg == "--seconds")    opt.seconds = atof(value.c_str());
+		else if (arg == "--device")     opt.device = atoi(value.c_str());
+		else if (arg == "--maxlatency") opt.maxLatency = atof(value.c_str());
+		else {
+			printf("Unknown option %s\n", arg.c_str());
+			return 1;
+		}
+	}
+
+	if (opt.role == "sender")
+		return RunSender(opt, opt.seconds);
+	if (opt.role == "receiver")
+		return RunReceiver(opt);
+
+	// Start a sender process that runs longer than the receiver
+	char exePath[MAX_PATH]{};
+	GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+	std::string commandline = "\"" + std::string(exePath) + "\" --role sender"
+		+ " --name " + opt.name
+		+ " --width " + std::to_string(opt.width) + " --height " + std::to_string(opt.height)
+		+ " --fps " + std::to_string(opt.fps)
+		+ " --seconds " + std::to_string(opt.seconds + 5.0)
+		+ " --device " + std::to_string(opt.device);
+	STARTUPINFOA si = { sizeof(STARTUPINFOA) };
+	PROCESS_INFORMATION pi{};
+	std::vector<char> cmd(commandline.begin(), commandline.end());
+	cmd.push_back(0);
+	if (!CreateProcessA(nullptr, cmd.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &si, &pi)) {
+		printf("Could not start the sender\n");
+		return 1;
+	}
+	CloseHandle(pi.hThread);
+
+	int result = RunReceiver(opt);
+
+	TerminateProcess(pi.hProcess, 0);
+	CloseHandle(pi.hProcess);
+	return result;
+}
@@ -128,6 +128,8 @@ public:
 		// Give the sender a name
 		// The executable name is used by default
 		sender.SetSenderName("Vulkan Bloom");
+		// Keep the sender size while the window is being dragged
+		sender.SetResizeDebounce(250);
 
 		// Title bar
 		title += " (Spout sender)";
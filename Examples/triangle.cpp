@@ -158,6 +158,8 @@ public:
 		// Give the sender a name
 		// The executable name is used by default
 		sender.SetSenderName("Vulkan Triangle Sender");
+		// Keep the sender size while the window is being dragged
+		sender.SetResizeDebounce(250);
 		#endif
 
 		// Enable this to see printf and std::cout statements
@@ -967,9 +969,30 @@ public:
 		createDescriptorSets();
 		createPipelines();
 
+		// SPOUT
+		// Record the Spout copy once for each swapchain image
+		// and execute the same command buffer for following frames
+		#ifdef BUILDRECEIVER
+		receiver.EnableCommandCache(device, swapChain.queueNodeIndex);
+		#else
+		sender.EnableCommandCache(device, swapChain.queueNodeIndex);
+		#endif
+
 		prepared = true;
 	}
 
+	// SPOUT
+	// Cached copy commands use the swapchain images
+	// and are recorded again for the new swapchain
+	void windowResized() override
+	{
+		#ifdef BUILDRECEIVER
+		receiver.ClearCommandCache();
+		#else
+		sender.ClearCommandCache();
+		#endif
+	}
+
 	void render() override {
 
 		if (!prepared)